@@ -0,0 +1,163 @@
+#include "assetGenerator.h"
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+#include <string>
+#include "assetTexture.h"
+#include "assetModel.h"
+#include "assetMaterial.h"
+
+using namespace Asset;
+
+namespace
+{
+	//xorshift, the generated files have to be the same on every platform
+	struct Random
+	{
+		uint32_t state;
+
+		explicit Random(uint32_t seed) : state(seed * 2654435761u + 1)
+		{
+
+		}
+
+		uint32_t Next()
+		{
+			state ^= state << 13;
+			state ^= state >> 17;
+			state ^= state << 5;
+			return state;
+		}
+
+		float NextFloat()
+		{
+			return (Next() & 0xFFFFFF) / static_cast<float>(0x1000000);
+		}
+	};
+
+	std::string Numbered(const char* prefix, uint32_t index, const char* extension)
+	{
+		return prefix + std::to_string(index) + extension;
+	}
+
+	Mesh GenerateMesh(uint32_t vertexCount, Random& random)
+	{
+		//a grid of vertices with noisy heights, two triangles per cell
+		const uint32_t side = std::max(2u, static_cast<uint32_t>(std::sqrt(static_cast<double>(vertexCount))));
+
+		Mesh mesh;
+		mesh.vertexBuffer.inputTypes = { VertexDataType::PositionFloat3, VertexDataType::NormalFloat3, VertexDataType::TexCoordFloat2 };
+		mesh.vertexBuffer.interleaved = true;
+
+		std::vector<float> vertices;
+		vertices.reserve(side * side * 8);
+		for (uint32_t y = 0; y < side; ++y)
+		{
+			for (uint32_t x = 0; x < side; ++x)
+			{
+				const float u = x / static_cast<float>(side - 1);
+				const float v = y / static_cast<float>(side - 1);
+				const float height = random.NextFloat() * 0.05f;
+				vertices.insert(vertices.end(), { u, height, v, 0.0f, 1.0f, 0.0f, u, v });
+			}
+		}
+		mesh.vertexBuffer.data.resize(vertices.size() * sizeof(float));
+		memcpy(mesh.vertexBuffer.data.data(), vertices.data(), mesh.vertexBuffer.data.size());
+
+		for (uint32_t y = 0; y + 1 < side; ++y)
+		{
+			for (uint32_t x = 0; x + 1 < side; ++x)
+			{
+				const uint32_t i = y * side + x;
+				mesh.indexBuffer.insert(mesh.indexBuffer.end(), { i, i + side, i + 1, i + 1, i + side, i + side + 1 });
+			}
+		}
+
+		mesh.bounds = BoundingBox{ {0.0f, 0.0f, 0.0f}, {1.0f, 0.05f, 1.0f} };
+		mesh.boundingSphere = BoundingSphere{ {0.5f, 0.025f, 0.5f}, 0.71f };
+		return mesh;
+	}
+}
+
+std::vector<uint8_t> GenerateTexturePixels(uint32_t size, uint32_t seed)
+{
+	Random random(seed);
+	std::vector<uint8_t> pixels(static_cast<size_t>(size) * size * 4);
+	for (uint32_t y = 0; y < size; ++y)
+	{
+		for (uint32_t x = 0; x < size; ++x)
+		{
+			uint8_t* texel = &pixels[(static_cast<size_t>(y) * size + x) * 4];
+			const uint32_t noise = random.Next() & 0xF;
+			texel[0] = static_cast<uint8_t>(x * 255 / size + noise);
+			texel[1] = static_cast<uint8_t>(y * 255 / size + noise);
+			texel[2] = static_cast<uint8_t>((x + y) * 127 / size + noise);
+			texel[3] = 255;
+		}
+	}
+	return pixels;
+}
+
+GeneratedAssets GenerateAssets(const std::filesystem::path& folder, const GeneratorSettings& settings)
+{
+	std::filesystem::create_directories(folder);
+
+	GeneratedAssets assets;
+	for (uint32_t t = 0; t < settings.textureCount; ++t)
+	{
+		std::vector<uint8_t> pixels = GenerateTexturePixels(settings.textureSize, settings.seed + t);
+
+		TextureInfo info;
+		info.textureFormat = TextureFormat::RGBA8;
+		info.pixelsize = { settings.textureSize, settings.textureSize, 1 };
+		info.textureSize = static_cast<int>(pixels.size());
+		info.originalFile = Numbered("texture", t, ".png");
+
+		AssetFile file = PackTexture(&info, pixels.data());
+		assets.textures.push_back(folder / Numbered("texture", t, ".tx"));
+		file.SaveBinaryFile(assets.textures.back().string());
+	}
+
+	for (uint32_t m = 0; m < settings.materialCount; ++m)
+	{
+		MaterialInfo info;
+		info.name = Numbered("material", m, "");
+		info.baseEffect = "default";
+		info.transparency = TransparencyMode::Opaque;
+		if (settings.textureCount > 0)
+			info.textures["baseColor"] = assets.textures[m % settings.textureCount].generic_string();
+		info.floatParamters["shininess"] = 32.0f;
+		info.vec4Paramters["specularColour"] = { 1.0f, 1.0f, 1.0f, 1.0f };
+
+		AssetFile file = PackMaterial(info);
+		assets.materials.push_back(folder / Numbered("material", m, ".mat"));
+		file.SaveBinaryFile(assets.materials.back().string());
+	}
+
+	Random random(settings.seed);
+	for (uint32_t m = 0; m < settings.modelCount; ++m)
+	{
+		ModelInfo info;
+		for (uint32_t mesh = 0; mesh < settings.meshesPerModel; ++mesh)
+		{
+			info.meshes.push_back(GenerateMesh(settings.verticesPerMesh, random));
+			info.meshNames.push_back(Numbered("mesh", mesh, ""));
+			info.meshMaterials.push_back(settings.materialCount > 0 ? assets.materials[(m + mesh) % settings.materialCount].generic_string() : std::string());
+
+			//one node per mesh, all children of the first
+			info.nodeMeshes.push_back(mesh);
+			info.nodeParents.push_back(mesh == 0 ? -1 : 0);
+
+			Mat4x4 transform{};
+			transform[0] = transform[5] = transform[10] = transform[15] = 1.0f;
+			transform[3] = static_cast<float>(mesh);
+			info.transformMatrix.push_back(transform);
+		}
+
+		AssetFile file = PackModel(info);
+		assets.models.push_back(folder / Numbered("model", m, ".modl"));
+		file.SaveBinaryFile(assets.models.back().string());
+	}
+
+	return assets;
+}
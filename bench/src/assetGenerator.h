@@ -0,0 +1,29 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include <filesystem>
+
+//Sizes and counts of the synthetic assets, the same settings always generate the same files
+struct GeneratorSettings
+{
+	uint32_t textureCount = 64;
+	uint32_t textureSize = 512; //Width and height of the RGBA8 textures
+	uint32_t modelCount = 16;
+	uint32_t meshesPerModel = 8;
+	uint32_t verticesPerMesh = 16384;
+	uint32_t materialCount = 64;
+	uint32_t seed = 1;
+};
+
+struct GeneratedAssets
+{
+	std::vector<std::filesystem::path> textures;
+	std::vector<std::filesystem::path> models;
+	std::vector<std::filesystem::path> materials;
+};
+
+//Smooth gradients with some noise, compresses about as well as real albedo maps
+std::vector<uint8_t> GenerateTexturePixels(uint32_t size, uint32_t seed);
+
+//Writes the assets with PackTexture, PackModel and PackMaterial into folder (created if missing), materials use the textures and models the materials
+GeneratedAssets GenerateAssets(const std::filesystem::path& folder, const GeneratorSettings& settings);
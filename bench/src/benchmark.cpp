@@ -0,0 +1,234 @@
+#include "benchmark.h"
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+#include <numeric>
+#include "assetFile.h"
+
+#if __has_include(<fcntl.h>) && __has_include(<unistd.h>)
+#include <fcntl.h>
+#include <unistd.h>
+#ifdef POSIX_FADV_DONTNEED
+#define JAAM_FADVISE
+#endif
+#endif
+
+namespace
+{
+	double Median(std::vector<double> values)
+	{
+		if (values.empty())
+			return 0.0;
+
+		std::sort(values.begin(), values.end());
+		const size_t middle = values.size() / 2;
+		return values.size() % 2 ? values[middle] : (values[middle - 1] + values[middle]) * 0.5;
+	}
+
+	double Mean(const std::vector<double>& values)
+	{
+		return values.empty() ? 0.0 : std::accumulate(values.begin(), values.end(), 0.0) / values.size();
+	}
+
+	//an asset is its binary file and the json next to it
+	std::vector<std::filesystem::path> AssetFiles(const std::vector<std::filesystem::path>& files)
+	{
+		std::vector<std::filesystem::path> assetFiles;
+		for (const auto& file : files)
+		{
+			assetFiles.push_back(file);
+			assetFiles.push_back(Asset::AssetFile::MetaPath(file.string()));
+		}
+		return assetFiles;
+	}
+}
+
+BenchmarkRunner::BenchmarkRunner(uint32_t iterations) : m_iterations(std::max(1u, iterations))
+{
+
+}
+
+void BenchmarkRunner::SetFilter(const std::string& filter)
+{
+	m_filter = filter;
+}
+
+BenchmarkResult* BenchmarkRunner::Run(const std::string& name, CacheMode cache, uint64_t items, uint64_t bytes, const std::function<void()>& prepare, const std::function<void()>& body)
+{
+	if (name.find(m_filter) == std::string::npos)
+		return nullptr;
+
+	BenchmarkResult result{ name, cache, items, bytes, {}, {} };
+	for (uint32_t i = 0; i < m_iterations; ++i)
+	{
+		if (prepare)
+			prepare();
+
+		const auto start = std::chrono::steady_clock::now();
+		body();
+		const auto end = std::chrono::steady_clock::now();
+		result.milliseconds.push_back(std::chrono::duration<double, std::milli>(end - start).count());
+	}
+	return Record(std::move(result));
+}
+
+BenchmarkResult* BenchmarkRunner::RunTimed(const std::string& name, CacheMode cache, uint64_t items, uint64_t bytes, const std::function<double()>& body)
+{
+	if (name.find(m_filter) == std::string::npos)
+		return nullptr;
+
+	BenchmarkResult result{ name, cache, items, bytes, {}, {} };
+	for (uint32_t i = 0; i < m_iterations; ++i)
+		result.milliseconds.push_back(body());
+	return Record(std::move(result));
+}
+
+BenchmarkResult* BenchmarkRunner::Record(BenchmarkResult result)
+{
+	std::cout << std::left << std::setw(40) << result.name << std::setw(8) << CacheModeName(result.cache) << std::right << std::fixed << std::setprecision(3)
+		<< std::setw(12) << Median(result.milliseconds) << " ms" << std::defaultfloat << std::endl;
+
+	m_results.push_back(std::move(result));
+	return &m_results.back();
+}
+
+BenchmarkResult* BenchmarkRunner::RunFiles(const std::string& name, CacheMode cache, const std::vector<std::filesystem::path>& files, const std::function<void()>& prepare, const std::function<void()>& body)
+{
+	if (name.find(m_filter) == std::string::npos)
+		return nullptr;
+
+	const std::vector<std::filesystem::path> assetFiles = AssetFiles(files);
+
+	uint64_t bytes = 0;
+	std::error_code error;
+	for (const auto& file : assetFiles)
+		bytes += std::filesystem::file_size(file, error);
+
+	if (cache == CacheMode::Cold && !assetFiles.empty() && !DropFileCache(assetFiles.front()))
+	{
+		std::cout << name << " cold: dropping cached files is not supported here, skipped" << std::endl;
+		return nullptr;
+	}
+
+	return Run(name, cache, files.size(), bytes, [&]()
+		{
+			for (const auto& file : assetFiles)
+			{
+				if (cache == CacheMode::Cold)
+					DropFileCache(file);
+				else if (cache == CacheMode::Warm)
+					TouchFile(file);
+			}
+
+			if (prepare)
+				prepare();
+		}, body);
+}
+
+void BenchmarkRunner::PrintSummary() const
+{
+	std::cout << std::fixed << std::setprecision(2);
+	std::cout << std::left << std::setw(40) << "benchmark" << std::setw(8) << "cache" << std::right
+		<< std::setw(12) << "median ms" << std::setw(12) << "min ms" << std::setw(12) << "MB/s" << std::setw(14) << "items/s" << "\n";
+
+	for (const BenchmarkResult& result : m_results)
+	{
+		const double median = Median(result.milliseconds);
+		const double seconds = median / 1000.0;
+		std::cout << std::left << std::setw(40) << result.name << std::setw(8) << CacheModeName(result.cache) << std::right
+			<< std::setw(12) << median
+			<< std::setw(12) << *std::min_element(result.milliseconds.begin(), result.milliseconds.end())
+			<< std::setw(12) << (seconds > 0.0 ? result.bytes / (1024.0 * 1024.0) / seconds : 0.0)
+			<< std::setw(14) << (seconds > 0.0 ? result.items / seconds : 0.0);
+		for (const auto& [metric, value] : result.metrics)
+			std::cout << "  " << metric << "=" << value;
+		std::cout << "\n";
+	}
+	std::cout << std::defaultfloat;
+}
+
+bool BenchmarkRunner::WriteJson(const std::filesystem::path& path, const nlohmann::json& config) const
+{
+	nlohmann::json results = nlohmann::json::array();
+	for (const BenchmarkResult& result : m_results)
+	{
+		const double median = Median(result.milliseconds);
+		const double seconds = median / 1000.0;
+
+		nlohmann::json entry;
+		entry["name"] = result.name;
+		entry["cache"] = CacheModeName(result.cache);
+		entry["iterations"] = result.milliseconds.size();
+		entry["items"] = result.items;
+		entry["bytes"] = result.bytes;
+		entry["min_ms"] = *std::min_element(result.milliseconds.begin(), result.milliseconds.end());
+		entry["median_ms"] = median;
+		entry["mean_ms"] = Mean(result.milliseconds);
+		entry["max_ms"] = *std::max_element(result.milliseconds.begin(), result.milliseconds.end());
+		entry["mb_per_s"] = seconds > 0.0 ? result.bytes / (1024.0 * 1024.0) / seconds : 0.0;
+		entry["items_per_s"] = seconds > 0.0 ? result.items / seconds : 0.0;
+		entry["samples_ms"] = result.milliseconds;
+		for (const auto& [metric, value] : result.metrics)
+			entry[metric] = value;
+		results.push_back(entry);
+	}
+
+	nlohmann::json report;
+	report["version"] = 1;
+	report["config"] = config;
+	report["results"] = results;
+
+	std::ofstream file(path, std::ios::out);
+	if (!file.is_open())
+		return false;
+
+	file << report.dump(1, '\t');
+	return true;
+}
+
+bool DropFileCache(const std::filesystem::path& path)
+{
+#ifdef JAAM_FADVISE
+	const int fd = open(path.c_str(), O_RDONLY);
+	if (fd < 0)
+		return false;
+
+	//only clean pages are dropped, anything still being written back is flushed first
+	fdatasync(fd);
+	const bool dropped = posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED) == 0;
+	close(fd);
+	return dropped;
+#else
+	(void)path;
+	return false;
+#endif
+}
+
+void TouchFile(const std::filesystem::path& path)
+{
+	std::ifstream file(path, std::ios::binary);
+	char buffer[64 * 1024];
+	while (file.read(buffer, sizeof(buffer)) || file.gcount() > 0)
+	{
+	}
+}
+
+const char* CacheModeName(CacheMode cache)
+{
+	switch (cache)
+	{
+	case CacheMode::Warm:
+		return "warm";
+	case CacheMode::Cold:
+		return "cold";
+	default:
+		return "memory";
+	}
+}
+
+double MedianMilliseconds(const BenchmarkResult& result)
+{
+	return Median(result.milliseconds);
+}
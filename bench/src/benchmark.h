@@ -0,0 +1,64 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <map>
+#include <deque>
+#include <functional>
+#include <filesystem>
+#include "nlohmann/json.hpp"
+
+//Where the data a benchmark reads comes from
+enum class CacheMode
+{
+	Memory, //Already in memory, no file access
+	Warm, //Files read once before each iteration so they are in the page cache
+	Cold //Files dropped from the page cache before each iteration
+};
+
+struct BenchmarkResult
+{
+	std::string name;
+	CacheMode cache;
+	uint64_t items; //Assets or buffers handled per iteration
+	uint64_t bytes; //Bytes handled per iteration
+	std::vector<double> milliseconds; //One per iteration
+	std::map<std::string, double> metrics; //Anything else worth tracking, e.g. compression ratio
+};
+
+/// <summary>
+/// Times benchmarks over a number of iterations and keeps every result for the summary and the json report.
+/// prepare runs untimed before each iteration, body is what is timed
+/// </summary>
+class BenchmarkRunner
+{
+public:
+	explicit BenchmarkRunner(uint32_t iterations);
+
+	//Only benchmarks whose name contains filter are run, the others return nullptr
+	void SetFilter(const std::string& filter);
+
+	BenchmarkResult* Run(const std::string& name, CacheMode cache, uint64_t items, uint64_t bytes, const std::function<void()>& prepare, const std::function<void()>& body);
+	//For benchmarks that time only parts of their work, body returns the milliseconds of one iteration
+	BenchmarkResult* RunTimed(const std::string& name, CacheMode cache, uint64_t items, uint64_t bytes, const std::function<double()>& body);
+	//Gets files into the state cache asks for before each prepare, bytes is their size on disk. Also nullptr if the platform can't drop cached files
+	BenchmarkResult* RunFiles(const std::string& name, CacheMode cache, const std::vector<std::filesystem::path>& files, const std::function<void()>& prepare, const std::function<void()>& body);
+
+	void PrintSummary() const;
+	//Every result with min, median, mean and max time and the throughput at the median
+	bool WriteJson(const std::filesystem::path& path, const nlohmann::json& config) const;
+private:
+	BenchmarkResult* Record(BenchmarkResult result);
+
+	uint32_t m_iterations;
+	std::string m_filter;
+	std::deque<BenchmarkResult> m_results; //Results are handed out by pointer
+};
+
+//Removes a file from the OS page cache, false where that is not possible
+bool DropFileCache(const std::filesystem::path& path);
+//Reads a file so it is in the OS page cache
+void TouchFile(const std::filesystem::path& path);
+
+const char* CacheModeName(CacheMode cache);
+double MedianMilliseconds(const BenchmarkResult& result);
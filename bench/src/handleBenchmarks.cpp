@@ -0,0 +1,200 @@
+#include "handleBenchmarks.h"
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <numeric>
+#include <algorithm>
+#include <iostream>
+#include "jaam.h"
+
+using namespace Asset;
+
+namespace
+{
+	enum class HandleOp
+	{
+		Copy,
+		Move,
+		Destroy,
+		Get,
+		GetUserData
+	};
+
+	struct HandleUserData
+	{
+		uint64_t value = 0;
+	};
+
+	using HandleManager = AssetManager<MaterialInfo, HandleUserData>;
+
+	//Handles are constructed in place so copies, moves and destroys can be timed apart
+	struct alignas(AssetHandle) HandleSlot
+	{
+		unsigned char bytes[sizeof(AssetHandle)];
+
+		AssetHandle* Get()
+		{
+			return reinterpret_cast<AssetHandle*>(bytes);
+		}
+	};
+
+	//refcounts are 16 bit, the copies every thread holds at once have to fit
+	constexpr uint32_t MaxBatchSize = 1024;
+	constexpr uint32_t MaxOutstandingReferences = 60000;
+
+	std::atomic<uint64_t> sink = 0;
+
+	const char* HandleOpName(HandleOp op)
+	{
+		switch (op)
+		{
+		case HandleOp::Copy:
+			return "Copy";
+		case HandleOp::Move:
+			return "Move";
+		case HandleOp::Destroy:
+			return "Destroy";
+		case HandleOp::Get:
+			return "Get";
+		default:
+			return "GetUserData";
+		}
+	}
+
+	//Runs the op batch handles at a time, the handles are copied from source and destroyed around it untimed.
+	//Returns the milliseconds spent in the op
+	double RunHandleThread(HandleOp op, HandleManager& manager, const AssetHandle& source, uint32_t batch, uint32_t batches, std::atomic<uint32_t>& ready, uint32_t threads)
+	{
+		std::vector<HandleSlot> handles(batch);
+		std::vector<HandleSlot> moved(batch);
+		uint64_t found = 0;
+
+		//every thread starts at once so they contend for the whole run
+		ready++;
+		while (ready < threads)
+			std::this_thread::yield();
+
+		std::chrono::steady_clock::duration timed{};
+		for (uint32_t b = 0; b < batches; ++b)
+		{
+			auto start = std::chrono::steady_clock::now();
+			for (uint32_t i = 0; i < batch; ++i)
+				new (handles[i].Get()) AssetHandle(source);
+			if (op == HandleOp::Copy)
+				timed += std::chrono::steady_clock::now() - start;
+
+			start = std::chrono::steady_clock::now();
+			switch (op)
+			{
+			case HandleOp::Move:
+				for (uint32_t i = 0; i < batch; ++i)
+					new (moved[i].Get()) AssetHandle(std::move(*handles[i].Get()));
+				timed += std::chrono::steady_clock::now() - start;
+
+				for (uint32_t i = 0; i < batch; ++i)
+					moved[i].Get()->~AssetHandle();
+				break;
+			case HandleOp::Get:
+				for (uint32_t i = 0; i < batch; ++i)
+					found += manager.Get(*handles[i].Get()) != nullptr;
+				timed += std::chrono::steady_clock::now() - start;
+				break;
+			case HandleOp::GetUserData:
+				for (uint32_t i = 0; i < batch; ++i)
+					found += manager.GetUserData(*handles[i].Get()) != nullptr;
+				timed += std::chrono::steady_clock::now() - start;
+				break;
+			default:
+				break;
+			}
+
+			start = std::chrono::steady_clock::now();
+			for (uint32_t i = 0; i < batch; ++i)
+				handles[i].Get()->~AssetHandle();
+			if (op == HandleOp::Destroy)
+				timed += std::chrono::steady_clock::now() - start;
+		}
+
+		sink += found;
+		return std::chrono::duration<double, std::milli>(timed).count();
+	}
+
+	std::vector<uint32_t> ThreadCounts(uint32_t maxThreads)
+	{
+		std::vector<uint32_t> counts;
+		for (uint32_t threads = 1; threads < maxThreads; threads *= 2)
+			counts.push_back(threads);
+		counts.push_back(maxThreads);
+		return counts;
+	}
+}
+
+void BenchmarkHandles(BenchmarkRunner& runner, const std::vector<std::filesystem::path>& materials, uint32_t maxThreads, uint32_t opsPerThread)
+{
+	maxThreads = std::max(1u, maxThreads);
+
+	//one asset per thread for the disjoint runs, threads share assets when there are fewer
+	HandleManager manager;
+	std::vector<AssetHandle> handles;
+	handles.reserve(maxThreads);
+	for (size_t i = 0; i < materials.size() && handles.size() < maxThreads; ++i)
+	{
+		AssetHandle handle = manager.Load(materials[i].string());
+		if (handle.IsValid())
+			handles.push_back(handle);
+	}
+
+	if (handles.empty())
+	{
+		std::cout << "handle benchmarks need at least one material, skipped" << std::endl;
+		return;
+	}
+
+	const uint32_t batch = std::max(1u, std::min(MaxBatchSize, MaxOutstandingReferences / maxThreads));
+	const uint32_t batches = std::max(1u, (opsPerThread + batch - 1) / batch);
+	const uint64_t threadOps = static_cast<uint64_t>(batch) * batches;
+
+	for (HandleOp op : { HandleOp::Copy, HandleOp::Move, HandleOp::Destroy, HandleOp::Get, HandleOp::GetUserData })
+	{
+		for (bool shared : { true, false })
+		{
+			double singleThreadNs = 0.0;
+			for (uint32_t threads : ThreadCounts(maxThreads))
+			{
+				const std::string name = std::string("AssetHandle::") + HandleOpName(op) + (shared ? "/shared/" : "/disjoint/") + std::to_string(threads) + "t";
+
+				//the time of an iteration is the mean time a thread spent in the op
+				BenchmarkResult* result = runner.RunTimed(name, CacheMode::Memory, threadOps * threads, 0, [&]()
+					{
+						std::atomic<uint32_t> ready = 0;
+						std::vector<double> milliseconds(threads);
+						std::vector<std::thread> workers;
+						for (uint32_t t = 0; t < threads; ++t)
+						{
+							const AssetHandle& source = handles[shared ? 0 : t % handles.size()];
+							workers.emplace_back([&, t]()
+								{
+									milliseconds[t] = RunHandleThread(op, manager, source, batch, batches, ready, threads);
+								});
+						}
+						for (std::thread& worker : workers)
+							worker.join();
+
+						return std::accumulate(milliseconds.begin(), milliseconds.end(), 0.0) / threads;
+					});
+				if (!result)
+					continue;
+
+				const double nsPerOp = MedianMilliseconds(*result) * 1e6 / threadOps;
+				if (threads == 1)
+					singleThreadNs = nsPerOp;
+
+				result->metrics["threads"] = threads;
+				result->metrics["assets"] = static_cast<double>(shared ? 1 : std::min<size_t>(threads, handles.size()));
+				result->metrics["ns_per_op"] = nsPerOp;
+				if (singleThreadNs > 0.0 && nsPerOp > 0.0)
+					result->metrics["scaling_efficiency"] = singleThreadNs / nsPerOp;
+			}
+		}
+	}
+}
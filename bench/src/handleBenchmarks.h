@@ -0,0 +1,10 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include <filesystem>
+#include "benchmark.h"
+
+//AssetHandle copy, move and destroy and AssetManager Get and GetUserData from 1 to maxThreads threads. Every thread either works on
+//handles of the same asset (shared) or of its own asset (disjoint). Reports ns/op per thread and the scaling efficiency, the
+//ns/op of one thread over the ns/op at the thread count (1 = no slowdown from the other threads)
+void BenchmarkHandles(BenchmarkRunner& runner, const std::vector<std::filesystem::path>& materials, uint32_t maxThreads, uint32_t opsPerThread);
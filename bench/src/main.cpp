@@ -0,0 +1,322 @@
+#include <iostream>
+#include <chrono>
+#include <string>
+#include <memory>
+#include <thread>
+#include <algorithm>
+#include "jaam.h"
+#include "assetGenerator.h"
+#include "benchmark.h"
+#include "handleBenchmarks.h"
+
+using namespace Asset;
+
+namespace
+{
+	//results are summed into it so the timed work can't be optimized away
+	volatile uint64_t sink = 0;
+
+	//Get is too fast to time once per handle
+	constexpr uint32_t GetRounds = 100;
+
+	struct BenchSettings
+	{
+		GeneratorSettings generator;
+		uint32_t iterations = 5;
+		uint32_t bufferMB = 64; //Payload of the codec benchmarks
+		std::filesystem::path assetFolder = "jaam_bench_assets";
+		std::filesystem::path jsonPath = "jaam_bench.json";
+		std::vector<CacheMode> fileModes = { CacheMode::Warm, CacheMode::Cold };
+		std::string filter;
+		uint32_t threads = std::max(1u, std::thread::hardware_concurrency()); //Most threads of the handle benchmarks
+		uint32_t handleOps = 1 << 20; //Handle operations per thread
+	};
+
+	bool ParseUInt(const std::string& value, uint32_t& out)
+	{
+		try
+		{
+			out = static_cast<uint32_t>(std::stoul(value));
+			return true;
+		}
+		catch (...)
+		{
+			return false;
+		}
+	}
+
+	bool ParseBenchSettings(int argc, char** argv, BenchSettings& settings)
+	{
+		for (int i = 1; i < argc; ++i)
+		{
+			std::string arg = argv[i];
+			std::string value;
+
+			size_t split = arg.find('=');
+			if (split != std::string::npos)
+			{
+				value = arg.substr(split + 1);
+				arg = arg.substr(0, split);
+			}
+
+			bool valid = true;
+			if (arg == "--textures")
+				valid = ParseUInt(value, settings.generator.textureCount);
+			else if (arg == "--texture-size")
+				valid = ParseUInt(value, settings.generator.textureSize) && settings.generator.textureSize > 0;
+			else if (arg == "--models")
+				valid = ParseUInt(value, settings.generator.modelCount);
+			else if (arg == "--meshes")
+				valid = ParseUInt(value, settings.generator.meshesPerModel);
+			else if (arg == "--vertices")
+				valid = ParseUInt(value, settings.generator.verticesPerMesh);
+			else if (arg == "--materials")
+				valid = ParseUInt(value, settings.generator.materialCount);
+			else if (arg == "--seed")
+				valid = ParseUInt(value, settings.generator.seed);
+			else if (arg == "--iterations")
+				valid = ParseUInt(value, settings.iterations);
+			else if (arg == "--buffer-size")
+				valid = ParseUInt(value, settings.bufferMB) && settings.bufferMB > 0;
+			else if (arg == "--threads")
+				valid = ParseUInt(value, settings.threads) && settings.threads > 0;
+			else if (arg == "--handle-ops")
+				valid = ParseUInt(value, settings.handleOps) && settings.handleOps > 0;
+			else if (arg == "--assets")
+				settings.assetFolder = value;
+			else if (arg == "--json")
+				settings.jsonPath = value;
+			else if (arg == "--filter")
+				settings.filter = value;
+			else if (arg == "--cache")
+			{
+				valid = value == "warm" || value == "cold" || value == "both";
+				if (value == "warm")
+					settings.fileModes = { CacheMode::Warm };
+				else if (value == "cold")
+					settings.fileModes = { CacheMode::Cold };
+			}
+			else
+			{
+				std::cout << "Unknown option " << argv[i] << std::endl;
+				return false;
+			}
+
+			if (!valid || value.empty())
+			{
+				std::cout << "Invalid value for option " << argv[i] << std::endl;
+				return false;
+			}
+		}
+		return true;
+	}
+
+	void PrintBenchUsage()
+	{
+		std::cout << "usage: JAAMBench [options]\n"
+			<< "  --textures=N          synthetic RGBA8 textures (default 64)\n"
+			<< "  --texture-size=N      texture width and height (default 512)\n"
+			<< "  --models=N            synthetic models (default 16)\n"
+			<< "  --meshes=N            meshes per model (default 8)\n"
+			<< "  --vertices=N          vertices per mesh (default 16384)\n"
+			<< "  --materials=N         synthetic materials (default 64)\n"
+			<< "  --seed=N              generator seed (default 1)\n"
+			<< "  --iterations=N        timed iterations of every benchmark (default 5)\n"
+			<< "  --buffer-size=MB      payload of the Buffer codec benchmarks (default 64)\n"
+			<< "  --cache=warm|cold|both  page cache state of the file benchmarks (default both)\n"
+			<< "  --threads=N           most threads of the AssetHandle benchmarks (default hardware threads)\n"
+			<< "  --handle-ops=N        AssetHandle operations per thread (default 1048576)\n"
+			<< "  --filter=TEXT         only run benchmarks whose name contains TEXT\n"
+			<< "  --assets=DIR          folder the synthetic assets are written to (default jaam_bench_assets)\n"
+			<< "  --json=FILE           results report (default jaam_bench.json)\n";
+	}
+
+	const char* CompressionName(CompressionMode mode)
+	{
+		switch (mode)
+		{
+		case CompressionMode::LZ4:
+			return "LZ4";
+		case CompressionMode::LZ4Chunked:
+			return "LZ4Chunked";
+		default:
+			return "None";
+		}
+	}
+
+	void BenchmarkLoadBinaryFile(BenchmarkRunner& runner, const std::string& kind, const std::vector<std::filesystem::path>& files, const BenchSettings& settings)
+	{
+		for (CacheMode cache : settings.fileModes)
+		{
+			runner.RunFiles("LoadBinaryFile/" + kind, cache, files, nullptr, [&]()
+				{
+					for (const auto& path : files)
+					{
+						AssetFile file;
+						sink = sink + file.LoadBinaryFile(path.string());
+					}
+				});
+		}
+	}
+
+	void BenchmarkCodecs(BenchmarkRunner& runner, const BenchSettings& settings)
+	{
+		//texture data, what most of the bytes on disk are
+		const size_t payloadSize = static_cast<size_t>(settings.bufferMB) * 1024 * 1024;
+		std::vector<uint8_t> payload;
+		payload.reserve(payloadSize);
+		for (uint32_t seed = settings.generator.seed; payload.size() < payloadSize; ++seed)
+		{
+			const std::vector<uint8_t> pixels = GenerateTexturePixels(1024, seed);
+			payload.insert(payload.end(), pixels.begin(), pixels.begin() + std::min(pixels.size(), payloadSize - payload.size()));
+		}
+
+		std::vector<uint8_t> decoded(payload.size());
+		for (CompressionMode mode : { CompressionMode::None, CompressionMode::LZ4, CompressionMode::LZ4Chunked })
+		{
+			const std::string codec = CompressionName(mode);
+
+			Buffer buffer;
+			if (BenchmarkResult* result = runner.Run("Buffer::CopyFrom/" + codec, CacheMode::Memory, 1, payload.size(), nullptr, [&]()
+				{
+					buffer.CopyFrom(payload.data(), payload.size(), mode);
+				}))
+			{
+				result->metrics["compression_ratio"] = static_cast<double>(payload.size()) / buffer.SerializedSize();
+			}
+
+			//decoding needs an encoded buffer even when only CopyTo is run
+			buffer.CopyFrom(payload.data(), payload.size(), mode);
+			runner.Run("Buffer::CopyTo/" + codec, CacheMode::Memory, 1, payload.size(), nullptr, [&]()
+				{
+					buffer.CopyTo(decoded.data());
+				});
+		}
+	}
+
+	template <typename T, typename Read>
+	void BenchmarkReader(BenchmarkRunner& runner, const std::string& name, const std::vector<std::filesystem::path>& paths, Read read)
+	{
+		std::vector<AssetFile> files(paths.size());
+		uint64_t bytes = 0;
+		for (size_t i = 0; i < paths.size(); ++i)
+		{
+			files[i].LoadBinaryFile(paths[i].string());
+			bytes += files[i].json.size() + files[i].binaryBlob.TotalBufferSize();
+		}
+
+		runner.Run(name, CacheMode::Memory, files.size(), bytes, nullptr, [&]()
+			{
+				for (const AssetFile& file : files)
+				{
+					const T info = read(file);
+					sink = sink + reinterpret_cast<uintptr_t>(&info);
+				}
+			});
+	}
+
+	template <typename T>
+	void BenchmarkAssetManager(BenchmarkRunner& runner, const std::string& kind, const std::vector<std::filesystem::path>& files, const BenchSettings& settings)
+	{
+		//handles reference the manager, they are cleared before it is replaced
+		std::unique_ptr<AssetManager<T, EmptyUserData>> manager;
+		std::vector<AssetHandle> handles;
+		auto reset = [&]()
+			{
+				handles.clear();
+				manager = std::make_unique<AssetManager<T, EmptyUserData>>();
+				handles.reserve(files.size());
+			};
+		auto loadAll = [&]()
+			{
+				for (const auto& path : files)
+					handles.push_back(manager->Load(path.string()));
+			};
+
+		for (CacheMode cache : settings.fileModes)
+			runner.RunFiles("AssetManager::Load/" + kind, cache, files, reset, loadAll);
+
+		reset();
+		loadAll();
+		runner.Run("AssetManager::Get/" + kind, CacheMode::Memory, files.size() * GetRounds, 0, nullptr, [&]()
+			{
+				for (uint32_t round = 0; round < GetRounds; ++round)
+				{
+					for (const AssetHandle& handle : handles)
+						sink = sink + (manager->Get(handle) != nullptr);
+				}
+			});
+
+		//the last reference going away releases the asset
+		runner.Run("AssetManager::Release/" + kind, CacheMode::Memory, files.size(), 0, [&]()
+			{
+				reset();
+				loadAll();
+			}, [&]()
+			{
+				handles.clear();
+			});
+
+		handles.clear();
+		manager.reset();
+	}
+}
+
+int main(int argc, char** argv)
+{
+	BenchSettings settings;
+	if (!ParseBenchSettings(argc, argv, settings))
+	{
+		PrintBenchUsage();
+		return 1;
+	}
+
+	const auto generateStart = std::chrono::steady_clock::now();
+	const GeneratedAssets assets = GenerateAssets(settings.assetFolder, settings.generator);
+	const auto generateTime = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - generateStart);
+	std::cout << "generated " << assets.textures.size() << " textures, " << assets.models.size() << " models and " << assets.materials.size()
+		<< " materials in " << generateTime.count() << "ms\n";
+
+	BenchmarkRunner runner(settings.iterations);
+	runner.SetFilter(settings.filter);
+
+	BenchmarkLoadBinaryFile(runner, "texture", assets.textures, settings);
+	BenchmarkLoadBinaryFile(runner, "model", assets.models, settings);
+	BenchmarkLoadBinaryFile(runner, "material", assets.materials, settings);
+
+	BenchmarkCodecs(runner, settings);
+
+	BenchmarkReader<TextureInfo>(runner, "ReadTextureInfo", assets.textures, [](const AssetFile& file) { return ReadTextureInfo(file); });
+	BenchmarkReader<ModelInfo>(runner, "ReadModelInfo", assets.models, ReadModelInfo);
+	BenchmarkReader<MaterialInfo>(runner, "ReadMaterialInfo", assets.materials, ReadMaterialInfo);
+
+	BenchmarkAssetManager<TextureInfo>(runner, "texture", assets.textures, settings);
+	BenchmarkAssetManager<ModelInfo>(runner, "model", assets.models, settings);
+	BenchmarkAssetManager<MaterialInfo>(runner, "material", assets.materials, settings);
+
+	BenchmarkHandles(runner, assets.materials, settings.threads, settings.handleOps);
+
+	runner.PrintSummary();
+
+	nlohmann::json config;
+	config["textures"] = settings.generator.textureCount;
+	config["texture_size"] = settings.generator.textureSize;
+	config["models"] = settings.generator.modelCount;
+	config["meshes_per_model"] = settings.generator.meshesPerModel;
+	config["vertices_per_mesh"] = settings.generator.verticesPerMesh;
+	config["materials"] = settings.generator.materialCount;
+	config["seed"] = settings.generator.seed;
+	config["iterations"] = settings.iterations;
+	config["buffer_mb"] = settings.bufferMB;
+	config["threads"] = settings.threads;
+	config["handle_ops"] = settings.handleOps;
+	config["filter"] = settings.filter;
+
+	if (!runner.WriteJson(settings.jsonPath, config))
+	{
+		std::cout << "could not write " << settings.jsonPath << std::endl;
+		return 1;
+	}
+	std::cout << "results written to " << settings.jsonPath << std::endl;
+	return 0;
+}
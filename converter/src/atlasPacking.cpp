@@ -0,0 +1,152 @@
+#include "atlasPacking.h"
+#include <algorithm>
+#include <limits>
+#include <numeric>
+
+namespace
+{
+	struct SkylineSegment
+	{
+		uint32_t x;
+		uint32_t y;
+		uint32_t width;
+	};
+
+	class Skyline
+	{
+	public:
+		Skyline(uint32_t width, uint32_t height) : m_width(width), m_height(height)
+		{
+			m_segments.push_back({ 0, 0, width });
+		}
+
+		//Lowest position the rect fits at, ties go to the leftmost
+		bool Insert(uint32_t width, uint32_t height, uint32_t& x, uint32_t& y)
+		{
+			uint32_t bestY = std::numeric_limits<uint32_t>::max();
+			size_t bestSegment = 0;
+
+			for (size_t i = 0; i < m_segments.size(); ++i)
+			{
+				uint32_t fitY;
+				if (Fits(i, width, height, fitY) && fitY < bestY)
+				{
+					bestY = fitY;
+					bestSegment = i;
+				}
+			}
+
+			if (bestY == std::numeric_limits<uint32_t>::max())
+				return false;
+
+			x = m_segments[bestSegment].x;
+			y = bestY;
+			AddLevel(bestSegment, x, y + height, width);
+			return true;
+		}
+
+	private:
+		bool Fits(size_t segment, uint32_t width, uint32_t height, uint32_t& y) const
+		{
+			const uint32_t x = m_segments[segment].x;
+			if (x + width > m_width)
+				return false;
+
+			//the rect rests on the highest segment it spans
+			y = 0;
+			uint32_t remaining = width;
+			for (size_t i = segment; remaining > 0; ++i)
+			{
+				if (i >= m_segments.size())
+					return false;
+
+				y = std::max(y, m_segments[i].y);
+				remaining -= std::min(remaining, m_segments[i].width);
+			}
+			return y + height <= m_height;
+		}
+
+		void AddLevel(size_t segment, uint32_t x, uint32_t y, uint32_t width)
+		{
+			m_segments.insert(m_segments.begin() + segment, { x, y, width });
+
+			//trim or remove the segments now covered by the new one
+			for (size_t i = segment + 1; i < m_segments.size(); )
+			{
+				SkylineSegment& next = m_segments[i];
+				const uint32_t end = x + width;
+				if (next.x >= end)
+					break;
+
+				const uint32_t shrink = end - next.x;
+				if (shrink >= next.width)
+				{
+					m_segments.erase(m_segments.begin() + i);
+					continue;
+				}
+
+				next.x += shrink;
+				next.width -= shrink;
+				break;
+			}
+
+			//merge neighbours at the same height
+			for (size_t i = 0; i + 1 < m_segments.size(); )
+			{
+				if (m_segments[i].y == m_segments[i + 1].y)
+				{
+					m_segments[i].width += m_segments[i + 1].width;
+					m_segments.erase(m_segments.begin() + i + 1);
+				}
+				else
+				{
+					++i;
+				}
+			}
+		}
+
+		uint32_t m_width;
+		uint32_t m_height;
+		std::vector<SkylineSegment> m_segments;
+	};
+
+	uint32_t AlignUp(uint32_t value, uint32_t alignment)
+	{
+		return (value + alignment - 1) / alignment * alignment;
+	}
+}
+
+uint32_t PackRects(std::vector<PackRect>& rects, uint32_t binWidth, uint32_t binHeight, uint32_t alignment)
+{
+	//tallest first packs tighter
+	std::vector<size_t> order(rects.size());
+	std::iota(order.begin(), order.end(), 0);
+	std::stable_sort(order.begin(), order.end(), [&rects](size_t a, size_t b)
+		{
+			return rects[a].height > rects[b].height;
+		});
+
+	std::vector<Skyline> bins;
+	for (size_t index : order)
+	{
+		PackRect& rect = rects[index];
+		const uint32_t width = AlignUp(rect.width, alignment);
+		const uint32_t height = AlignUp(rect.height, alignment);
+
+		bool placed = false;
+		for (uint32_t bin = 0; bin < bins.size() && !placed; ++bin)
+		{
+			placed = bins[bin].Insert(width, height, rect.x, rect.y);
+			rect.bin = bin;
+		}
+
+		if (!placed)
+		{
+			bins.emplace_back(binWidth, binHeight);
+			rect.bin = static_cast<uint32_t>(bins.size()) - 1;
+			placed = bins.back().Insert(width, height, rect.x, rect.y);
+		}
+	}
+
+	return static_cast<uint32_t>(bins.size());
+}
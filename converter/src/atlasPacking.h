@@ -0,0 +1,18 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+struct PackRect
+{
+	uint32_t width;
+	uint32_t height;
+
+	//Filled in by PackRects
+	uint32_t x;
+	uint32_t y;
+	uint32_t bin;
+};
+
+//Skyline bottom-left packing of the rects into bins of binWidth x binHeight, a new bin is opened when a rect no longer fits.
+//Positions are aligned to alignment texels, rects must fit in an empty bin. Returns the number of bins
+uint32_t PackRects(std::vector<PackRect>& rects, uint32_t binWidth, uint32_t binHeight, uint32_t alignment);
@@ -0,0 +1,381 @@
+#include "blockCompression.h"
+#include "jobSystem.h"
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+
+using namespace Asset;
+
+namespace
+{
+	typedef std::array<std::array<uint8_t, 4>, 16> Block; //16 RGBA texels
+
+	//Bit writer for the little endian block layouts
+	struct BitWriter
+	{
+		uint8_t* data;
+		uint32_t position = 0;
+
+		void Write(uint32_t value, uint32_t bits)
+		{
+			for (uint32_t i = 0; i < bits; ++i, ++position)
+			{
+				if (value & (1u << i))
+					data[position / 8] |= static_cast<uint8_t>(1u << (position % 8));
+			}
+		}
+	};
+
+	void FetchBlock(const uint8_t* pixels, uint32_t width, uint32_t height, uint32_t blockX, uint32_t blockY, Block& block)
+	{
+		//texels outside of the image repeat the edge
+		for (uint32_t y = 0; y < 4; ++y)
+		{
+			const uint32_t sy = std::min(blockY * 4 + y, height - 1);
+			for (uint32_t x = 0; x < 4; ++x)
+			{
+				const uint32_t sx = std::min(blockX * 4 + x, width - 1);
+				memcpy(block[y * 4 + x].data(), &pixels[(size_t(sy) * width + sx) * 4], 4);
+			}
+		}
+	}
+
+	//Principal axis of the block colors (channelCount of RGBA), endpoints are the extremes of the projection onto it
+	void FindEndpoints(const Block& block, int channelCount, std::array<float, 4>& e0, std::array<float, 4>& e1)
+	{
+		std::array<float, 4> mean{ 0.0f, 0.0f, 0.0f, 0.0f };
+		for (const auto& texel : block)
+			for (int c = 0; c < channelCount; ++c)
+				mean[c] += texel[c] / 16.0f;
+
+		float covariance[4][4] = {};
+		for (const auto& texel : block)
+		{
+			for (int i = 0; i < channelCount; ++i)
+				for (int j = 0; j < channelCount; ++j)
+					covariance[i][j] += (texel[i] - mean[i]) * (texel[j] - mean[j]);
+		}
+
+		//power iteration
+		std::array<float, 4> axis{ 1.0f, 1.0f, 1.0f, 1.0f };
+		for (int iteration = 0; iteration < 8; ++iteration)
+		{
+			std::array<float, 4> next{ 0.0f, 0.0f, 0.0f, 0.0f };
+			for (int i = 0; i < channelCount; ++i)
+				for (int j = 0; j < channelCount; ++j)
+					next[i] += covariance[i][j] * axis[j];
+
+			float length = 0.0f;
+			for (int i = 0; i < channelCount; ++i)
+				length = std::max(length, std::abs(next[i]));
+
+			if (length <= 0.0f)
+				break;
+
+			for (int i = 0; i < channelCount; ++i)
+				axis[i] = next[i] / length;
+		}
+
+		float minT = std::numeric_limits<float>::max();
+		float maxT = -std::numeric_limits<float>::max();
+		for (const auto& texel : block)
+		{
+			float t = 0.0f;
+			for (int c = 0; c < channelCount; ++c)
+				t += (texel[c] - mean[c]) * axis[c];
+
+			minT = std::min(minT, t);
+			maxT = std::max(maxT, t);
+		}
+
+		float axisLengthSq = 0.0f;
+		for (int c = 0; c < channelCount; ++c)
+			axisLengthSq += axis[c] * axis[c];
+
+		e0 = e1 = { 0.0f, 0.0f, 0.0f, 255.0f };
+		for (int c = 0; c < channelCount; ++c)
+		{
+			const float scale = axisLengthSq > 0.0f ? axis[c] / axisLengthSq : 0.0f;
+			e0[c] = std::clamp(mean[c] + minT * scale, 0.0f, 255.0f);
+			e1[c] = std::clamp(mean[c] + maxT * scale, 0.0f, 255.0f);
+		}
+	}
+
+	uint32_t ColorDistance(const std::array<uint8_t, 4>& a, const std::array<int, 4>& b, int channelCount)
+	{
+		uint32_t distance = 0;
+		for (int c = 0; c < channelCount; ++c)
+		{
+			const int d = int(a[c]) - b[c];
+			distance += d * d;
+		}
+		return distance;
+	}
+
+	uint16_t To565(const std::array<float, 4>& color)
+	{
+		const uint32_t r = static_cast<uint32_t>(std::lround(color[0] * 31.0f / 255.0f));
+		const uint32_t g = static_cast<uint32_t>(std::lround(color[1] * 63.0f / 255.0f));
+		const uint32_t b = static_cast<uint32_t>(std::lround(color[2] * 31.0f / 255.0f));
+		return static_cast<uint16_t>((r << 11) | (g << 5) | b);
+	}
+
+	std::array<int, 4> From565(uint16_t color)
+	{
+		const int r = (color >> 11) & 31;
+		const int g = (color >> 5) & 63;
+		const int b = color & 31;
+		return { (r << 3) | (r >> 2), (g << 2) | (g >> 4), (b << 3) | (b >> 2), 255 };
+	}
+
+	//4 color BC1 block, also the color half of BC3
+	void EncodeColorBlock(const Block& block, uint8_t* output)
+	{
+		std::array<float, 4> e0, e1;
+		FindEndpoints(block, 3, e0, e1);
+
+		uint16_t c0 = To565(e1);
+		uint16_t c1 = To565(e0);
+
+		//c0 > c1 selects the 4 color mode
+		if (c0 < c1)
+			std::swap(c0, c1);
+
+		uint32_t indices = 0;
+		if (c0 != c1)
+		{
+			const std::array<int, 4> a = From565(c0);
+			const std::array<int, 4> b = From565(c1);
+			std::array<std::array<int, 4>, 4> palette;
+			palette[0] = a;
+			palette[1] = b;
+			for (int c = 0; c < 4; ++c)
+			{
+				palette[2][c] = (2 * a[c] + b[c]) / 3;
+				palette[3][c] = (a[c] + 2 * b[c]) / 3;
+			}
+
+			for (int i = 0; i < 16; ++i)
+			{
+				uint32_t best = 0;
+				uint32_t bestDistance = std::numeric_limits<uint32_t>::max();
+				for (uint32_t p = 0; p < 4; ++p)
+				{
+					const uint32_t distance = ColorDistance(block[i], palette[p], 3);
+					if (distance < bestDistance)
+					{
+						bestDistance = distance;
+						best = p;
+					}
+				}
+				indices |= best << (i * 2);
+			}
+		}
+
+		memcpy(output + 0, &c0, sizeof(uint16_t));
+		memcpy(output + 2, &c1, sizeof(uint16_t));
+		memcpy(output + 4, &indices, sizeof(uint32_t));
+	}
+
+	//8 value BC4 block of a single channel, also the alpha half of BC3 and both halves of BC5
+	void EncodeChannelBlock(const Block& block, uint32_t channel, uint8_t* output)
+	{
+		uint8_t minValue = 255;
+		uint8_t maxValue = 0;
+		for (const auto& texel : block)
+		{
+			minValue = std::min(minValue, texel[channel]);
+			maxValue = std::max(maxValue, texel[channel]);
+		}
+
+		//a0 > a1 selects the 8 value mode
+		const uint8_t a0 = maxValue;
+		const uint8_t a1 = minValue;
+
+		std::array<int, 8> palette;
+		palette[0] = a0;
+		palette[1] = a1;
+		for (int i = 1; i < 7; ++i)
+			palette[i + 1] = ((7 - i) * a0 + i * a1) / 7;
+
+		uint64_t indices = 0;
+		if (a0 != a1)
+		{
+			for (int i = 0; i < 16; ++i)
+			{
+				uint64_t best = 0;
+				int bestDistance = std::numeric_limits<int>::max();
+				for (uint64_t p = 0; p < 8; ++p)
+				{
+					const int distance = std::abs(int(block[i][channel]) - palette[p]);
+					if (distance < bestDistance)
+					{
+						bestDistance = distance;
+						best = p;
+					}
+				}
+				indices |= best << (i * 3);
+			}
+		}
+
+		output[0] = a0;
+		output[1] = a1;
+		for (int i = 0; i < 6; ++i)
+			output[2 + i] = static_cast<uint8_t>(indices >> (i * 8));
+	}
+
+	//BC7 mode 6: one subset, RGBA 7 bit endpoints with a shared bit each and 4 bit indices
+	void EncodeBC7Block(const Block& block, uint8_t* output)
+	{
+		static constexpr int weights[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+		std::array<float, 4> e0, e1;
+		FindEndpoints(block, 4, e0, e1);
+
+		//pick the p bit that quantizes each endpoint best
+		std::array<uint32_t, 4> q0, q1;
+		uint32_t p0 = 0, p1 = 0;
+		auto quantize = [](const std::array<float, 4>& endpoint, std::array<uint32_t, 4>& quantized) -> uint32_t
+		{
+			float bestError = std::numeric_limits<float>::max();
+			uint32_t bestP = 0;
+			for (uint32_t p = 0; p < 2; ++p)
+			{
+				float error = 0.0f;
+				std::array<uint32_t, 4> values;
+				for (int c = 0; c < 4; ++c)
+				{
+					values[c] = static_cast<uint32_t>(std::clamp(std::lround((endpoint[c] - p) / 2.0f), 0l, 127l));
+					const float d = float((values[c] << 1) | p) - endpoint[c];
+					error += d * d;
+				}
+
+				if (error < bestError)
+				{
+					bestError = error;
+					bestP = p;
+					quantized = values;
+				}
+			}
+			return bestP;
+		};
+		p0 = quantize(e0, q0);
+		p1 = quantize(e1, q1);
+
+		std::array<int, 4> a, b;
+		for (int c = 0; c < 4; ++c)
+		{
+			a[c] = int((q0[c] << 1) | p0);
+			b[c] = int((q1[c] << 1) | p1);
+		}
+
+		std::array<uint32_t, 16> indices{};
+		for (int i = 0; i < 16; ++i)
+		{
+			uint32_t bestDistance = std::numeric_limits<uint32_t>::max();
+			for (uint32_t w = 0; w < 16; ++w)
+			{
+				std::array<int, 4> color;
+				for (int c = 0; c < 4; ++c)
+					color[c] = ((64 - weights[w]) * a[c] + weights[w] * b[c] + 32) >> 6;
+
+				const uint32_t distance = ColorDistance(block[i], color, 4);
+				if (distance < bestDistance)
+				{
+					bestDistance = distance;
+					indices[i] = w;
+				}
+			}
+		}
+
+		//the first index is stored with an implicit 0 high bit, swap the endpoints if needed
+		if (indices[0] >= 8)
+		{
+			std::swap(q0, q1);
+			std::swap(p0, p1);
+			for (uint32_t& index : indices)
+				index = 15 - index;
+		}
+
+		memset(output, 0, 16);
+		BitWriter writer{ output };
+		writer.Write(1u << 6, 7); //mode 6
+		for (int c = 0; c < 4; ++c)
+		{
+			writer.Write(q0[c], 7);
+			writer.Write(q1[c], 7);
+		}
+		writer.Write(p0, 1);
+		writer.Write(p1, 1);
+		writer.Write(indices[0], 3);
+		for (int i = 1; i < 16; ++i)
+			writer.Write(indices[i], 4);
+	}
+
+	void EncodeBlock(const Block& block, TextureFormat format, uint32_t singleChannel, uint8_t* output)
+	{
+		switch (format)
+		{
+		case TextureFormat::BC1:
+			EncodeColorBlock(block, output);
+			break;
+		case TextureFormat::BC3:
+			EncodeChannelBlock(block, 3, output);
+			EncodeColorBlock(block, output + 8);
+			break;
+		case TextureFormat::BC4:
+			EncodeChannelBlock(block, singleChannel, output);
+			break;
+		case TextureFormat::BC5:
+			EncodeChannelBlock(block, 0, output);
+			EncodeChannelBlock(block, 1, output + 8);
+			break;
+		case TextureFormat::BC7:
+			EncodeBC7Block(block, output);
+			break;
+		default:
+			break;
+		}
+	}
+}
+
+uint32_t GetBlockSize(TextureFormat format)
+{
+	switch (format)
+	{
+	case TextureFormat::BC1:
+	case TextureFormat::BC4:
+		return 8;
+	case TextureFormat::BC3:
+	case TextureFormat::BC5:
+	case TextureFormat::BC7:
+		return 16;
+	default:
+		return 0;
+	}
+}
+
+std::vector<uint8_t> CompressBlocks(const uint8_t* pixels, uint32_t width, uint32_t height, TextureFormat format, uint32_t singleChannel, uint32_t threadCount)
+{
+	const uint32_t blockSize = GetBlockSize(format);
+	const uint32_t blocksX = (width + 3) / 4;
+	const uint32_t blocksY = (height + 3) / 4;
+
+	std::vector<uint8_t> output(size_t(blocksX) * blocksY * blockSize);
+
+	//small images are not worth splitting
+	const uint32_t taskCount = std::max(1u, std::min(threadCount, blocksY / 4));
+
+	JobSystem::Shared().ParallelFor(blocksY, [&](uint32_t row)
+		{
+			Block block;
+			for (uint32_t x = 0; x < blocksX; ++x)
+			{
+				FetchBlock(pixels, width, height, x, row, block);
+				EncodeBlock(block, format, singleChannel, &output[(size_t(row) * blocksX + x) * blockSize]);
+			}
+		}, taskCount);
+
+	return output;
+}
@@ -0,0 +1,11 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include "assetTexture.h"
+
+//Bytes per 4x4 block of a block compressed format, 0 for uncompressed formats
+uint32_t GetBlockSize(Asset::TextureFormat format);
+
+//Encodes an RGBA8 image into 4x4 blocks of a BC format, rows of blocks are split into at most threadCount jobs on the shared job system.
+//BC4 reads the channel given by singleChannel, BC5 reads red and green
+std::vector<uint8_t> CompressBlocks(const uint8_t* pixels, uint32_t width, uint32_t height, Asset::TextureFormat format, uint32_t singleChannel, uint32_t threadCount);
@@ -0,0 +1,391 @@
+#include "buildCache.h"
+#include <fstream>
+#include "nlohmann/json.hpp"
+#include "deduplication.h"
+#include "core/assetHash.h"
+
+namespace
+{
+	//Cached paths are relative to the input or output folder so the folders can move
+	std::string Relative(const std::filesystem::path& path, const std::filesystem::path& base)
+	{
+		if (path.empty())
+			return {};
+		return path.lexically_normal().lexically_relative(base.lexically_normal()).generic_string();
+	}
+
+	std::filesystem::path Absolute(const std::string& path, const std::filesystem::path& base)
+	{
+		if (path.empty())
+			return {};
+		return (base / path).lexically_normal();
+	}
+
+	std::string Normalized(const std::filesystem::path& path)
+	{
+		return path.lexically_normal().generic_string();
+	}
+
+	void RemoveOutput(const std::filesystem::path& output)
+	{
+		std::error_code error;
+		if (std::filesystem::is_directory(output, error))
+		{
+			std::filesystem::remove_all(output, error);
+			return;
+		}
+
+		std::filesystem::remove(output, error);
+		std::filesystem::remove(output.string() + ".meta", error);
+	}
+
+	bool MoveOutput(const std::filesystem::path& from, const std::filesystem::path& to)
+	{
+		std::error_code error;
+		std::filesystem::create_directories(to.parent_path(), error);
+		std::filesystem::rename(from, to, error);
+		if (error)
+			return false;
+
+		const std::filesystem::path meta = from.string() + ".meta";
+		if (std::filesystem::exists(meta))
+			std::filesystem::rename(meta, to.string() + ".meta", error);
+		return !error;
+	}
+
+	//Output textures are relative to the output folder, the images of packed textures to the input folder
+	void SaveTextureRegistrations(const ModelTextureRegistrations& textures, nlohmann::json& cached, const std::filesystem::path& inputFolder, const std::filesystem::path& outputFolder)
+	{
+		for (const auto& [texture, role] : textures.roles)
+			cached["texture_roles"].push_back({ Relative(texture, outputFolder), static_cast<int>(role) });
+		for (const auto& [texture, sources] : textures.packed)
+		{
+			nlohmann::json channels = nlohmann::json::array();
+			for (const auto& channel : sources.channels)
+				channels.push_back(Relative(channel, inputFolder));
+			cached["packed_textures"].push_back({ Relative(texture, outputFolder), channels });
+		}
+	}
+
+	ModelTextureRegistrations LoadTextureRegistrations(const nlohmann::json& cached, const std::filesystem::path& inputFolder, const std::filesystem::path& outputFolder)
+	{
+		ModelTextureRegistrations textures;
+		if (cached.contains("texture_roles"))
+		{
+			for (const auto& role : cached["texture_roles"])
+				textures.roles.emplace_back(Absolute(role[0].get<std::string>(), outputFolder), static_cast<TextureRole>(role[1].get<int>()));
+		}
+		if (cached.contains("packed_textures"))
+		{
+			for (const auto& packed : cached["packed_textures"])
+			{
+				PackedTextureSources sources;
+				for (size_t c = 0; c < sources.channels.size(); ++c)
+					sources.channels[c] = Absolute(packed[1][c].get<std::string>(), inputFolder);
+				textures.packed.emplace_back(Absolute(packed[0].get<std::string>(), outputFolder), sources);
+			}
+		}
+		return textures;
+	}
+
+	void RegisterTextures(const ModelTextureRegistrations& textures)
+	{
+		for (const auto& [texture, role] : textures.roles)
+			RegisterTextureRole(texture, role);
+		for (const auto& [texture, sources] : textures.packed)
+			RegisterPackedTexture(texture, sources);
+	}
+}
+
+BuildCache::BuildCache(const std::filesystem::path& inputFolder, const std::filesystem::path& outputFolder, uint64_t settingsHash) :
+	m_inputFolder(inputFolder), m_outputFolder(outputFolder), m_settingsHash(settingsHash)
+{
+
+}
+
+bool BuildCache::Load()
+{
+	std::ifstream file(m_outputFolder / ".jaam_cache.json");
+	if (!file.is_open())
+		return false;
+
+	nlohmann::json cache = nlohmann::json::parse(file, nullptr, false);
+	if (cache.is_discarded())
+		return false;
+
+	//anything built with other settings or by another converter version is converted again
+	if (cache.value("version", 0u) != ConverterVersion || cache.value("settings", uint64_t(0)) != m_settingsHash)
+		return false;
+
+	for (const auto& cached : cache["entries"])
+	{
+		BuildCacheEntry entry;
+		for (const auto& source : cached["sources"])
+			entry.sources.push_back(Absolute(source.get<std::string>(), m_inputFolder));
+		for (const auto& output : cached["outputs"])
+			entry.outputs.push_back(Absolute(output.get<std::string>(), m_outputFolder));
+		entry.hash = cached["hash"];
+		entry.role = static_cast<TextureRole>(cached["role"].get<int>());
+
+		entry.textures = LoadTextureRegistrations(cached, m_inputFolder, m_outputFolder);
+		if (cached.contains("aliases"))
+			entry.aliases = cached["aliases"].get<std::vector<std::pair<std::string, std::string>>>();
+		if (cached.contains("dependencies"))
+		{
+			for (const auto& edge : cached["dependencies"])
+				entry.dependencies.push_back(DependencyEdge{ edge[0].get<std::string>(), edge[1].get<std::string>(), static_cast<AssetKind>(edge[2].get<int>()) });
+		}
+
+		if (entry.outputs.empty())
+			continue;
+
+		const std::string key = Key(entry);
+		m_previousByHash.emplace(entry.hash, key);
+		m_previous.emplace(key, std::move(entry));
+	}
+	return true;
+}
+
+bool BuildCache::Save() const
+{
+	nlohmann::json entries = nlohmann::json::array();
+	for (const auto& [key, entry] : m_entries)
+	{
+		nlohmann::json cached;
+		cached["sources"] = nlohmann::json::array();
+		for (const auto& source : entry.sources)
+			cached["sources"].push_back(Relative(source, m_inputFolder));
+		cached["outputs"] = nlohmann::json::array();
+		for (const auto& output : entry.outputs)
+			cached["outputs"].push_back(Relative(output, m_outputFolder));
+		cached["hash"] = entry.hash;
+		cached["role"] = static_cast<int>(entry.role);
+
+		SaveTextureRegistrations(entry.textures, cached, m_inputFolder, m_outputFolder);
+		if (!entry.aliases.empty())
+			cached["aliases"] = entry.aliases;
+		for (const auto& edge : entry.dependencies)
+			cached["dependencies"].push_back({ edge.asset, edge.dependency, static_cast<int>(edge.kind) });
+
+		entries.push_back(cached);
+	}
+
+	nlohmann::json cache;
+	cache["version"] = ConverterVersion;
+	cache["settings"] = m_settingsHash;
+	cache["entries"] = entries;
+
+	std::ofstream file(m_outputFolder / ".jaam_cache.json", std::ios::out);
+	if (!file.is_open())
+		return false;
+
+	file << cache.dump(1, '\t');
+	return true;
+}
+
+bool BuildCache::Reuse(const BuildCacheEntry& entry)
+{
+	const std::string key = Key(entry);
+	auto previous = m_previous.find(key);
+	if (previous == m_previous.end() || !Matches(previous->second, entry))
+		return false;
+
+	//the textures of a model that is not converted still need their roles, and the graph its dependencies
+	const BuildCacheEntry& cached = previous->second;
+	RegisterTextures(cached.textures);
+	for (const auto& edge : cached.dependencies)
+	{
+		RegisterDependency(edge);
+		if (edge.kind == AssetKind::Material)
+			RegisterAsset(edge.dependency, AssetKind::Material);
+	}
+
+	m_reused.insert(key);
+	m_entries[key] = cached;
+	return true;
+}
+
+bool BuildCache::ReuseMoved(const BuildCacheEntry& entry)
+{
+	const std::string key = Key(entry);
+	auto [first, last] = m_previousByHash.equal_range(entry.hash);
+	for (auto candidate = first; candidate != last; ++candidate)
+	{
+		const std::string& previousKey = candidate->second;
+		if (previousKey == key || m_entries.count(previousKey) || m_moved.count(previousKey))
+			continue;
+
+		const BuildCacheEntry& previous = m_previous.at(previousKey);
+		if (previous.role != entry.role || previous.outputs.size() != entry.outputs.size())
+			continue;
+
+		//only a source that is gone has moved, a copy is deduplicated or converted
+		bool sourceExists = false;
+		for (const auto& source : previous.sources)
+			sourceExists |= !source.empty() && std::filesystem::exists(source);
+		if (sourceExists)
+			continue;
+
+		bool outputsExist = true;
+		for (const auto& output : previous.outputs)
+			outputsExist &= std::filesystem::exists(output);
+		if (!outputsExist)
+			continue;
+
+		for (size_t i = 0; i < entry.outputs.size(); ++i)
+		{
+			if (!MoveOutput(previous.outputs[i], entry.outputs[i]))
+				return false;
+		}
+
+		m_moved.insert(previousKey);
+		Record(entry);
+		return true;
+	}
+	return false;
+}
+
+void BuildCache::Record(const BuildCacheEntry& entry)
+{
+	m_entries[Key(entry)] = entry;
+}
+
+void BuildCache::Keep(const std::filesystem::path& output)
+{
+	const std::string key = Normalized(output);
+	auto previous = m_previous.find(key);
+	if (previous == m_previous.end() || m_entries.count(key))
+		return;
+
+	//kept like a reused entry so the aliases of its materials stay in the manifest
+	m_reused.insert(key);
+	m_entries[key] = previous->second;
+}
+
+void BuildCache::UpdateAliases(BuildManifest& manifest, const std::filesystem::path& rootPath)
+{
+	//the deduplicated materials of a model that was not converted are not on disk to be found again
+	for (const auto& key : m_reused)
+	{
+		for (const auto& [alias, asset] : m_entries.at(key).aliases)
+		{
+			if (manifest.ResolveAlias(alias) == alias)
+				manifest.AddAlias(alias, asset);
+		}
+	}
+
+	std::unordered_map<std::string, std::vector<std::pair<std::string, std::string>>> aliasesByFolder;
+	for (const auto& [alias, asset] : manifest.GetAliases())
+	{
+		aliasesByFolder[std::filesystem::path(alias).parent_path().generic_string()].emplace_back(alias, asset);
+	}
+
+	for (auto& [key, entry] : m_entries)
+	{
+		entry.aliases.clear();
+		for (const auto& output : entry.outputs)
+		{
+			if (!std::filesystem::is_directory(output))
+				continue;
+
+			auto aliases = aliasesByFolder.find(ManifestPath(output, rootPath));
+			if (aliases != aliasesByFolder.end())
+				entry.aliases.insert(entry.aliases.end(), aliases->second.begin(), aliases->second.end());
+		}
+	}
+}
+
+void BuildCache::RemoveStaleOutputs() const
+{
+	std::unordered_set<std::string> outputs;
+	for (const auto& [key, entry] : m_entries)
+	{
+		for (const auto& output : entry.outputs)
+			outputs.insert(Normalized(output));
+	}
+
+	for (const auto& [key, entry] : m_previous)
+	{
+		for (const auto& output : entry.outputs)
+		{
+			if (!outputs.count(Normalized(output)))
+				RemoveOutput(output);
+		}
+	}
+}
+
+void BuildCache::ForgetConverted()
+{
+	for (auto entry = m_entries.begin(); entry != m_entries.end();)
+	{
+		if (m_reused.count(entry->first))
+			++entry;
+		else
+			entry = m_entries.erase(entry);
+	}
+}
+
+std::string BuildCache::Key(const BuildCacheEntry& entry) const
+{
+	return Normalized(entry.outputs.front());
+}
+
+bool BuildCache::Matches(const BuildCacheEntry& previous, const BuildCacheEntry& entry) const
+{
+	if (previous.hash != entry.hash || previous.role != entry.role || previous.outputs.size() != entry.outputs.size())
+		return false;
+
+	for (size_t i = 0; i < entry.outputs.size(); ++i)
+	{
+		if (Normalized(previous.outputs[i]) != Normalized(entry.outputs[i]) || !std::filesystem::exists(entry.outputs[i]))
+			return false;
+	}
+	return true;
+}
+
+ModelScanCache::ModelScanCache(const std::filesystem::path& inputFolder, const std::filesystem::path& outputFolder, uint64_t settingsHash) :
+	m_inputFolder(inputFolder), m_outputFolder(outputFolder), m_settingsHash(settingsHash)
+{
+
+}
+
+bool ModelScanCache::Reuse(const std::string& modelAsset, uint64_t hash) const
+{
+	std::ifstream file(ScanPath(modelAsset));
+	if (!file.is_open())
+		return false;
+
+	//a file another shard is still writing doesn't parse and the model is scanned
+	nlohmann::json scan = nlohmann::json::parse(file, nullptr, false);
+	if (scan.is_discarded())
+		return false;
+
+	if (scan.value("version", 0u) != ConverterVersion || scan.value("settings", uint64_t(0)) != m_settingsHash ||
+		scan.value("model", std::string()) != modelAsset || scan.value("hash", uint64_t(0)) != hash)
+		return false;
+
+	RegisterTextures(LoadTextureRegistrations(scan, m_inputFolder, m_outputFolder));
+	return true;
+}
+
+void ModelScanCache::Record(const std::string& modelAsset, uint64_t hash, const ModelTextureRegistrations& textures) const
+{
+	nlohmann::json scan;
+	scan["version"] = ConverterVersion;
+	scan["settings"] = m_settingsHash;
+	scan["model"] = modelAsset;
+	scan["hash"] = hash;
+	SaveTextureRegistrations(textures, scan, m_inputFolder, m_outputFolder);
+
+	//shards that scanned the same model write the same file
+	std::error_code error;
+	std::filesystem::create_directories(ScanPath(modelAsset).parent_path(), error);
+	std::ofstream file(ScanPath(modelAsset), std::ios::out);
+	if (file.is_open())
+		file << scan.dump(1, '\t');
+}
+
+std::filesystem::path ModelScanCache::ScanPath(const std::string& modelAsset) const
+{
+	return m_outputFolder / ".jaam_scan" / (std::to_string(Asset::HashXXH64(modelAsset.data(), modelAsset.size())) + ".json");
+}
@@ -0,0 +1,88 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <unordered_set>
+#include <filesystem>
+#include "textureProcessing.h"
+#include "manifest.h"
+#include "dependencyGraph.h"
+
+//Bump when a change to the converter changes its output, every cached entry is rebuilt
+constexpr uint32_t ConverterVersion = 4;
+
+//What an output was built from last run
+struct BuildCacheEntry
+{
+	std::vector<std::filesystem::path> sources; //A model first, then the files assimp reads next to it
+	uint64_t hash = 0; //Content of the sources
+	TextureRole role = TextureRole::Unknown;
+	std::vector<std::filesystem::path> outputs; //The first output identifies the entry, directories are allowed
+
+	//Models only, registered again when the model is not reconverted
+	ModelTextureRegistrations textures;
+	std::vector<std::pair<std::string, std::string>> aliases; //Manifest aliases of its deduplicated materials
+	std::vector<DependencyEdge> dependencies; //Its materials and their textures
+};
+
+/// <summary>
+/// Remembers what every output was built from so incremental runs only convert sources that changed.
+/// Stored as .jaam_cache.json in the output folder, a cache written with other settings or another converter version is ignored
+/// </summary>
+class BuildCache
+{
+public:
+	BuildCache(const std::filesystem::path& inputFolder, const std::filesystem::path& outputFolder, uint64_t settingsHash);
+
+	bool Load();
+	bool Save() const;
+
+	//True if entry was built from the same content last run and its outputs are still there, the entry is kept
+	bool Reuse(const BuildCacheEntry& entry);
+	//Moves the outputs of a moved or deleted source with the same content over to entry's outputs
+	bool ReuseMoved(const BuildCacheEntry& entry);
+	void Record(const BuildCacheEntry& entry);
+	//Keeps the previous entry of an output that is not converted this run (not reachable from the roots), its outputs stay as they are
+	void Keep(const std::filesystem::path& output);
+
+	//Keeps the material aliases of models that were not reconverted and remembers the ones found this run
+	void UpdateAliases(BuildManifest& manifest, const std::filesystem::path& rootPath);
+	//Removes outputs of the last run that were neither written nor kept this run
+	void RemoveStaleOutputs() const;
+	//Drops the entries recorded this run but keeps the reused ones, after a failed write the outputs converted this run can't be trusted
+	void ForgetConverted();
+private:
+	std::string Key(const BuildCacheEntry& entry) const;
+	bool Matches(const BuildCacheEntry& previous, const BuildCacheEntry& entry) const;
+
+	std::filesystem::path m_inputFolder;
+	std::filesystem::path m_outputFolder;
+	uint64_t m_settingsHash;
+
+	std::unordered_map<std::string, BuildCacheEntry> m_previous;
+	std::unordered_multimap<uint64_t, std::string> m_previousByHash;
+	std::unordered_set<std::string> m_moved; //Previous entries whose outputs were taken by a moved source
+	std::unordered_set<std::string> m_reused;
+	std::unordered_map<std::string, BuildCacheEntry> m_entries;
+};
+
+/// <summary>
+/// Texture roles and packed textures of every model a shard converted or scanned, so the other shards don't import it again to learn them.
+/// Stored in .jaam_scan in the output folder the shards share, one file per model checked against the content of its sources
+/// </summary>
+class ModelScanCache
+{
+public:
+	ModelScanCache(const std::filesystem::path& inputFolder, const std::filesystem::path& outputFolder, uint64_t settingsHash);
+
+	//Registers the textures of a model scanned from the same content with the same settings, false if it has to be scanned
+	bool Reuse(const std::string& modelAsset, uint64_t hash) const;
+	void Record(const std::string& modelAsset, uint64_t hash, const ModelTextureRegistrations& textures) const;
+private:
+	std::filesystem::path ScanPath(const std::string& modelAsset) const;
+
+	std::filesystem::path m_inputFolder;
+	std::filesystem::path m_outputFolder;
+	uint64_t m_settingsHash;
+};
@@ -0,0 +1,109 @@
+#include "changeNotifier.h"
+#include <cstring>
+#include "nlohmann/json.hpp"
+
+#if __has_include(<sys/socket.h>) && __has_include(<sys/un.h>)
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <fcntl.h>
+#define JAAM_UNIX_SOCKET
+
+namespace
+{
+	//writing to a client that went away must not raise SIGPIPE and end the converter, platforms without the flag set SO_NOSIGPIPE on the client
+#ifdef MSG_NOSIGNAL
+	constexpr int SendFlags = MSG_NOSIGNAL;
+#else
+	constexpr int SendFlags = 0;
+#endif
+}
+#endif
+
+ChangeNotifier::ChangeNotifier(const std::filesystem::path& socketPath) : m_socketPath(socketPath), m_socket(-1)
+{
+#ifdef JAAM_UNIX_SOCKET
+	sockaddr_un address{};
+	address.sun_family = AF_UNIX;
+	const std::string path = socketPath.string();
+	if (path.size() >= sizeof(address.sun_path))
+		return;
+	memcpy(address.sun_path, path.c_str(), path.size() + 1);
+
+	//a socket left behind by a converter that was killed is replaced
+	unlink(path.c_str());
+
+	m_socket = socket(AF_UNIX, SOCK_STREAM, 0);
+	if (m_socket < 0)
+		return;
+
+	if (fcntl(m_socket, F_SETFL, O_NONBLOCK) != 0 || bind(m_socket, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0 || listen(m_socket, 8) != 0)
+	{
+		close(m_socket);
+		m_socket = -1;
+	}
+#endif
+}
+
+ChangeNotifier::~ChangeNotifier()
+{
+#ifdef JAAM_UNIX_SOCKET
+	for (int client : m_clients)
+		close(client);
+
+	if (m_socket >= 0)
+	{
+		close(m_socket);
+		unlink(m_socketPath.string().c_str());
+	}
+#endif
+}
+
+bool ChangeNotifier::IsOpen() const
+{
+	return m_socket >= 0;
+}
+
+void ChangeNotifier::Notify(const std::string& event, const std::vector<std::string>& assets)
+{
+#ifdef JAAM_UNIX_SOCKET
+	if (m_socket < 0 || assets.empty())
+		return;
+
+	AcceptClients();
+
+	std::string message;
+	for (const std::string& asset : assets)
+		message += nlohmann::json{ {"event", event}, {"asset", asset} }.dump() + "\n";
+
+	//a client is never waited on, one that can't take the whole message is dropped rather than sent half a line
+	for (auto client = m_clients.begin(); client != m_clients.end();)
+	{
+		const ssize_t sent = send(*client, message.data(), message.size(), SendFlags);
+		if (sent == static_cast<ssize_t>(message.size()))
+		{
+			++client;
+			continue;
+		}
+
+		close(*client);
+		client = m_clients.erase(client);
+	}
+#endif
+}
+
+void ChangeNotifier::AcceptClients()
+{
+#ifdef JAAM_UNIX_SOCKET
+	int client;
+	while ((client = accept(m_socket, nullptr, nullptr)) >= 0)
+	{
+		fcntl(client, F_SETFL, O_NONBLOCK);
+#ifdef SO_NOSIGPIPE
+		const int noSignal = 1;
+		setsockopt(client, SOL_SOCKET, SO_NOSIGPIPE, &noSignal, sizeof(noSignal));
+#endif
+		m_clients.push_back(client);
+	}
+#endif
+}
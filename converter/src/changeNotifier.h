@@ -0,0 +1,28 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <filesystem>
+
+/// <summary>
+/// Unix domain socket that tells connected runtimes which converted assets changed so they can reload them.
+/// Each change is one line of json: {"event":"converted"|"removed","asset":"<manifest path>"}.
+/// Clients that don't keep up with the notifications are disconnected.
+/// </summary>
+class ChangeNotifier
+{
+public:
+	explicit ChangeNotifier(const std::filesystem::path& socketPath);
+	~ChangeNotifier();
+
+	ChangeNotifier(const ChangeNotifier&) = delete;
+	ChangeNotifier& operator=(const ChangeNotifier&) = delete;
+
+	bool IsOpen() const;
+	void Notify(const std::string& event, const std::vector<std::string>& assets);
+private:
+	void AcceptClients();
+
+	std::filesystem::path m_socketPath;
+	int m_socket;
+	std::vector<int> m_clients;
+};
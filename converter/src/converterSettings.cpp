@@ -0,0 +1,334 @@
+#include "converterSettings.h"
+#include <iostream>
+#include <string>
+#include <algorithm>
+#include <thread>
+#include <sstream>
+#include "core/assetHash.h"
+
+namespace
+{
+	bool ParseUInt(const std::string& value, uint32_t& out)
+	{
+		try
+		{
+			out = static_cast<uint32_t>(std::stoul(value));
+			return true;
+		}
+		catch (...)
+		{
+			return false;
+		}
+	}
+
+	bool ParseFloat(const std::string& value, float& out)
+	{
+		try
+		{
+			out = std::stof(value);
+			return out >= 0.0f;
+		}
+		catch (...)
+		{
+			return false;
+		}
+	}
+}
+
+bool ParseConverterSettings(int argc, char** argv, ConverterSettings& settings)
+{
+	//argv[1] and argv[2] are the input and output directories
+	for (int i = 3; i < argc; ++i)
+	{
+		std::string arg = argv[i];
+		std::string value;
+
+		size_t split = arg.find('=');
+		if (split != std::string::npos)
+		{
+			value = arg.substr(split + 1);
+			arg = arg.substr(0, split);
+		}
+
+		bool valid = true;
+		if (arg == "--meshlets")
+		{
+			settings.generateMeshlets = true;
+		}
+		else if (arg == "--meshlet-max-vertices")
+		{
+			valid = ParseUInt(value, settings.meshletMaxVertices);
+		}
+		else if (arg == "--meshlet-max-triangles")
+		{
+			valid = ParseUInt(value, settings.meshletMaxTriangles);
+		}
+		else if (arg == "--weld")
+		{
+			settings.weldVertices = true;
+		}
+		else if (arg == "--weld-position-tolerance")
+		{
+			valid = ParseFloat(value, settings.weldPositionTolerance);
+		}
+		else if (arg == "--weld-normal-tolerance")
+		{
+			valid = ParseFloat(value, settings.weldNormalTolerance);
+		}
+		else if (arg == "--weld-uv-tolerance")
+		{
+			valid = ParseFloat(value, settings.weldTexCoordTolerance);
+		}
+		else if (arg == "--soa")
+		{
+			settings.separateVertexStreams = true;
+		}
+		else if (arg == "--world-transforms")
+		{
+			settings.storeWorldTransforms = true;
+		}
+		else if (arg == "--mips")
+		{
+			settings.generateMips = true;
+		}
+		else if (arg == "--mip-filter")
+		{
+			valid = value == "box" || value == "kaiser";
+			settings.mipFilter = value == "kaiser" ? MipFilter::Kaiser : MipFilter::Box;
+		}
+		else if (arg == "--mip-alpha-coverage")
+		{
+			settings.mipAlphaCoverage = true;
+		}
+		else if (arg == "--alpha-cutoff")
+		{
+			valid = ParseFloat(value, settings.alphaCutoff);
+		}
+		else if (arg == "--compress")
+		{
+			settings.compressTextures = true;
+		}
+		else if (arg == "--bc7")
+		{
+			settings.useBC7 = true;
+		}
+		else if (arg == "--encode-threads")
+		{
+			valid = ParseUInt(value, settings.encodeThreads);
+		}
+		else if (arg == "--stream")
+		{
+			settings.streamableTextures = true;
+		}
+		else if (arg == "--tile-size")
+		{
+			valid = ParseUInt(value, settings.textureTileSize);
+		}
+		else if (arg == "--reduce-channels")
+		{
+			settings.reduceTextureChannels = true;
+		}
+		else if (arg == "--pack-channels")
+		{
+			settings.packTextureChannels = true;
+		}
+		else if (arg == "--atlas")
+		{
+			settings.atlasTextures = true;
+		}
+		else if (arg == "--atlas-arrays")
+		{
+			settings.atlasTextures = true;
+			settings.atlasArrays = true;
+		}
+		else if (arg == "--atlas-max-source")
+		{
+			valid = ParseUInt(value, settings.atlasMaxSourceSize);
+		}
+		else if (arg == "--atlas-size")
+		{
+			valid = ParseUInt(value, settings.atlasSize);
+		}
+		else if (arg == "--atlas-padding")
+		{
+			valid = ParseUInt(value, settings.atlasPadding);
+		}
+		else if (arg == "--dedup")
+		{
+			settings.deduplicate = true;
+		}
+		else if (arg == "--incremental")
+		{
+			settings.incremental = true;
+		}
+		else if (arg == "--memory-budget")
+		{
+			valid = ParseUInt(value, settings.memoryBudgetMB);
+		}
+		else if (arg == "--read-jobs")
+		{
+			valid = ParseUInt(value, settings.readJobs);
+		}
+		else if (arg == "--decode-jobs")
+		{
+			valid = ParseUInt(value, settings.decodeJobs);
+		}
+		else if (arg == "--write-jobs")
+		{
+			valid = ParseUInt(value, settings.writeJobs);
+		}
+		else if (arg == "--write-queue")
+		{
+			valid = ParseUInt(value, settings.writeQueueMB);
+		}
+		else if (arg == "--roots")
+		{
+			std::stringstream list(value);
+			std::string root;
+			while (std::getline(list, root, ','))
+			{
+				if (!root.empty())
+					settings.roots.push_back(std::filesystem::path(root).lexically_normal().generic_string());
+			}
+			valid = !settings.roots.empty();
+		}
+		else if (arg == "--graph")
+		{
+			settings.emitGraph = true;
+		}
+		else if (arg == "--shard")
+		{
+			const size_t slash = value.find('/');
+			valid = slash != std::string::npos && ParseUInt(value.substr(0, slash), settings.shardIndex) && ParseUInt(value.substr(slash + 1), settings.shardCount)
+				&& settings.shardIndex < settings.shardCount;
+		}
+		else if (arg == "--merge")
+		{
+			settings.mergeShards = true;
+		}
+		else if (arg == "--watch")
+		{
+			settings.watch = true;
+		}
+		else if (arg == "--watch-delay")
+		{
+			valid = ParseUInt(value, settings.watchDelayMS);
+		}
+		else if (arg == "--notify")
+		{
+			settings.notifySocket = value;
+			valid = !value.empty();
+		}
+		else if (arg == "--profile")
+		{
+			settings.profilePath = value.empty() ? "convert_trace.json" : value;
+		}
+		else if (arg == "--profile-count")
+		{
+			valid = ParseUInt(value, settings.profileSummaryCount);
+		}
+		else
+		{
+			std::cout << "Unknown option " << argv[i] << std::endl;
+			return false;
+		}
+
+		if (!valid)
+		{
+			std::cout << "Invalid value for option " << argv[i] << std::endl;
+			return false;
+		}
+	}
+
+	//meshlet local indices are stored as 8 bit
+	settings.meshletMaxVertices = std::clamp(settings.meshletMaxVertices, 3u, 255u);
+	settings.meshletMaxTriangles = std::clamp(settings.meshletMaxTriangles, 1u, 512u);
+
+	//a padded texture has to fit in an empty atlas
+	settings.atlasPadding = std::min(settings.atlasPadding, 64u);
+	settings.atlasSize = std::max(settings.atlasSize, settings.atlasPadding * 2 + 64);
+	settings.atlasMaxSourceSize = std::min(settings.atlasMaxSourceSize, settings.atlasSize - settings.atlasPadding * 2 - 4);
+
+	//atlases are packed from every small texture at once, no shard has all of them
+	if ((settings.shardCount > 0 || settings.mergeShards) && settings.atlasTextures)
+	{
+		std::cout << "--shard and --merge can't be used with --atlas" << std::endl;
+		return false;
+	}
+
+	//a changed source is converted to its own outputs, nothing else is looked at again
+	if (settings.watch && (settings.atlasTextures || settings.deduplicate || settings.shardCount > 0 || settings.mergeShards))
+	{
+		std::cout << "--watch can't be used with --atlas, --dedup, --shard or --merge" << std::endl;
+		return false;
+	}
+
+	if (settings.encodeThreads == 0)
+		settings.encodeThreads = std::max(1u, std::thread::hardware_concurrency());
+
+	return true;
+}
+
+void PrintConverterUsage()
+{
+	std::cout << "usage: JAAMConverter <input dir> <output dir> [options]\n"
+		<< "  --meshlets                    split meshes into meshlets with culling bounds\n"
+		<< "  --meshlet-max-vertices=N      max vertices per meshlet (default 64, max 255)\n"
+		<< "  --meshlet-max-triangles=N     max triangles per meshlet (default 124, max 512)\n"
+		<< "  --weld                        merge duplicate vertices\n"
+		<< "  --weld-position-tolerance=F   position quantization step (default 1e-5)\n"
+		<< "  --weld-normal-tolerance=F     normal quantization step (default 1e-3)\n"
+		<< "  --weld-uv-tolerance=F         texture coordinate quantization step (default 1e-5)\n"
+		<< "  --soa                         write one vertex stream per attribute instead of interleaved vertices\n"
+		<< "  --world-transforms            store precomputed model space node transforms\n"
+		<< "  --mips                        generate mip chains for textures\n"
+		<< "  --mip-filter=box|kaiser       mip downsampling filter (default box)\n"
+		<< "  --mip-alpha-coverage          preserve alpha test coverage in the mips of textures with alpha\n"
+		<< "  --alpha-cutoff=F              alpha test threshold used for coverage (default 0.5)\n"
+		<< "  --compress                    block compress textures (BC1/BC3 color, BC5 normals, BC4 single channel)\n"
+		<< "  --bc7                         use BC7 instead of BC1/BC3 for color textures\n"
+		<< "  --encode-threads=N            max jobs the block compression of one texture is split into (default hardware concurrency)\n"
+		<< "  --stream                      compress texture mip levels separately for streaming\n"
+		<< "  --tile-size=N                 split large texture levels into NxN tiles that decode in parallel\n"
+		<< "  --reduce-channels             store uncompressed textures as R8/RG8/RGB8 when channels are unused\n"
+		<< "  --pack-channels               pack spec, roughness and occlusion maps into one texture per material\n"
+		<< "  --atlas                       pack small textures of the same format into atlases\n"
+		<< "  --atlas-arrays                pack small textures of the same format and size into texture arrays\n"
+		<< "  --atlas-max-source=N          largest texture side that is packed (default 256)\n"
+		<< "  --atlas-size=N                atlas width and max height (default 2048)\n"
+		<< "  --atlas-padding=N             edge texels repeated around packed textures (default 4)\n"
+		<< "  --dedup                       store identical textures and materials once and alias the copies\n"
+		<< "  --incremental                 only convert sources that changed since the last run (not with --atlas)\n"
+		<< "  --memory-budget=MB            estimated memory of the files converted at once (default 4096, 0 = unlimited)\n"
+		<< "  --read-jobs=N                 source files read at once (default 4)\n"
+		<< "  --decode-jobs=N               images decoded and models imported at once (default hardware concurrency)\n"
+		<< "  --write-jobs=N                files the background writer submits at once (default 16)\n"
+		<< "  --write-queue=MB              converted data waiting to be written before conversions wait (default 256, 0 = unlimited)\n"
+		<< "  --roots=A,B,...               only convert these sources (relative to the input dir) and the textures their materials use, other outputs are kept\n"
+		<< "  --graph                       write the model -> material -> texture graph to dependencies.json\n"
+		<< "  --shard=I/N                   convert shard I of N (0 based) and write a partial manifest, run N processes with the same options\n"
+		<< "  --merge                       combine the partial manifests of every shard in the output dir into manifest.json\n"
+		<< "  --watch                       keep running and convert sources again as they change\n"
+		<< "  --watch-delay=MS              wait for edits to stop for this long before converting them (default 100)\n"
+		<< "  --notify=SOCKET               unix socket --watch sends changed assets to (default .jaam_watch.sock in the output dir)\n"
+		<< "  --profile[=FILE]              time each asset's stages, write a Chrome trace (default convert_trace.json) and list the slowest assets\n"
+		<< "  --profile-count=N             slowest assets listed by --profile (default 20)\n";
+}
+
+uint64_t HashConverterSettings(const ConverterSettings& settings)
+{
+	//thread counts, pipeline limits, incremental, roots, sharding, watching, graph output and profiling don't change the output
+	std::ostringstream stream;
+	stream << settings.generateMeshlets << ' ' << settings.meshletMaxVertices << ' ' << settings.meshletMaxTriangles << ' '
+		<< settings.weldVertices << ' ' << settings.weldPositionTolerance << ' ' << settings.weldNormalTolerance << ' ' << settings.weldTexCoordTolerance << ' '
+		<< settings.separateVertexStreams << ' ' << settings.storeWorldTransforms << ' '
+		<< settings.generateMips << ' ' << static_cast<int>(settings.mipFilter) << ' ' << settings.mipAlphaCoverage << ' ' << settings.alphaCutoff << ' '
+		<< settings.compressTextures << ' ' << settings.useBC7 << ' '
+		<< settings.streamableTextures << ' ' << settings.textureTileSize << ' '
+		<< settings.reduceTextureChannels << ' ' << settings.packTextureChannels << ' '
+		<< settings.atlasTextures << ' ' << settings.atlasArrays << ' ' << settings.atlasMaxSourceSize << ' ' << settings.atlasSize << ' ' << settings.atlasPadding << ' '
+		<< settings.deduplicate;
+
+	const std::string values = stream.str();
+	return Asset::HashXXH64(values.data(), values.size());
+}
@@ -0,0 +1,94 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "textureProcessing.h"
+
+struct ConverterSettings
+{
+	//Meshlets
+	bool generateMeshlets = false;
+	uint32_t meshletMaxVertices = 64;
+	uint32_t meshletMaxTriangles = 124;
+
+	//Vertex welding, attributes are quantized to these tolerances before comparing (0 = exact match)
+	bool weldVertices = false;
+	float weldPositionTolerance = 1e-5f;
+	float weldNormalTolerance = 1e-3f;
+	float weldTexCoordTolerance = 1e-5f;
+
+	//Write one vertex stream per attribute instead of interleaved vertices
+	bool separateVertexStreams = false;
+
+	//Store precomputed model space node transforms next to the local ones
+	bool storeWorldTransforms = false;
+
+	//Mip chains
+	bool generateMips = false;
+	MipFilter mipFilter = MipFilter::Box;
+	bool mipAlphaCoverage = false; //For textures with alpha
+	float alphaCutoff = 0.5f;
+
+	//Block compression, the format is picked from how materials use the texture
+	bool compressTextures = false;
+	bool useBC7 = false; //BC7 instead of BC1/BC3 for color textures
+	uint32_t encodeThreads = 0; //Max jobs one texture is split into, 0 = hardware concurrency
+
+	//Compress mip levels separately so they can be streamed in on demand
+	bool streamableTextures = false;
+	//Split large mip levels into independently compressed tiles of this many texels (0 = off)
+	uint32_t textureTileSize = 0;
+
+	//Store uncompressed textures with only the channels they use (R8/RG8/RGB8)
+	bool reduceTextureChannels = false;
+	//Pack the spec, roughness and occlusion maps of a material into one texture
+	bool packTextureChannels = false;
+
+	//Pack small textures of the same format into shared atlases, or texture arrays of same sized textures
+	bool atlasTextures = false;
+	bool atlasArrays = false;
+	uint32_t atlasMaxSourceSize = 256; //Largest side of a texture that is packed
+	uint32_t atlasSize = 2048;
+	uint32_t atlasPadding = 4; //Texels of edge repeated around each texture against mip bleeding
+
+	//Store textures and materials with identical content once, the copies are recorded as aliases in the manifest
+	bool deduplicate = false;
+
+	//Skip sources that are unchanged since the last run, tracked in a build cache in the output folder
+	bool incremental = false;
+
+	//Conversion pipeline limits, new files are only started while their estimated memory fits in the budget
+	uint32_t memoryBudgetMB = 4096; //0 = unlimited
+	uint32_t readJobs = 4; //Files read at once
+	uint32_t decodeJobs = 0; //Images decoded and models imported at once, 0 = hardware concurrency
+	uint32_t writeJobs = 16; //Files the output writer submits at once
+	uint32_t writeQueueMB = 256; //Converted bytes waiting for the writer before jobs wait for it, 0 = unlimited
+
+	//Only convert these sources (paths relative to the input folder) and what their materials use, empty = everything
+	std::vector<std::string> roots;
+	//Write the model -> material -> texture graph to dependencies.json in the output folder
+	bool emitGraph = false;
+
+	//Convert only the sources whose stable hash falls in shard shardIndex of shardCount (0 = not sharded), the partial manifests
+	//of every shard are combined by a run with mergeShards once all of them are done
+	uint32_t shardIndex = 0;
+	uint32_t shardCount = 0;
+	bool mergeShards = false;
+
+	//Keep running after converting everything and convert sources again as they change, edits that come in within
+	//watchDelayMS of each other are converted together. Changes are sent to the notifySocket unix socket
+	bool watch = false;
+	uint32_t watchDelayMS = 100;
+	std::string notifySocket; //Empty = .jaam_watch.sock in the output folder
+
+	//Time every stage of every asset, written as a Chrome trace to this file with a summary of the slowest assets (empty = off)
+	std::string profilePath;
+	uint32_t profileSummaryCount = 20; //Slowest assets listed in the summary
+};
+
+//Parses the optional "--option" / "--option=value" arguments that follow the input and output paths
+bool ParseConverterSettings(int argc, char** argv, ConverterSettings& settings);
+void PrintConverterUsage();
+
+//Hash of every setting that changes the converted output
+uint64_t HashConverterSettings(const ConverterSettings& settings);
@@ -0,0 +1,163 @@
+#include "deduplication.h"
+#include <fstream>
+#include <map>
+#include <algorithm>
+#include "core/assetHash.h"
+#include "assetFile.h"
+#include "nlohmann/json.hpp"
+#include "util.h"
+
+using namespace Asset;
+
+namespace
+{
+	void RemoveAsset(const std::filesystem::path& path)
+	{
+		std::error_code error;
+		std::filesystem::remove(path, error);
+		std::filesystem::remove(path.string() + ".meta", error);
+	}
+
+	//the source file a texture names doesn't change what is loaded, textures from different sources with equal texels are equal
+	uint64_t HashTextureOutput(const AssetFile& file)
+	{
+		nlohmann::json metadata = nlohmann::json::parse(file.json, nullptr, false);
+		if (metadata.is_discarded())
+			return 0;
+		metadata.erase("original_file");
+
+		const std::string json = metadata.dump();
+		uint64_t hash = HashXXH64(file.type.data(), file.type.size());
+		hash = HashXXH64(&file.version, sizeof(file.version), hash);
+		hash = HashXXH64(json.data(), json.size(), hash);
+		return file.binaryBlob.Hash(hash);
+	}
+
+	//Models name their materials by path, the removed copies are replaced with the material that was kept
+	void RemapModelMaterials(const std::filesystem::path& outputFolder, const BuildManifest& manifest)
+	{
+		for (const auto& file : std::filesystem::recursive_directory_iterator(outputFolder))
+		{
+			if (file.path().extension() != ".modl")
+				continue;
+
+			//the blob is only loaded for models that change
+			AssetFile modelFile;
+			if (!modelFile.LoadBinaryFile(file.path().string(), false))
+				continue;
+
+			nlohmann::json metadata = nlohmann::json::parse(modelFile.json, nullptr, false);
+			if (metadata.is_discarded() || !metadata.contains("meshMaterials"))
+				continue;
+
+			bool remapped = false;
+			for (auto& material : metadata["meshMaterials"])
+			{
+				const std::string path = std::filesystem::path(material.get<std::string>()).lexically_normal().generic_string();
+				const std::string resolved = manifest.ResolveAlias(path);
+				if (resolved != path)
+				{
+					material = resolved;
+					remapped = true;
+				}
+			}
+
+			if (!remapped || !modelFile.LoadBinaryFile(file.path().string()))
+				continue;
+
+			modelFile.json = metadata.dump();
+			modelFile.SaveBinaryFile(file.path().string());
+		}
+	}
+}
+
+uint64_t HashFileContents(const std::filesystem::path& path, uint64_t seed)
+{
+	std::ifstream file(path, std::ios::binary | std::ios::ate);
+	if (!file.is_open())
+		return 0;
+
+	std::vector<char> contents(static_cast<size_t>(file.tellg()));
+	file.seekg(0);
+	file.read(contents.data(), contents.size());
+
+	return HashXXH64(contents.data(), contents.size(), seed);
+}
+
+uint64_t CombineHashes(uint64_t a, uint64_t b)
+{
+	return HashXXH64(&b, sizeof(b), a);
+}
+
+std::string ManifestPath(const std::filesystem::path& output, const std::filesystem::path& rootPath)
+{
+	return GetRelativePathFrom(output, rootPath.string()).lexically_normal().generic_string();
+}
+
+std::vector<size_t> CollapseDuplicates(const std::vector<ContentKey>& keys, const std::filesystem::path& rootPath, BuildManifest& manifest)
+{
+	//sorted so the same output is kept whichever order the files were found in
+	std::vector<size_t> order(keys.size());
+	for (size_t i = 0; i < order.size(); ++i)
+		order[i] = i;
+	std::sort(order.begin(), order.end(), [&keys](size_t a, size_t b) { return keys[a].output < keys[b].output; });
+
+	std::unordered_map<uint64_t, size_t> firstWithHash;
+	std::vector<size_t> unique;
+	for (size_t i : order)
+	{
+		//unreadable sources are converted as they are and fail there
+		auto first = keys[i].hash != 0 ? firstWithHash.find(keys[i].hash) : firstWithHash.end();
+		if (first == firstWithHash.end())
+		{
+			if (keys[i].hash != 0)
+				firstWithHash.emplace(keys[i].hash, i);
+			unique.push_back(i);
+			continue;
+		}
+
+		manifest.AddAlias(ManifestPath(keys[i].output, rootPath), ManifestPath(keys[first->second].output, rootPath));
+		RemoveAsset(keys[i].output); //only the first copy is kept
+	}
+
+	std::sort(unique.begin(), unique.end());
+	return unique;
+}
+
+void DeduplicateMaterials(const std::filesystem::path& outputFolder, const std::filesystem::path& rootPath, BuildManifest& manifest)
+{
+	std::vector<ContentKey> materials;
+	for (const auto& file : std::filesystem::recursive_directory_iterator(outputFolder))
+	{
+		if (file.path().extension() != ".mat")
+			continue;
+
+		AssetFile materialFile;
+		if (!materialFile.LoadBinaryFile(file.path().string()))
+			continue;
+
+		//the json is written with sorted keys so equal materials pack to equal files
+		materials.push_back({ file.path(), materialFile.ComputeChecksum() });
+	}
+
+	CollapseDuplicates(materials, rootPath, manifest);
+	RemapModelMaterials(outputFolder, manifest);
+}
+
+void DeduplicateTextures(const std::filesystem::path& outputFolder, const std::filesystem::path& rootPath, BuildManifest& manifest)
+{
+	std::vector<ContentKey> textures;
+	for (const auto& file : std::filesystem::recursive_directory_iterator(outputFolder))
+	{
+		if (file.path().extension() != ".tx")
+			continue;
+
+		AssetFile textureFile;
+		if (!textureFile.LoadBinaryFile(file.path().string()))
+			continue;
+
+		textures.push_back({ file.path(), HashTextureOutput(textureFile) });
+	}
+
+	CollapseDuplicates(textures, rootPath, manifest);
+}
@@ -0,0 +1,30 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include <filesystem>
+#include "manifest.h"
+
+//An output the converter is about to write and the hash of the content it is built from
+struct ContentKey
+{
+	std::filesystem::path output;
+	uint64_t hash;
+};
+
+//XXH64 of a file's contents, 0 if it can't be read
+uint64_t HashFileContents(const std::filesystem::path& path, uint64_t seed = 0);
+uint64_t CombineHashes(uint64_t a, uint64_t b);
+
+//Path of an output in the form materials and the manifest refer to it
+std::string ManifestPath(const std::filesystem::path& output, const std::filesystem::path& rootPath);
+
+//Outputs with the same hash are written once, under the first output path in sorted order, the others are recorded as aliases of it.
+//Returns the indices of the keys that still have to be converted
+std::vector<size_t> CollapseDuplicates(const std::vector<ContentKey>& keys, const std::filesystem::path& rootPath, BuildManifest& manifest);
+
+//Hashes every converted texture by its packed file and removes the copies, this finds the duplicates that come from different sources.
+//Run before the material textures are remapped so they point at the copy that was kept
+void DeduplicateTextures(const std::filesystem::path& outputFolder, const std::filesystem::path& rootPath, BuildManifest& manifest);
+//Hashes every converted material and removes the copies, materials have to point at their final textures first. Models are rewritten
+//to name the material that was kept, so they load without the manifest aliases
+void DeduplicateMaterials(const std::filesystem::path& outputFolder, const std::filesystem::path& rootPath, BuildManifest& manifest);
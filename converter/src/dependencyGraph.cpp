@@ -0,0 +1,177 @@
+#include "dependencyGraph.h"
+#include <map>
+#include <set>
+#include <mutex>
+#include <fstream>
+#include <algorithm>
+#include <tuple>
+#include "nlohmann/json.hpp"
+
+namespace
+{
+	struct AssetNode
+	{
+		AssetKind kind = AssetKind::Texture;
+		std::string source;
+		bool produced = false; //False for assets that are only known as a dependency
+		std::set<std::pair<std::string, AssetKind>> dependencies;
+	};
+
+	//ordered so the saved graph is the same every run
+	std::mutex graphLock;
+	std::map<std::string, AssetNode> assets;
+
+	const char* KindName(AssetKind kind)
+	{
+		switch (kind)
+		{
+		case AssetKind::Model:
+			return "model";
+		case AssetKind::Material:
+			return "material";
+		default:
+			return "texture";
+		}
+	}
+
+	//under graphLock
+	void CollectReachable(const std::string& asset, std::unordered_set<std::string>& reachable)
+	{
+		std::vector<std::string> pending = { asset };
+		while (!pending.empty())
+		{
+			const std::string current = pending.back();
+			pending.pop_back();
+
+			if (!reachable.insert(current).second)
+				continue;
+
+			auto node = assets.find(current);
+			if (node == assets.end())
+				continue;
+
+			for (const auto& [dependency, kind] : node->second.dependencies)
+				pending.push_back(dependency);
+		}
+	}
+}
+
+void RegisterAsset(const std::string& asset, AssetKind kind, const std::string& source)
+{
+	std::lock_guard<std::mutex> lock(graphLock);
+	AssetNode& node = assets[asset];
+	node.kind = kind;
+	node.produced = true;
+	if (!source.empty())
+		node.source = source;
+}
+
+void RegisterDependency(const DependencyEdge& edge)
+{
+	std::lock_guard<std::mutex> lock(graphLock);
+	assets[edge.asset].dependencies.emplace(edge.dependency, edge.kind);
+
+	AssetNode& dependency = assets[edge.dependency];
+	if (!dependency.produced)
+		dependency.kind = edge.kind;
+}
+
+std::vector<DependencyEdge> GetDependencyEdges(const std::string& asset)
+{
+	std::lock_guard<std::mutex> lock(graphLock);
+
+	std::unordered_set<std::string> reachable;
+	CollectReachable(asset, reachable);
+
+	std::vector<DependencyEdge> edges;
+	for (const std::string& from : reachable)
+	{
+		auto node = assets.find(from);
+		if (node == assets.end())
+			continue;
+
+		for (const auto& [dependency, kind] : node->second.dependencies)
+			edges.push_back(DependencyEdge{ from, dependency, kind });
+	}
+
+	std::sort(edges.begin(), edges.end(), [](const DependencyEdge& a, const DependencyEdge& b) { return std::tie(a.asset, a.dependency) < std::tie(b.asset, b.dependency); });
+	return edges;
+}
+
+std::unordered_set<std::string> GetReachableAssets(const std::vector<std::string>& roots)
+{
+	std::lock_guard<std::mutex> lock(graphLock);
+
+	std::unordered_set<std::string> reachable;
+	for (const std::string& root : roots)
+		CollectReachable(root, reachable);
+	return reachable;
+}
+
+std::vector<DependencyEdge> GetMissingDependencies()
+{
+	std::lock_guard<std::mutex> lock(graphLock);
+
+	std::vector<DependencyEdge> missing;
+	for (const auto& [asset, node] : assets)
+	{
+		for (const auto& [dependency, kind] : node.dependencies)
+		{
+			if (!assets.at(dependency).produced)
+				missing.push_back(DependencyEdge{ asset, dependency, kind });
+		}
+	}
+	return missing;
+}
+
+std::vector<std::string> GetUnreferencedAssets(AssetKind kind)
+{
+	std::lock_guard<std::mutex> lock(graphLock);
+
+	std::unordered_set<std::string> referenced;
+	for (const auto& [asset, node] : assets)
+	{
+		for (const auto& [dependency, dependencyKind] : node.dependencies)
+			referenced.insert(dependency);
+	}
+
+	std::vector<std::string> unreferenced;
+	for (const auto& [asset, node] : assets)
+	{
+		if (node.kind == kind && node.produced && !referenced.count(asset))
+			unreferenced.push_back(asset);
+	}
+	return unreferenced;
+}
+
+bool SaveDependencyGraph(const std::filesystem::path& path)
+{
+	std::lock_guard<std::mutex> lock(graphLock);
+
+	nlohmann::json graph = nlohmann::json::object();
+	for (const auto& [asset, node] : assets)
+	{
+		nlohmann::json entry;
+		entry["type"] = KindName(node.kind);
+		if (!node.source.empty())
+			entry["source"] = node.source;
+		if (!node.produced)
+			entry["missing"] = true;
+
+		entry["dependencies"] = nlohmann::json::array();
+		for (const auto& [dependency, kind] : node.dependencies)
+			entry["dependencies"].push_back(dependency);
+
+		graph[asset] = entry;
+	}
+
+	nlohmann::json file;
+	file["assets"] = graph;
+
+	std::ofstream stream(path, std::ios::out);
+	if (!stream.is_open())
+		return false;
+
+	stream << file.dump(1, '\t');
+	return true;
+}
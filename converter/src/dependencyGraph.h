@@ -0,0 +1,37 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <unordered_set>
+#include <filesystem>
+
+//Assets are identified by their manifest path, the output path relative to the parent of the input folder
+enum class AssetKind
+{
+	Model,
+	Material,
+	Texture
+};
+
+struct DependencyEdge
+{
+	std::string asset;
+	std::string dependency;
+	AssetKind kind; //Of the dependency
+};
+
+//Outputs the converter produces, with the source they are built from when there is one
+void RegisterAsset(const std::string& asset, AssetKind kind, const std::string& source = {});
+//Recorded by the model converter: model -> material -> texture. A model that is not reconverted registers its edges again from the build cache
+void RegisterDependency(const DependencyEdge& edge);
+
+//Every edge below asset
+std::vector<DependencyEdge> GetDependencyEdges(const std::string& asset);
+//Roots and everything they depend on
+std::unordered_set<std::string> GetReachableAssets(const std::vector<std::string>& roots);
+//Edges to assets nothing produces
+std::vector<DependencyEdge> GetMissingDependencies();
+//Assets of kind that nothing depends on
+std::vector<std::string> GetUnreferencedAssets(AssetKind kind);
+
+//Every asset with its kind, source, dependencies and whether it was produced
+bool SaveDependencyGraph(const std::filesystem::path& path);
@@ -0,0 +1,169 @@
+#include "fileWatcher.h"
+#include <thread>
+#include <algorithm>
+
+#if __has_include(<sys/inotify.h>) && __has_include(<poll.h>)
+#include <sys/inotify.h>
+#include <poll.h>
+#include <unistd.h>
+#define JAAM_INOTIFY
+#endif
+
+namespace
+{
+	//how often the folder is rescanned without inotify
+	constexpr std::chrono::milliseconds ScanInterval(250);
+
+#ifdef JAAM_INOTIFY
+	//closed after writing or moved in covers editors that save in place and ones that save to a temporary file and rename it
+	constexpr uint32_t WatchEvents = IN_CLOSE_WRITE | IN_MOVED_TO | IN_MOVED_FROM | IN_DELETE | IN_CREATE;
+#endif
+}
+
+FileWatcher::FileWatcher(const std::filesystem::path& folder) : m_folder(folder), m_inotify(-1)
+{
+#ifdef JAAM_INOTIFY
+	m_inotify = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+#endif
+	WatchFolder(m_folder, nullptr);
+}
+
+FileWatcher::~FileWatcher()
+{
+#ifdef JAAM_INOTIFY
+	if (m_inotify >= 0)
+		close(m_inotify);
+#endif
+}
+
+std::vector<std::filesystem::path> FileWatcher::WaitForChanges(std::chrono::milliseconds quietTime)
+{
+	std::vector<std::filesystem::path> changed;
+	while (changed.empty())
+		Poll(ScanInterval, changed);
+
+	while (Poll(quietTime, changed))
+	{
+	}
+
+	//a file saved several times in the burst is converted once
+	std::sort(changed.begin(), changed.end());
+	changed.erase(std::unique(changed.begin(), changed.end()), changed.end());
+	return changed;
+}
+
+bool FileWatcher::Poll(std::chrono::milliseconds timeout, std::vector<std::filesystem::path>& changed)
+{
+	const size_t found = changed.size();
+
+#ifdef JAAM_INOTIFY
+	if (m_inotify >= 0)
+	{
+		pollfd descriptor{ m_inotify, POLLIN, 0 };
+		if (poll(&descriptor, 1, static_cast<int>(timeout.count())) <= 0)
+			return false;
+
+		alignas(inotify_event) char buffer[16 * 1024];
+		ssize_t length;
+		while ((length = read(m_inotify, buffer, sizeof(buffer))) > 0)
+		{
+			for (char* next = buffer; next < buffer + length;)
+			{
+				const inotify_event* event = reinterpret_cast<const inotify_event*>(next);
+				next += sizeof(inotify_event) + event->len;
+
+				//events were dropped, every file is reported so nothing saved meanwhile is missed
+				if (event->mask & IN_Q_OVERFLOW)
+				{
+					WatchFolder(m_folder, &changed);
+					continue;
+				}
+
+				auto watch = m_watches.find(event->wd);
+				if (watch == m_watches.end())
+					continue;
+
+				if (event->mask & IN_IGNORED)
+				{
+					m_watches.erase(watch);
+					continue;
+				}
+				if (event->len == 0)
+					continue;
+
+				const std::filesystem::path path = watch->second / event->name;
+				if (event->mask & IN_ISDIR)
+				{
+					//files can be written into a new folder before its watch is added, they are picked up by the scan of it
+					if (event->mask & (IN_CREATE | IN_MOVED_TO))
+						WatchFolder(path, &changed);
+					continue;
+				}
+
+				//a created file is reported again when it is closed
+				if (event->mask & (IN_CLOSE_WRITE | IN_MOVED_TO | IN_MOVED_FROM | IN_DELETE))
+					changed.push_back(path);
+			}
+		}
+		return changed.size() > found;
+	}
+#endif
+
+	std::this_thread::sleep_for(timeout);
+
+	std::unordered_map<std::string, std::filesystem::file_time_type> writeTimes;
+	std::error_code error;
+	for (const auto& file : std::filesystem::recursive_directory_iterator(m_folder, error))
+	{
+		if (!file.is_regular_file(error))
+			continue;
+
+		const std::string path = file.path().string();
+		const auto writeTime = file.last_write_time(error);
+		auto previous = m_writeTimes.find(path);
+		if (previous == m_writeTimes.end() || previous->second != writeTime)
+			changed.push_back(file.path());
+		writeTimes.emplace(path, writeTime);
+	}
+
+	for (const auto& [path, writeTime] : m_writeTimes)
+	{
+		if (!writeTimes.count(path))
+			changed.push_back(path);
+	}
+	m_writeTimes = std::move(writeTimes);
+	return changed.size() > found;
+}
+
+void FileWatcher::WatchFolder(const std::filesystem::path& folder, std::vector<std::filesystem::path>* changed)
+{
+	std::error_code error;
+#ifdef JAAM_INOTIFY
+	if (m_inotify >= 0)
+	{
+		std::vector<std::filesystem::path> folders = { folder };
+		for (const auto& file : std::filesystem::recursive_directory_iterator(folder, error))
+		{
+			if (file.is_directory(error))
+				folders.push_back(file.path());
+			else if (changed)
+				changed->push_back(file.path());
+		}
+
+		for (const auto& watched : folders)
+		{
+			const int watch = inotify_add_watch(m_inotify, watched.c_str(), WatchEvents);
+			if (watch >= 0)
+				m_watches[watch] = watched;
+		}
+		return;
+	}
+#endif
+
+	//the first scan is the state changes are compared with
+	for (const auto& file : std::filesystem::recursive_directory_iterator(folder, error))
+	{
+		if (file.is_regular_file(error))
+			m_writeTimes.emplace(file.path().string(), file.last_write_time(error));
+	}
+}
@@ -0,0 +1,33 @@
+#pragma once
+#include <chrono>
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <filesystem>
+
+/// <summary>
+/// Reports the files that change under a folder, including files added to new folders and files that were removed.
+/// Uses inotify where it is available, elsewhere the folder is rescanned and compared by write time.
+/// </summary>
+class FileWatcher
+{
+public:
+	explicit FileWatcher(const std::filesystem::path& folder);
+	~FileWatcher();
+
+	FileWatcher(const FileWatcher&) = delete;
+	FileWatcher& operator=(const FileWatcher&) = delete;
+
+	//Blocks until a file changes, then keeps collecting until nothing changed for quietTime so a burst of edits is one batch
+	std::vector<std::filesystem::path> WaitForChanges(std::chrono::milliseconds quietTime);
+private:
+	//Adds what changed within timeout, false if nothing did
+	bool Poll(std::chrono::milliseconds timeout, std::vector<std::filesystem::path>& changed);
+	//Starts watching a folder and everything below it, the files already in it are reported as changed
+	void WatchFolder(const std::filesystem::path& folder, std::vector<std::filesystem::path>* changed);
+
+	std::filesystem::path m_folder;
+	int m_inotify;
+	std::unordered_map<int, std::filesystem::path> m_watches; //inotify watch -> folder
+	std::unordered_map<std::string, std::filesystem::file_time_type> m_writeTimes; //Without inotify, every file from the last scan
+};
@@ -0,0 +1,175 @@
+#include "jobSystem.h"
+
+namespace
+{
+	thread_local const JobSystem* workerSystem = nullptr;
+	thread_local uint32_t workerQueue = 0;
+	thread_local uint32_t stealSeed = 0;
+}
+
+JobSystem::JobSystem(uint32_t workerCount) : m_queuedJobs(0), m_sleeping(0), m_stop(false)
+{
+	for (uint32_t i = 0; i < workerCount + 1; ++i)
+	{
+		m_queues.emplace_back(std::make_unique<WorkerQueue>());
+	}
+
+	for (uint32_t i = 0; i < workerCount; ++i)
+	{
+		m_workers.emplace_back(&JobSystem::Work, this, i + 1);
+	}
+}
+
+JobSystem::~JobSystem()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_sleepLock);
+		m_stop = true;
+	}
+	m_wake.notify_all();
+
+	for (std::thread& worker : m_workers)
+	{
+		worker.join();
+	}
+}
+
+void JobSystem::Wait(JobCounter& counter)
+{
+	while (counter.pending > 0)
+	{
+		if (RunPendingJob())
+			continue;
+
+		//nothing to help with, sleep until a job is queued or the last job of the counter is done
+		std::unique_lock<std::mutex> lock(m_sleepLock);
+		m_sleeping++;
+		m_wake.wait(lock, [&]() { return counter.pending == 0 || m_queuedJobs > 0; });
+		m_sleeping--;
+	}
+}
+
+uint32_t JobSystem::GetWorkerCount() const
+{
+	return static_cast<uint32_t>(m_workers.size());
+}
+
+JobSystem& JobSystem::Shared()
+{
+	static JobSystem jobSystem(std::max(1u, std::thread::hardware_concurrency()) - 1);
+	return jobSystem;
+}
+
+void JobSystem::Push(const Job& job)
+{
+	//counted before it is queued so a thief never takes the count below zero
+	m_queuedJobs++;
+
+	WorkerQueue& queue = *m_queues[CurrentQueue()];
+	{
+		std::lock_guard<std::mutex> lock(queue.lock);
+		queue.jobs.push_back(job);
+	}
+
+	//sleepers count themselves before checking for jobs, so one of the two sides always sees the other
+	if (m_sleeping > 0)
+	{
+		std::lock_guard<std::mutex> lock(m_sleepLock);
+		m_wake.notify_one();
+	}
+}
+
+bool JobSystem::Pop(uint32_t queue, Job& job)
+{
+	WorkerQueue& own = *m_queues[queue];
+	std::lock_guard<std::mutex> lock(own.lock);
+	if (own.jobs.empty())
+		return false;
+
+	//newest first, its data is most likely still in cache
+	job = own.jobs.back();
+	own.jobs.pop_back();
+	m_queuedJobs--;
+	return true;
+}
+
+bool JobSystem::Steal(uint32_t thief, Job& job)
+{
+	const uint32_t queueCount = static_cast<uint32_t>(m_queues.size());
+
+	//xorshift so thieves don't all start on the same victim
+	stealSeed ^= stealSeed << 13;
+	stealSeed ^= stealSeed >> 17;
+	stealSeed ^= stealSeed << 5;
+	const uint32_t start = (stealSeed ? stealSeed : thief + 1) % queueCount;
+
+	for (uint32_t i = 0; i < queueCount; ++i)
+	{
+		const uint32_t victim = (start + i) % queueCount;
+		if (victim == thief)
+			continue;
+
+		WorkerQueue& queue = *m_queues[victim];
+		std::lock_guard<std::mutex> lock(queue.lock);
+		if (queue.jobs.empty())
+			continue;
+
+		//oldest first, it is usually the biggest piece of work left
+		job = queue.jobs.front();
+		queue.jobs.pop_front();
+		m_queuedJobs--;
+		return true;
+	}
+	return false;
+}
+
+bool JobSystem::RunPendingJob()
+{
+	const uint32_t queue = CurrentQueue();
+
+	Job job;
+	if (!Pop(queue, job) && !Steal(queue, job))
+		return false;
+
+	Execute(job);
+	return true;
+}
+
+void JobSystem::Execute(const Job& job)
+{
+	job.invoke(job.storage);
+
+	//the counter can go out of scope as soon as it reaches zero, don't touch it after
+	if (job.counter->pending.fetch_sub(1) == 1)
+	{
+		std::lock_guard<std::mutex> lock(m_sleepLock);
+		m_wake.notify_all();
+	}
+}
+
+void JobSystem::Work(uint32_t queue)
+{
+	workerSystem = this;
+	workerQueue = queue;
+	stealSeed = queue * 2654435761u;
+
+	while (true)
+	{
+		if (RunPendingJob())
+			continue;
+
+		std::unique_lock<std::mutex> lock(m_sleepLock);
+		m_sleeping++;
+		m_wake.wait(lock, [this]() { return m_stop || m_queuedJobs > 0; });
+		m_sleeping--;
+
+		//queued jobs are finished before the workers stop
+		if (m_stop && m_queuedJobs == 0)
+			return;
+	}
+}
+
+uint32_t JobSystem::CurrentQueue() const
+{
+	return workerSystem == this ? workerQueue : 0;
+}
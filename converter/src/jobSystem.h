@@ -0,0 +1,120 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <new>
+#include <algorithm>
+#include <atomic>
+#include <deque>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <vector>
+#include <memory>
+#include <type_traits>
+
+//Counts the unfinished jobs run against it, waiting on it returns once it reaches zero
+struct JobCounter
+{
+	std::atomic<uint32_t> pending = 0;
+};
+
+//Bytes a job stores its callable in
+constexpr size_t JobStorageSize = 64;
+
+/// <summary>
+/// Work stealing job scheduler. Every worker owns a deque and runs its newest job first, idle workers steal the oldest job of another.
+/// Waiting on a counter runs other jobs until the counter is done, so a job can run sub-jobs and wait on them without blocking its worker.
+/// Jobs hold their callable inline so it has to be trivially copyable and fit in JobStorageSize bytes, capture by reference or index
+/// </summary>
+class JobSystem
+{
+public:
+	explicit JobSystem(uint32_t workerCount);
+	~JobSystem();
+
+	template <typename F>
+	void Run(JobCounter& counter, const F& func);
+	void Wait(JobCounter& counter);
+	//Runs one queued job on the calling thread, false if there was none
+	bool RunPendingJob();
+
+	//Calls func(i) for every i in [0, count) split over at most maxTasks jobs (0 = a few per thread), returns once all calls are done
+	template <typename F>
+	void ParallelFor(uint32_t count, const F& func, uint32_t maxTasks = 0);
+
+	uint32_t GetWorkerCount() const;
+
+	static JobSystem& Shared(); //hardware concurrency - 1 workers, the waiting thread makes up the last one
+private:
+	struct Job
+	{
+		void (*invoke)(const void* storage);
+		JobCounter* counter;
+		alignas(std::max_align_t) unsigned char storage[JobStorageSize];
+	};
+
+	struct WorkerQueue
+	{
+		std::mutex lock;
+		std::deque<Job> jobs;
+	};
+
+	void Push(const Job& job);
+	bool Pop(uint32_t queue, Job& job);
+	bool Steal(uint32_t thief, Job& job);
+	void Execute(const Job& job);
+	void Work(uint32_t queue);
+	uint32_t CurrentQueue() const;
+
+	std::vector<std::unique_ptr<WorkerQueue>> m_queues; //The first queue is shared by threads that are not workers
+	std::vector<std::thread> m_workers;
+
+	std::atomic<uint32_t> m_queuedJobs;
+	std::atomic<uint32_t> m_sleeping;
+	std::mutex m_sleepLock;
+	std::condition_variable m_wake;
+	bool m_stop;
+};
+
+template <typename F>
+void JobSystem::Run(JobCounter& counter, const F& func)
+{
+	static_assert(std::is_trivially_copyable<F>::value, "Jobs are copied as bytes, capture by reference or index");
+	static_assert(sizeof(F) <= JobStorageSize && alignof(F) <= alignof(std::max_align_t), "Job callable does not fit in JobStorageSize");
+
+	Job job;
+	job.invoke = [](const void* storage) { (*static_cast<const F*>(storage))(); };
+	job.counter = &counter;
+	new (job.storage) F(func);
+
+	counter.pending++;
+	Push(job);
+}
+
+template <typename F>
+void JobSystem::ParallelFor(uint32_t count, const F& func, uint32_t maxTasks)
+{
+	//a few jobs per thread so a slow range does not hold the loop up
+	const uint32_t taskLimit = maxTasks ? maxTasks : (GetWorkerCount() + 1) * 4;
+	const uint32_t tasks = std::min(count, taskLimit);
+	if (tasks <= 1)
+	{
+		for (uint32_t i = 0; i < count; ++i)
+			func(i);
+		return;
+	}
+
+	JobCounter counter;
+	const F* body = &func;
+	for (uint32_t task = 0; task < tasks; ++task)
+	{
+		const uint32_t begin = static_cast<uint32_t>(uint64_t(count) * task / tasks);
+		const uint32_t end = static_cast<uint32_t>(uint64_t(count) * (task + 1) / tasks);
+		Run(counter, [body, begin, end]()
+			{
+				for (uint32_t i = begin; i < end; ++i)
+					(*body)(i);
+			});
+	}
+	Wait(counter);
+}
@@ -14,202 +14,444 @@
 
 #include "util.h"
 #include "modelConverter.h"
-#include <queue>
-#include <thread>
-#include <functional>
-#include <mutex>
+#include "converterSettings.h"
+#include "textureConverter.h"
+#include "deduplication.h"
+#include "buildCache.h"
+#include "jobSystem.h"
+#include "pipeline.h"
+#include "profiler.h"
+#include "outputWriter.h"
+#include "dependencyGraph.h"
+#include "sharding.h"
+#include "watchMode.h"
+#include "core/assetHash.h"
+#include "core/threadPool.h"
 #include <chrono>
 #include <unordered_set>
-#include <atomic>
+#include <memory>
 
 using namespace Asset;
 
-std::atomic<uint16_t> checksum = 0;
-
-namespace
+int main(int argc, char** argv)
 {
-	class JobPool
-	{
-	public:
-		JobPool(int threadCount);
-		~JobPool();
-		void push(std::function<void()> func);
-		void done();
-	private:
-
-		void work();
-
-		std::queue<std::function<void()>> m_function_queue;
-		std::mutex m_lock;
-		std::condition_variable m_data_condition;
-		std::atomic<bool> m_accept_functions;
-		std::vector<std::thread> m_workerThreads;
+	std::unordered_set<std::string> textureExtensions =
+	{
+		".png",
+		".jpg",
+		".jpeg",
+		".bmp"
 	};
 
-	JobPool::JobPool(int threadCount) : m_function_queue(), m_lock(), m_data_condition(), m_accept_functions(true)
+	std::unordered_set<std::string> modelExtensions =
 	{
-		m_workerThreads.resize(threadCount);
-		for (uint32_t  i = 0; i < threadCount; i++)
-		{
-			m_workerThreads.at(i) = std::thread(&JobPool::work, this);
-		}
-	}
+		".obj",
+		".fbx",
+		".gltf"
+	};
 
-	JobPool::~JobPool()
+	ConverterSettings settings;
+	if (argc < 3 || !ParseConverterSettings(argc, argv, settings))
 	{
+		PrintConverterUsage();
+		return 1;
 	}
 
-	void JobPool::push(std::function<void()> func)
-	{
-		//If there are no worker threads just call the func (single threaded)
-		if (m_workerThreads.empty())
-			func();
+	//the library's loops (tiled texture packing, chunked blobs) run as jobs too, so inner loops of concurrent conversions share one set of threads
+	JobSystem& jobs = JobSystem::Shared();
+	ThreadPool::SetSharedExecutor([](uint32_t count, const std::function<void(uint32_t)>& func) { JobSystem::Shared().ParallelFor(count, func); });
+	std::cout << "number of threads = " << jobs.GetWorkerCount() + 1 << std::endl;
+	ConfigurePipeline(settings);
+	if (!settings.profilePath.empty())
+		EnableProfiling();
 
-		std::unique_lock<std::mutex> lock(m_lock);
-		m_function_queue.push(func);
-		// when we send the notification immediately, the consumer will try to get the lock , so unlock asap
-		lock.unlock();
-		m_data_condition.notify_one();
-	}
+	for (int i = 0; i < argc; ++i)
+		std::cout << argv[i] << '\n';
+
+	const fs::path path{ argv[1] };
+	const fs::path output{ argv[2] };
+
+	//the shards are done, only their manifests are combined
+	if (settings.mergeShards)
+		return MergeShards(output, path.filename(), settings) ? 0 : 1;
+
+	//watched before the sources are walked, what is saved while the full conversion runs is converted once it is done
+	std::unique_ptr<FileWatcher> watcher;
+	if (settings.watch)
+		watcher = std::make_unique<FileWatcher>(path);
+
+	std::cout << "loading asset directory at " << path << std::endl;
+
+	auto start = std::chrono::high_resolution_clock::now();
 
-	void JobPool::done()
+	//atlases are rebuilt from every small texture, they can't be built from a part of the sources. Shards would share one cache
+	const bool incremental = settings.incremental && !settings.atlasTextures && settings.shardCount == 0;
+	if (settings.incremental && !incremental)
+		std::cout << "--incremental is ignored with --atlas and --shard" << std::endl;
+
+	BuildCache cache(path, output, HashConverterSettings(settings));
+	if (incremental)
+		cache.Load();
+
+	//textures are converted after the models, the materials decide their compressed format
+	std::vector<std::pair<fs::path, fs::path>> textureFiles; //source -> output
+	std::vector<std::pair<fs::path, fs::path>> modelFiles;
+
+	for (auto& p : fs::recursive_directory_iterator(path))
 	{
-		std::unique_lock<std::mutex> lock(m_lock);
-		m_accept_functions = false;
-		lock.unlock();
-		// when we send the notification immediately, the consumer will try to get the lock , so unlock asap
-		m_data_condition.notify_all();
-		//notify all waiting threads.
+		fs::path newpath = ChangeRoot(path, output, p.path());
+		fs::path newdir = newpath;
+
+		fs::create_directories(newdir.remove_filename());
+
+		if (textureExtensions.find(p.path().extension().string()) != textureExtensions.end()) {
+			std::cout << "found a texture" << p << std::endl;
 
-		for (auto& thread : m_workerThreads)
+			newpath.replace_extension(".tx");
+			textureFiles.emplace_back(p.path(), newpath);
+		}
+		if (modelExtensions.find(p.path().extension().string()) != modelExtensions.end())
 		{
-			thread.join();
+			std::cout << "found a mesh" << p << std::endl;
+
+			newpath.replace_extension(".mesh");
+			modelFiles.emplace_back(p.path(), newpath);
 		}
 	}
 
-	void JobPool::work()
+	const fs::path rootPath = path.filename();
+
+	//every source found is in the dependency graph, sources are named relative to the input folder as --roots names them
+	auto sourceName = [&path](const fs::path& source) { return source.lexically_relative(path).generic_string(); };
+	const std::unordered_set<std::string> roots(settings.roots.begin(), settings.roots.end());
+	std::vector<std::string> rootAssets;
+	std::vector<std::string> sourceNames;
+
+	for (const auto& [source, newpath] : textureFiles)
 	{
-		std::function<void()> func;
-		while (true)
-		{
-			{
-				std::unique_lock<std::mutex> lock(m_lock);
-				m_data_condition.wait(lock, [this]()
-					{
-						return !m_function_queue.empty() || !m_accept_functions;
-					});
+		const std::string asset = ManifestPath(newpath, rootPath);
+		RegisterAsset(asset, AssetKind::Texture, sourceName(source));
+		sourceNames.push_back(sourceName(source));
+		if (roots.count(sourceName(source)))
+			rootAssets.push_back(asset);
+	}
+	for (const auto& [source, newpath] : modelFiles)
+	{
+		const std::string asset = ManifestPath(fs::path(newpath).replace_extension(".modl"), rootPath);
+		RegisterAsset(asset, AssetKind::Model, sourceName(source));
+		sourceNames.push_back(sourceName(source));
+		if (roots.count(sourceName(source)))
+			rootAssets.push_back(asset);
+	}
 
-				if (!m_accept_functions && m_function_queue.empty())
+	if (!roots.empty() && rootAssets.size() < roots.size())
+		std::cout << "only " << rootAssets.size() << " of the " << roots.size() << " roots were found\n";
+
+	//content hashes of the sources, for the build cache, deduplication and the scans shards share. A model's hash covers the files assimp reads next to it
+	const bool hashModels = incremental || settings.shardCount > 0;
+	std::vector<uint64_t> textureHashes(textureFiles.size(), 0);
+	std::vector<uint64_t> modelHashes(modelFiles.size(), 0);
+	std::vector<std::vector<fs::path>> modelSideFiles(modelFiles.size());
+	if (hashModels || settings.deduplicate)
+	{
+		jobs.ParallelFor(static_cast<uint32_t>(textureFiles.size() + modelFiles.size()), [&](uint32_t i)
+			{
+				if (i < textureFiles.size())
 				{
-					//lock will be release automatically.
-					//finish the thread loop and let it join in the main thread.
-					return;
+					textureHashes[i] = HashFileContents(textureFiles[i].first);
 				}
-				func = m_function_queue.front();
-				m_function_queue.pop();
-				//release the lock
-			}
-			func();
-		}
+				else if (hashModels)
+				{
+					const size_t model = i - textureFiles.size();
+					modelSideFiles[model] = GetModelSideFiles(modelFiles[model].first);
+
+					uint64_t hash = HashFileContents(modelFiles[model].first);
+					for (const auto& sideFile : modelSideFiles[model])
+						hash = CombineHashes(hash, HashFileContents(sideFile));
+					modelHashes[model] = hash;
+				}
+			});
 	}
-}
 
+	//a model writes <name>.modl and the <name>_materials folder next to it. Models come first, their materials are what
+	//the textures are reached from
+	JobCounter modelJobs;
+	std::vector<BuildCacheEntry> convertedModels;
+	std::vector<size_t> otherShardModels;
+	uint32_t skipped = 0;
+	uint32_t unreachable = 0;
+	std::vector<std::string> shardOutputs; //What this shard converted, relative to the output folder
+	auto addShardOutput = [&output, &shardOutputs](const fs::path& converted) { shardOutputs.push_back(converted.lexically_relative(output).generic_string()); };
+	for (size_t i = 0; i < modelFiles.size(); ++i)
+	{
+		const auto& [source, newpath] = modelFiles[i];
+		if (!roots.empty() && !roots.count(sourceName(source)))
+		{
+			//what another set of roots converted stays in the cache and on disk
+			if (incremental)
+				cache.Keep(fs::path(newpath).replace_extension(".modl"));
+			unreachable++;
+			continue;
+		}
 
-bool ConvertImage(const fs::path& input, const fs::path& output, const fs::path& rootPath)
-{
-	int texWidth, texHeight, texChannels;
+		//another shard converts the model, what its materials use still decides how this shard converts its textures
+		const std::string modelAsset = ManifestPath(fs::path(newpath).replace_extension(".modl"), rootPath);
+		if (!InShard(modelAsset, settings))
+		{
+			otherShardModels.push_back(i);
+			continue;
+		}
 
-	stbi_uc* pixels = stbi_load(input.string().c_str(), &texWidth, &texHeight, &texChannels, STBI_rgb_alpha);
+		fs::path outputDir = newpath;
+		outputDir.replace_extension();
 
-	if (!pixels) {
-		std::cout << "Failed to load texture file " << input << std::endl;
-		return false;
+		BuildCacheEntry entry;
+		entry.sources = { source };
+		entry.sources.insert(entry.sources.end(), modelSideFiles[i].begin(), modelSideFiles[i].end());
+		entry.hash = modelHashes[i];
+		entry.outputs = { outputDir.string() + ".modl", outputDir.string() + "_materials" };
+		if (incremental && cache.Reuse(entry))
+		{
+			skipped++;
+			continue;
+		}
+
+		convertedModels.push_back(entry);
+		SubmitConversion(jobs, modelJobs, EstimateModelMemory(source), [&, i]()
+			{
+				ProfileAsset profile(ManifestPath(fs::path(modelFiles[i].second).replace_extension(".modl"), rootPath));
+				ConvertMesh(modelFiles[i].first, modelFiles[i].second, rootPath, settings);
+			});
 	}
 
-	int texture_size = texWidth * texHeight * 4;
+	jobs.Wait(modelJobs);
+
+	const ModelScanCache scans(path, output, HashConverterSettings(settings));
+	for (auto& entry : convertedModels)
+	{
+		entry.textures = GetModelTextureRegistrations(entry.sources.front());
+		entry.dependencies = GetDependencyEdges(ManifestPath(entry.outputs.front(), rootPath));
+		cache.Record(entry);
+		if (settings.shardCount > 0)
+			scans.Record(ManifestPath(entry.outputs.front(), rootPath), entry.hash, entry.textures);
+		for (const auto& converted : entry.outputs)
+			addShardOutput(converted);
+	}
+
+	//models of other shards are only imported when their shard hasn't recorded them yet. Looked up after this shard's own
+	//models so shards running side by side have had the time to record theirs
+	std::vector<size_t> scannedModels;
+	for (size_t i : otherShardModels)
+	{
+		if (scans.Reuse(ManifestPath(fs::path(modelFiles[i].second).replace_extension(".modl"), rootPath), modelHashes[i]))
+			continue;
 
-	TextureInfo texinfo;
-	texinfo.textureSize = texture_size;
-	texinfo.pixelsize[0] = texWidth;
-	texinfo.pixelsize[1] = texHeight;
-	texinfo.textureFormat = TextureFormat::RGBA8;
-	texinfo.originalFile = GetRelativePathFrom(input, rootPath.string()).string();
-	AssetFile newImage = PackTexture(&texinfo, pixels);
-	newImage.checksum = checksum++;
+		scannedModels.push_back(i);
+		SubmitConversion(jobs, modelJobs, EstimateModelMemory(modelFiles[i].first), [&, i]()
+			{
+				ScanMeshMaterials(modelFiles[i].first, modelFiles[i].second, rootPath, settings);
+			});
+	}
 
-	stbi_image_free(pixels);
+	jobs.Wait(modelJobs);
 
-	newImage.SaveBinaryFile(output.string().c_str());
+	for (size_t i : scannedModels)
+		scans.Record(ManifestPath(fs::path(modelFiles[i].second).replace_extension(".modl"), rootPath), modelHashes[i], GetModelTextureRegistrations(modelFiles[i].first));
 
-	return true;
-}
+	//packed textures are known once every material has been converted
+	const auto packedTextures = GetPackedTextures();
 
+	BuildManifest manifest;
+	JobCounter textureJobs;
 
-int main(int argc, char** argv)
-{
-	std::unordered_set<std::string> textureExtensions =
+	std::vector<BuildCacheEntry> textureEntries;
+	for (size_t i = 0; i < textureFiles.size(); ++i)
 	{
-		".png",
-		".jpg",
-		".jpeg",
-		".bmp"
-	};
-
-	std::unordered_set<std::string> modelExtensions =
+		BuildCacheEntry entry;
+		entry.sources = { textureFiles[i].first };
+		entry.hash = textureHashes[i];
+		entry.role = GetTextureRole(textureFiles[i].second);
+		entry.outputs = { textureFiles[i].second };
+		textureEntries.push_back(entry);
+	}
+	for (const auto& [packedPath, sources] : packedTextures)
 	{
-		".obj",
-		".fbx",
-		".gltf"
-	};
-
-	int num_threads = std::thread::hardware_concurrency();
-	std::cout << "number of threads = " << num_threads << std::endl;
-	JobPool jobPool(num_threads);
+		BuildCacheEntry entry;
+		entry.role = TextureRole::Packed;
+		entry.outputs = { packedPath };
+		for (const auto& channel : sources.channels)
+		{
+			if (!channel.empty())
+				entry.sources.push_back(channel);
+		}
+		textureEntries.push_back(entry);
+		RegisterAsset(ManifestPath(packedPath, rootPath), AssetKind::Texture, sourceName(entry.sources.front()));
+	}
 
-	for (int i = 0; i < argc; ++i)
-		std::cout << argv[i] << '\n';
+	//with roots only the textures their materials use are converted
+	const std::unordered_set<std::string> reachable = GetReachableAssets(rootAssets);
+	std::vector<bool> textureUsed(textureEntries.size(), true);
+	for (size_t i = 0; i < textureEntries.size() && !roots.empty(); ++i)
+		textureUsed[i] = reachable.count(ManifestPath(textureEntries[i].outputs.front(), rootPath)) > 0;
 
-	const fs::path path{ argv[1] };
-	const fs::path output{ argv[2] };
+	for (const DependencyEdge& missing : GetMissingDependencies())
+		std::cout << missing.asset << " uses " << missing.dependency << " which has no source\n";
+	if (roots.empty())
+	{
+		for (const std::string& texture : GetUnreferencedAssets(AssetKind::Texture))
+			std::cout << "no material uses " << texture << "\n";
+	}
 
-	std::cout << "loading asset directory at " << path << std::endl;
+	if (incremental || settings.deduplicate)
+	{
+		jobs.ParallelFor(static_cast<uint32_t>(packedTextures.size()), [&](uint32_t i)
+			{
+				uint64_t hash = 0;
+				for (const auto& channel : packedTextures[i].second.channels)
+				{
+					hash = channel.empty() ? CombineHashes(hash, 0) : HashFileContents(channel, hash);
+				}
+				textureEntries[textureFiles.size() + i].hash = hash;
+			});
+	}
 
-	auto start = std::chrono::high_resolution_clock::now();
+	//copies of a source are found before converting, a texture's role is part of its key as it changes the output format.
+	//Unused textures keep a zero key so a used copy is never made an alias of one that isn't converted
+	std::vector<ContentKey> textureKeys;
+	for (size_t i = 0; i < textureEntries.size(); ++i)
+	{
+		const BuildCacheEntry& entry = textureEntries[i];
+		const uint64_t key = settings.deduplicate && textureUsed[i] ? CombineHashes(entry.hash, static_cast<uint64_t>(entry.role)) : 0;
+		textureKeys.push_back({ entry.outputs.front(), key });
+	}
 
-	for (auto& p : fs::recursive_directory_iterator(path))
+	for (size_t i : CollapseDuplicates(textureKeys, rootPath, manifest))
 	{
-		const fs::path rootPath = path.filename();
-		fs::path newpath = ChangeRoot(path, output, p.path());
-		fs::path newdir = newpath;
+		if (!textureUsed[i])
+		{
+			if (incremental)
+				cache.Keep(textureEntries[i].outputs.front());
+			unreachable++;
+			continue;
+		}
+		if (!InShard(ManifestPath(textureEntries[i].outputs.front(), rootPath), settings))
+			continue;
 
-		fs::create_directories(newdir.remove_filename());
+		if (incremental)
+		{
+			//moved packed textures are renamed with their sources, so only plain textures are looked for
+			const BuildCacheEntry& entry = textureEntries[i];
+			if (cache.Reuse(entry) || (i < textureFiles.size() && cache.ReuseMoved(entry)))
+			{
+				skipped++;
+				continue;
+			}
+			cache.Record(entry);
+		}
 
-		if (textureExtensions.find(p.path().extension().string()) != textureExtensions.end()) {
-			std::cout << "found a texture" << p << std::endl;
+		addShardOutput(textureEntries[i].outputs.front());
 
-			newpath.replace_extension(".tx");
-			jobPool.push([=]
+		//textures are started as the memory budget allows, block compression splits each one further
+		if (i < textureFiles.size())
+		{
+			SubmitConversion(jobs, textureJobs, EstimateTextureMemory(textureFiles[i].first), [&, i]()
 				{
-					ConvertImage(p.path(), newpath, rootPath);
+					ProfileAsset profile(ManifestPath(textureFiles[i].second, rootPath));
+					ConvertImage(textureFiles[i].first, textureFiles[i].second, rootPath, settings);
 				});
-			
 		}
-		if (modelExtensions.find(p.path().extension().string()) != modelExtensions.end())
+		else
 		{
-			std::cout << "found a mesh" << p << std::endl;
+			uint64_t estimate = 0;
+			for (const auto& channel : textureEntries[i].sources)
+				estimate = std::max(estimate, EstimateTextureMemory(channel));
 
-			newpath.replace_extension(".mesh");
-			jobPool.push([=]
+			SubmitConversion(jobs, textureJobs, estimate, [&, i]()
 				{
-					ConvertMesh(p.path(), newpath, rootPath);
+					const auto& packed = packedTextures[i - textureFiles.size()];
+					ProfileAsset profile(ManifestPath(packed.first, rootPath));
+					ConvertPackedImage(packed.first, packed.second, rootPath, settings);
 				});
 		}
 	}
 
-	jobPool.done();
+	jobs.Wait(textureJobs);
+
+	if (settings.atlasTextures)
+		BuildTextureAtlases(output, rootPath, settings, manifest);
+
+	//converted files are written in the background, the passes below read them back
+	const bool written = OutputWriter::Shared().Flush();
+	if (!written)
+		std::cout << "some converted files could not be written, what was converted this run is left out of the build cache\n";
+
+	//a shard only has its own materials, the material passes run when the shards are merged
+	if (settings.shardCount == 0)
+	{
+		//sources with different content can still pack to the same texture
+		if (settings.deduplicate)
+			DeduplicateTextures(output, rootPath, manifest);
+		RemapMaterialTextures(output, manifest);
+
+		//materials are compared once their texture paths are final
+		if (settings.deduplicate)
+			DeduplicateMaterials(output, rootPath, manifest);
+	}
+
+	if (incremental)
+	{
+		cache.UpdateAliases(manifest, rootPath);
+		cache.RemoveStaleOutputs();
+		//the next run converts them again instead of trusting missing or truncated files
+		if (!written)
+			cache.ForgetConverted();
+		cache.Save();
+		std::cout << skipped << " unchanged sources skipped\n";
+	}
+
+	if (settings.shardCount > 0 && written)
+	{
+		ShardRecord shard{ settings.shardIndex, settings.shardCount, HashConverterSettings(settings), HashShardSources(sourceNames, settings.roots), shardOutputs };
+		manifest.SetShard(shard);
+		manifest.Save(ShardManifestPath(output, settings.shardIndex, settings.shardCount));
+		std::cout << "shard " << settings.shardIndex << " of " << settings.shardCount << " converted " << shardOutputs.size() << " outputs, run with --merge once every shard is done\n";
+	}
+	else if (settings.shardCount > 0)
+	{
+		//a shard that could not write everything is not recorded, the merge reports it as not done
+		std::error_code error;
+		fs::remove(ShardManifestPath(output, settings.shardIndex, settings.shardCount), error);
+	}
+	else if (!manifest.Empty())
+	{
+		manifest.Save(output / "manifest.json");
+	}
+
+	if (!roots.empty())
+		std::cout << unreachable << " sources not reachable from the roots skipped\n";
+	//every shard knows the whole graph, the first one writes it
+	if (settings.emitGraph && settings.shardIndex == 0)
+		SaveDependencyGraph(output / "dependencies.json");
 
 	auto end = std::chrono::high_resolution_clock::now();
 	auto microseconds = std::chrono::duration_cast<std::chrono::milliseconds>(end - start);
 	std::cout << microseconds.count() << "ms to package\n";
 
+	if (settings.weldVertices)
+	{
+		std::cout << "welding removed " << weldRemovedVertices << " of " << weldInputVertices << " vertices\n";
+	}
+
+	if (ProfilingEnabled())
+	{
+		PrintProfileSummary(settings.profileSummaryCount);
+		if (WriteProfileTrace(settings.profilePath))
+			std::cout << "profile trace written to " << settings.profilePath << "\n";
+	}
+
+	//the workers, importers and texture roles of the full conversion stay for the changes that follow
+	if (settings.watch)
+		RunWatchMode(*watcher, path, output, settings, textureExtensions, modelExtensions);
+
+	return written ? 0 : 1;
 }
\ No newline at end of file
@@ -0,0 +1,146 @@
+#include "manifest.h"
+#include <fstream>
+#include "nlohmann/json.hpp"
+
+void BuildManifest::AddAtlasEntry(const std::string& texture, const AtlasEntry& entry)
+{
+	std::lock_guard<std::mutex> lock(m_lock);
+	m_atlasEntries[texture] = entry;
+}
+
+const std::unordered_map<std::string, AtlasEntry>& BuildManifest::GetAtlasEntries() const
+{
+	return m_atlasEntries;
+}
+
+void BuildManifest::AddAlias(const std::string& alias, const std::string& asset)
+{
+	std::lock_guard<std::mutex> lock(m_lock);
+
+	//a deduplication pass can remove an asset others are aliases of, chains are flattened so every alias names a stored asset
+	auto target = m_aliases.find(asset);
+	const std::string resolved = target != m_aliases.end() ? target->second : asset;
+	for (auto& [from, to] : m_aliases)
+	{
+		if (to == alias)
+			to = resolved;
+	}
+	m_aliases[alias] = resolved;
+}
+
+const std::unordered_map<std::string, std::string>& BuildManifest::GetAliases() const
+{
+	return m_aliases;
+}
+
+std::string BuildManifest::ResolveAlias(const std::string& path) const
+{
+	std::lock_guard<std::mutex> lock(m_lock);
+	auto alias = m_aliases.find(path);
+	return alias != m_aliases.end() ? alias->second : path;
+}
+
+void BuildManifest::SetShard(const ShardRecord& shard)
+{
+	std::lock_guard<std::mutex> lock(m_lock);
+	m_shard = shard;
+}
+
+const std::optional<ShardRecord>& BuildManifest::GetShard() const
+{
+	return m_shard;
+}
+
+void BuildManifest::Merge(const BuildManifest& other)
+{
+	std::scoped_lock lock(m_lock, other.m_lock);
+	m_atlasEntries.insert(other.m_atlasEntries.begin(), other.m_atlasEntries.end());
+	m_aliases.insert(other.m_aliases.begin(), other.m_aliases.end());
+}
+
+bool BuildManifest::Empty() const
+{
+	std::lock_guard<std::mutex> lock(m_lock);
+	return m_atlasEntries.empty() && m_aliases.empty();
+}
+
+bool BuildManifest::Load(const std::filesystem::path& path)
+{
+	std::ifstream file(path);
+	if (!file.is_open())
+		return false;
+
+	nlohmann::json manifest = nlohmann::json::parse(file, nullptr, false);
+	if (manifest.is_discarded())
+		return false;
+
+	std::lock_guard<std::mutex> lock(m_lock);
+	if (manifest.contains("atlases"))
+	{
+		for (const auto& [texture, atlasEntry] : manifest["atlases"].items())
+		{
+			AtlasEntry entry{ atlasEntry["atlas"].get<std::string>(), {}, -1 };
+			if (atlasEntry.contains("layer"))
+				entry.layer = atlasEntry["layer"].get<int32_t>();
+			else
+				entry.rect = atlasEntry["rect"].get<std::array<float, 4>>();
+			m_atlasEntries[texture] = entry;
+		}
+	}
+	if (manifest.contains("aliases"))
+	{
+		for (const auto& [alias, asset] : manifest["aliases"].items())
+			m_aliases[alias] = asset.get<std::string>();
+	}
+	if (manifest.contains("shard"))
+	{
+		const nlohmann::json& shard = manifest["shard"];
+		ShardRecord record;
+		record.index = shard["index"].get<uint32_t>();
+		record.count = shard["count"].get<uint32_t>();
+		record.settingsHash = shard["settings"].get<uint64_t>();
+		record.sourcesHash = shard["sources"].get<uint64_t>();
+		record.outputs = shard["outputs"].get<std::vector<std::string>>();
+		m_shard = record;
+	}
+	return true;
+}
+
+bool BuildManifest::Save(const std::filesystem::path& path) const
+{
+	std::lock_guard<std::mutex> lock(m_lock);
+
+	nlohmann::json manifest;
+
+	nlohmann::json atlases = nlohmann::json::object();
+	for (const auto& [texture, entry] : m_atlasEntries)
+	{
+		nlohmann::json atlasEntry;
+		atlasEntry["atlas"] = entry.atlas;
+		if (entry.layer >= 0)
+			atlasEntry["layer"] = entry.layer;
+		else
+			atlasEntry["rect"] = entry.rect;
+		atlases[texture] = atlasEntry;
+	}
+	manifest["atlases"] = atlases;
+	manifest["aliases"] = m_aliases;
+
+	if (m_shard)
+	{
+		nlohmann::json shard;
+		shard["index"] = m_shard->index;
+		shard["count"] = m_shard->count;
+		shard["settings"] = m_shard->settingsHash;
+		shard["sources"] = m_shard->sourcesHash;
+		shard["outputs"] = m_shard->outputs;
+		manifest["shard"] = shard;
+	}
+
+	std::ofstream file(path, std::ios::out);
+	if (!file.is_open())
+		return false;
+
+	file << manifest.dump(1, '\t');
+	return true;
+}
@@ -0,0 +1,57 @@
+#pragma once
+#include <array>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <optional>
+#include <unordered_map>
+#include <filesystem>
+
+//Where a texture ended up after atlas or array packing
+struct AtlasEntry
+{
+	std::string atlas;
+	std::array<float, 4> rect; //UV min x, min y, max x, max y
+	int32_t layer; //-1 for atlases
+};
+
+//What one process of a sharded conversion did, shards can only be merged when they converted the same sources with the same settings
+struct ShardRecord
+{
+	uint32_t index = 0;
+	uint32_t count = 0;
+	uint64_t settingsHash = 0;
+	uint64_t sourcesHash = 0; //Every source found and the roots
+	std::vector<std::string> outputs; //Relative to the output folder
+};
+
+/// <summary>
+/// Build manifest written next to the converted assets, records what the converter did with each source asset
+/// </summary>
+class BuildManifest
+{
+public:
+	void AddAtlasEntry(const std::string& texture, const AtlasEntry& entry);
+	const std::unordered_map<std::string, AtlasEntry>& GetAtlasEntries() const;
+
+	//alias is a duplicate of asset and was not written
+	void AddAlias(const std::string& alias, const std::string& asset);
+	const std::unordered_map<std::string, std::string>& GetAliases() const;
+	std::string ResolveAlias(const std::string& path) const;
+
+	//Only set in the partial manifest of a shard
+	void SetShard(const ShardRecord& shard);
+	const std::optional<ShardRecord>& GetShard() const;
+
+	//Adds the atlas entries and aliases of other
+	void Merge(const BuildManifest& other);
+
+	bool Empty() const;
+	bool Load(const std::filesystem::path& path);
+	bool Save(const std::filesystem::path& path) const;
+private:
+	mutable std::mutex m_lock;
+	std::unordered_map<std::string, AtlasEntry> m_atlasEntries; //texture path -> atlas
+	std::unordered_map<std::string, std::string> m_aliases; //duplicate path -> stored path
+	std::optional<ShardRecord> m_shard;
+};
@@ -0,0 +1,429 @@
+#include "meshProcessing.h"
+#include "core/simd.h"
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+#include <limits>
+
+using namespace Asset;
+
+namespace
+{
+	typedef std::array<float, 3> Vec3;
+
+	Vec3 Sub(const Vec3& a, const Vec3& b)
+	{
+		return { a[0] - b[0], a[1] - b[1], a[2] - b[2] };
+	}
+
+	float Dot(const Vec3& a, const Vec3& b)
+	{
+		return a[0] * b[0] + a[1] * b[1] + a[2] * b[2];
+	}
+
+	Vec3 Cross(const Vec3& a, const Vec3& b)
+	{
+		return { a[1] * b[2] - a[2] * b[1], a[2] * b[0] - a[0] * b[2], a[0] * b[1] - a[1] * b[0] };
+	}
+
+	float Length(const Vec3& a)
+	{
+		return std::sqrt(Dot(a, a));
+	}
+
+	Vec3 ReadPosition(const VertexBuffer& vertexBuffer, size_t positionOffset, uint32_t stride, uint32_t vertex)
+	{
+		Vec3 position;
+		memcpy(position.data(), &vertexBuffer.data[size_t(vertex) * stride + positionOffset], sizeof(Vec3));
+		return position;
+	}
+
+	void ComputeMeshletBounds(const Mesh& mesh, Meshlet& meshlet, size_t positionOffset, uint32_t stride)
+	{
+		std::vector<Vec3> positions(meshlet.vertexCount);
+		for (uint32_t v = 0; v < meshlet.vertexCount; ++v)
+		{
+			positions[v] = ReadPosition(mesh.vertexBuffer, positionOffset, stride, mesh.meshletVertices[meshlet.vertexOffset + v]);
+		}
+
+		//Bounding sphere, centered on the aabb
+		Vec3 min = positions[0];
+		Vec3 max = positions[0];
+		for (const Vec3& p : positions)
+		{
+			for (int i = 0; i < 3; ++i)
+			{
+				min[i] = std::min(min[i], p[i]);
+				max[i] = std::max(max[i], p[i]);
+			}
+		}
+
+		meshlet.center = { (min[0] + max[0]) * 0.5f, (min[1] + max[1]) * 0.5f, (min[2] + max[2]) * 0.5f };
+		meshlet.radius = 0.0f;
+		for (const Vec3& p : positions)
+		{
+			meshlet.radius = std::max(meshlet.radius, Length(Sub(p, meshlet.center)));
+		}
+
+		//Normal cone, built from the triangle normals (degenerate triangles are left as zero)
+		std::vector<Vec3> normals(meshlet.triangleCount, Vec3{ 0.0f, 0.0f, 0.0f });
+
+		Vec3 axis{ 0.0f, 0.0f, 0.0f };
+		for (uint32_t t = 0; t < meshlet.triangleCount; ++t)
+		{
+			const uint8_t* triangle = &mesh.meshletTriangles[meshlet.triangleOffset + t * 3];
+			const Vec3& p0 = positions[triangle[0]];
+
+			Vec3 normal = Cross(Sub(positions[triangle[1]], p0), Sub(positions[triangle[2]], p0));
+			float length = Length(normal);
+			if (length <= 0.0f)
+				continue;
+
+			normals[t] = { normal[0] / length, normal[1] / length, normal[2] / length };
+			axis = { axis[0] + normals[t][0], axis[1] + normals[t][1], axis[2] + normals[t][2] };
+		}
+
+		meshlet.coneApex = meshlet.center;
+		meshlet.coneAxis = { 0.0f, 0.0f, 0.0f };
+		meshlet.coneCutoff = 1.0f; //never culled
+
+		float axisLength = Length(axis);
+		if (axisLength <= 0.0f)
+			return;
+
+		axis = { axis[0] / axisLength, axis[1] / axisLength, axis[2] / axisLength };
+
+		float minDot = 1.0f;
+		for (const Vec3& normal : normals)
+		{
+			if (Dot(normal, normal) > 0.0f)
+				minDot = std::min(minDot, Dot(normal, axis));
+		}
+
+		//the normals span more than a hemisphere (with some slack), the cone would never cull anything
+		if (minDot <= 0.1f)
+			return;
+
+		//move the apex back along the axis so every triangle plane is in front of it
+		float maxT = 0.0f;
+		for (uint32_t t = 0; t < meshlet.triangleCount; ++t)
+		{
+			if (Dot(normals[t], normals[t]) <= 0.0f)
+				continue;
+
+			const Vec3& p0 = positions[mesh.meshletTriangles[meshlet.triangleOffset + t * 3]];
+			float dc = Dot(Sub(meshlet.center, p0), normals[t]);
+			float dn = Dot(axis, normals[t]);
+
+			maxT = std::max(maxT, dc / dn);
+		}
+
+		meshlet.coneApex = { meshlet.center[0] - axis[0] * maxT, meshlet.center[1] - axis[1] * maxT, meshlet.center[2] - axis[2] * maxT };
+		meshlet.coneAxis = axis;
+		meshlet.coneCutoff = std::sqrt(1.0f - minDot * minDot);
+	}
+	float GetWeldTolerance(VertexDataType type, const WeldSettings& settings)
+	{
+		switch (type)
+		{
+		case VertexDataType::PositionFloat2:
+		case VertexDataType::PositionFloat3:
+			return settings.positionTolerance;
+		case VertexDataType::NormalFloat3:
+			return settings.normalTolerance;
+		case VertexDataType::ColorFloat2:
+		case VertexDataType::ColorFloat3:
+		case VertexDataType::TexCoordFloat2:
+			return settings.texCoordTolerance;
+		}
+
+		return 0.0f;
+	}
+
+	//64 bit so large world space positions don't wrap onto each other at small tolerances
+	int64_t Quantize(float value, float tolerance)
+	{
+		if (tolerance <= 0.0f)
+		{
+			int32_t bits;
+			memcpy(&bits, &value, sizeof(float));
+			return value == 0.0f ? 0 : bits; //treat -0 and +0 as equal
+		}
+
+		//clamped so llround stays in range, only values beyond any real mesh extent can share the limit
+		constexpr double limit = static_cast<double>(1ll << 62);
+		const double steps = static_cast<double>(value) / tolerance;
+		return std::llround(std::clamp(steps, -limit, limit));
+	}
+
+	uint64_t HashQuantizedVertex(const int64_t* vertex, size_t count)
+	{
+		uint64_t hash = 0xcbf29ce484222325ull;
+		for (size_t i = 0; i < count; ++i)
+		{
+			hash ^= static_cast<uint64_t>(vertex[i]);
+			hash *= 0x100000001b3ull;
+			hash ^= hash >> 29;
+		}
+
+		return hash;
+	}
+}
+
+void BuildMeshlets(Mesh& mesh, uint32_t maxVertices, uint32_t maxTriangles)
+{
+	mesh.meshlets.clear();
+	mesh.meshletVertices.clear();
+	mesh.meshletTriangles.clear();
+
+	if (mesh.indexBuffer.empty() || !mesh.vertexBuffer.HasAttribute(VertexDataType::PositionFloat3))
+		return;
+
+	const size_t positionOffset = mesh.vertexBuffer.GetAttributeOffset(VertexDataType::PositionFloat3);
+	const uint32_t stride = mesh.vertexBuffer.GetAttributeStride(VertexDataType::PositionFloat3);
+
+	//maps a mesh vertex to its local index in the meshlet being built
+	constexpr uint8_t notInMeshlet = std::numeric_limits<uint8_t>::max();
+	std::vector<uint8_t> localIndex(mesh.vertexBuffer.GetVertexCount(), notInMeshlet);
+
+	Meshlet meshlet{};
+
+	auto finishMeshlet = [&]()
+	{
+		if (meshlet.triangleCount == 0)
+			return;
+
+		for (uint32_t v = 0; v < meshlet.vertexCount; ++v)
+		{
+			localIndex[mesh.meshletVertices[meshlet.vertexOffset + v]] = notInMeshlet;
+		}
+
+		ComputeMeshletBounds(mesh, meshlet, positionOffset, stride);
+		mesh.meshlets.emplace_back(meshlet);
+
+		meshlet = Meshlet{};
+		meshlet.vertexOffset = static_cast<uint32_t>(mesh.meshletVertices.size());
+		meshlet.triangleOffset = static_cast<uint32_t>(mesh.meshletTriangles.size());
+	};
+
+	for (size_t i = 0; i + 2 < mesh.indexBuffer.size(); i += 3)
+	{
+		const uint32_t a = mesh.indexBuffer[i + 0];
+		const uint32_t b = mesh.indexBuffer[i + 1];
+		const uint32_t c = mesh.indexBuffer[i + 2];
+
+		uint32_t newVertices = (localIndex[a] == notInMeshlet) + (localIndex[b] == notInMeshlet) + (localIndex[c] == notInMeshlet);
+		if (meshlet.vertexCount + newVertices > maxVertices || meshlet.triangleCount + 1 > maxTriangles)
+			finishMeshlet();
+
+		for (uint32_t vertex : { a, b, c })
+		{
+			if (localIndex[vertex] == notInMeshlet)
+			{
+				localIndex[vertex] = static_cast<uint8_t>(meshlet.vertexCount++);
+				mesh.meshletVertices.emplace_back(vertex);
+			}
+
+			mesh.meshletTriangles.emplace_back(localIndex[vertex]);
+		}
+
+		meshlet.triangleCount++;
+	}
+
+	finishMeshlet();
+}
+
+void ComputeMeshBounds(Mesh& mesh)
+{
+	mesh.bounds = BoundingBox{ { 0.0f, 0.0f, 0.0f }, { 0.0f, 0.0f, 0.0f } };
+	mesh.boundingSphere = BoundingSphere{ { 0.0f, 0.0f, 0.0f }, 0.0f };
+
+	const size_t vertexCount = mesh.vertexBuffer.data.empty() ? 0 : mesh.vertexBuffer.GetVertexCount();
+	if (vertexCount == 0 || !mesh.vertexBuffer.HasAttribute(VertexDataType::PositionFloat3))
+		return;
+
+	const size_t positionOffset = mesh.vertexBuffer.GetAttributeOffset(VertexDataType::PositionFloat3);
+	const uint32_t stride = mesh.vertexBuffer.GetAttributeStride(VertexDataType::PositionFloat3);
+
+#if JAAM_SIMD_SSE
+	const uint8_t* positions = mesh.vertexBuffer.data.data() + positionOffset;
+
+	//a 16 byte load of a position reads into the next attribute, only the last vertex can run past the end of the buffer
+	const size_t bufferEnd = mesh.vertexBuffer.data.size() - positionOffset;
+	auto loadPosition = [&](size_t v) -> __m128
+	{
+		const float* p = reinterpret_cast<const float*>(positions + v * stride);
+		if (v * stride + sizeof(float) * 4 <= bufferEnd)
+			return _mm_loadu_ps(p);
+
+		return _mm_setr_ps(p[0], p[1], p[2], 0.0f);
+	};
+
+	__m128 min = loadPosition(0);
+	__m128 max = min;
+	for (size_t v = 1; v < vertexCount; ++v)
+	{
+		__m128 p = loadPosition(v);
+		min = _mm_min_ps(min, p);
+		max = _mm_max_ps(max, p);
+	}
+
+	alignas(16) float minValues[4];
+	alignas(16) float maxValues[4];
+	_mm_store_ps(minValues, min);
+	_mm_store_ps(maxValues, max);
+
+	const __m128 center = _mm_mul_ps(_mm_add_ps(min, max), _mm_set1_ps(0.5f));
+
+	//squared distances to the center, 4 vertices at a time after transposing to x/y/z lanes
+	const __m128 centerX = _mm_shuffle_ps(center, center, _MM_SHUFFLE(0, 0, 0, 0));
+	const __m128 centerY = _mm_shuffle_ps(center, center, _MM_SHUFFLE(1, 1, 1, 1));
+	const __m128 centerZ = _mm_shuffle_ps(center, center, _MM_SHUFFLE(2, 2, 2, 2));
+
+	__m128 maxDistance = _mm_setzero_ps();
+	size_t v = 0;
+	for (; v + 4 <= vertexCount; v += 4)
+	{
+		__m128 p0 = loadPosition(v + 0);
+		__m128 p1 = loadPosition(v + 1);
+		__m128 p2 = loadPosition(v + 2);
+		__m128 p3 = loadPosition(v + 3);
+		_MM_TRANSPOSE4_PS(p0, p1, p2, p3);
+
+		const __m128 dx = _mm_sub_ps(p0, centerX);
+		const __m128 dy = _mm_sub_ps(p1, centerY);
+		const __m128 dz = _mm_sub_ps(p2, centerZ);
+		const __m128 distance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz));
+		maxDistance = _mm_max_ps(maxDistance, distance);
+	}
+
+	alignas(16) float distances[4];
+	_mm_store_ps(distances, maxDistance);
+	float maxSquaredDistance = std::max(std::max(distances[0], distances[1]), std::max(distances[2], distances[3]));
+
+	alignas(16) float centerValues[4];
+	_mm_store_ps(centerValues, center);
+	const Vec3 sphereCenter{ centerValues[0], centerValues[1], centerValues[2] };
+
+	for (; v < vertexCount; ++v)
+	{
+		const Vec3 d = Sub(ReadPosition(mesh.vertexBuffer, positionOffset, stride, static_cast<uint32_t>(v)), sphereCenter);
+		maxSquaredDistance = std::max(maxSquaredDistance, Dot(d, d));
+	}
+
+	mesh.bounds.min = { minValues[0], minValues[1], minValues[2] };
+	mesh.bounds.max = { maxValues[0], maxValues[1], maxValues[2] };
+	mesh.boundingSphere.center = sphereCenter;
+	mesh.boundingSphere.radius = std::sqrt(maxSquaredDistance);
+#else
+	Vec3 min = ReadPosition(mesh.vertexBuffer, positionOffset, stride, 0);
+	Vec3 max = min;
+	for (size_t v = 1; v < vertexCount; ++v)
+	{
+		const Vec3 p = ReadPosition(mesh.vertexBuffer, positionOffset, stride, static_cast<uint32_t>(v));
+		for (int i = 0; i < 3; ++i)
+		{
+			min[i] = std::min(min[i], p[i]);
+			max[i] = std::max(max[i], p[i]);
+		}
+	}
+
+	const Vec3 center{ (min[0] + max[0]) * 0.5f, (min[1] + max[1]) * 0.5f, (min[2] + max[2]) * 0.5f };
+	float maxSquaredDistance = 0.0f;
+	for (size_t v = 0; v < vertexCount; ++v)
+	{
+		const Vec3 d = Sub(ReadPosition(mesh.vertexBuffer, positionOffset, stride, static_cast<uint32_t>(v)), center);
+		maxSquaredDistance = std::max(maxSquaredDistance, Dot(d, d));
+	}
+
+	mesh.bounds.min = min;
+	mesh.bounds.max = max;
+	mesh.boundingSphere.center = center;
+	mesh.boundingSphere.radius = std::sqrt(maxSquaredDistance);
+#endif
+}
+
+size_t WeldVertices(Mesh& mesh, const WeldSettings& settings)
+{
+	VertexBuffer& vertexBuffer = mesh.vertexBuffer;
+	const size_t vertexCount = vertexBuffer.data.empty() ? 0 : vertexBuffer.GetVertexCount();
+	if (vertexCount == 0 || !vertexBuffer.interleaved)
+		return 0;
+
+	const uint32_t stride = vertexBuffer.GetStride();
+	const size_t components = stride / sizeof(float);
+
+	//quantize every float of every vertex to the tolerance of its attribute
+	std::vector<float> tolerances;
+	tolerances.reserve(components);
+	for (VertexDataType type : vertexBuffer.inputTypes)
+	{
+		tolerances.insert(tolerances.end(), GetVertexDataTypeSize(type) / sizeof(float), GetWeldTolerance(type, settings));
+	}
+
+	std::vector<int64_t> quantized(vertexCount * components);
+	for (size_t v = 0; v < vertexCount; ++v)
+	{
+		const uint8_t* vertex = &vertexBuffer.data[v * stride];
+		for (size_t c = 0; c < components; ++c)
+		{
+			float value;
+			memcpy(&value, vertex + c * sizeof(float), sizeof(float));
+			quantized[v * components + c] = Quantize(value, tolerances[c]);
+		}
+	}
+
+	//open addressing table of output vertex indices keyed by the quantized vertex
+	size_t tableSize = 1;
+	while (tableSize < vertexCount * 2)
+		tableSize <<= 1;
+
+	constexpr uint32_t emptySlot = std::numeric_limits<uint32_t>::max();
+	std::vector<uint32_t> table(tableSize, emptySlot);
+	std::vector<uint32_t> remap(vertexCount);
+	std::vector<uint32_t> uniqueVertices; //output index -> first source vertex
+	uniqueVertices.reserve(vertexCount);
+
+	for (size_t v = 0; v < vertexCount; ++v)
+	{
+		const int64_t* key = &quantized[v * components];
+		size_t slot = HashQuantizedVertex(key, components) & (tableSize - 1);
+
+		while (true)
+		{
+			if (table[slot] == emptySlot)
+			{
+				table[slot] = static_cast<uint32_t>(uniqueVertices.size());
+				remap[v] = table[slot];
+				uniqueVertices.emplace_back(static_cast<uint32_t>(v));
+				break;
+			}
+
+			const int64_t* other = &quantized[size_t(uniqueVertices[table[slot]]) * components];
+			if (memcmp(key, other, components * sizeof(int64_t)) == 0)
+			{
+				remap[v] = table[slot];
+				break;
+			}
+
+			slot = (slot + 1) & (tableSize - 1);
+		}
+	}
+
+	if (uniqueVertices.size() == vertexCount)
+		return 0;
+
+	std::vector<uint8_t> weldedData(uniqueVertices.size() * stride);
+	for (size_t i = 0; i < uniqueVertices.size(); ++i)
+	{
+		memcpy(&weldedData[i * stride], &vertexBuffer.data[size_t(uniqueVertices[i]) * stride], stride);
+	}
+	vertexBuffer.data = std::move(weldedData);
+
+	for (uint32_t& index : mesh.indexBuffer)
+	{
+		index = remap[index];
+	}
+
+	return vertexCount - uniqueVertices.size();
+}
@@ -0,0 +1,20 @@
+#pragma once
+#include "assetModel.h"
+
+//Splits the mesh into meshlets of at most maxVertices/maxTriangles and computes their culling bounds
+void BuildMeshlets(Asset::Mesh& mesh, uint32_t maxVertices, uint32_t maxTriangles);
+
+
+//Computes the local space aabb and bounding sphere of the mesh positions
+void ComputeMeshBounds(Asset::Mesh& mesh);
+
+struct WeldSettings
+{
+	float positionTolerance;
+	float normalTolerance;
+	float texCoordTolerance;
+};
+
+//Merges vertices whose quantized attributes are identical and remaps the index buffer, returns the number of removed vertices
+//Only interleaved vertex buffers are welded
+size_t WeldVertices(Asset::Mesh& mesh, const WeldSettings& settings);
@@ -3,6 +3,9 @@
 #include <fstream>
 #include <regex>
 #include <functional>
+#include <memory>
+#include <algorithm>
+#include <cctype>
 #include <stdlib.h>
 
 #include <assimp/Importer.hpp>
@@ -12,257 +15,491 @@
 
 #include "jaam.h"
 #include "util.h"
+#include "meshProcessing.h"
+#include "textureProcessing.h"
+#include "jobSystem.h"
+#include "pipeline.h"
+#include "profiler.h"
+#include "outputWriter.h"
+#include "dependencyGraph.h"
+#include "deduplication.h"
+#include "nlohmann/json.hpp"
 
 using namespace Asset;
 
-extern std::atomic<uint16_t> checksum;
+std::atomic<uint64_t> weldInputVertices = 0;
+std::atomic<uint64_t> weldRemovedVertices = 0;
 
 namespace
 {
+	//Importers are kept per thread, creating one sets up the loader of every format. A thread that helps with other jobs while
+	//it waits can start another import, so it keeps as many as it ever had in use at once
+	thread_local std::vector<std::unique_ptr<Assimp::Importer>> idleImporters;
+
+	class PooledImporter
+	{
+	public:
+		PooledImporter()
+		{
+			if (idleImporters.empty())
+			{
+				m_importer = std::make_unique<Assimp::Importer>();
+			}
+			else
+			{
+				m_importer = std::move(idleImporters.back());
+				idleImporters.pop_back();
+			}
+		}
+
+		~PooledImporter()
+		{
+			m_importer->FreeScene();
+			idleImporters.push_back(std::move(m_importer));
+		}
+
+		PooledImporter(const PooledImporter&) = delete;
+		PooledImporter& operator=(const PooledImporter&) = delete;
+
+		Assimp::Importer* operator->() const
+		{
+			return m_importer.get();
+		}
+	private:
+		std::unique_ptr<Assimp::Importer> m_importer;
+	};
+
 	std::string AssimpMaterialName(const aiScene* scene, int materialIndex)
 	{
 		std::string matname = "MAT_" + std::to_string(materialIndex) + "_" + std::string{ scene->mMaterials[materialIndex]->GetName().C_Str() };
 		return matname;
 	}
 
-	bool ConvertAssimpMaterials(const aiScene* scene, const fs::path& input, const fs::path& outputFolder, const fs::path& rootPath)
+	TextureRole TextureRoleFromType(const std::string& typeName)
 	{
-		for (unsigned int m = 0; m < scene->mNumMaterials; m++) {
-			std::string matname = AssimpMaterialName(scene, m);
+		if (typeName == "baseColor")
+			return TextureRole::BaseColor;
+		if (typeName == "normal")
+			return TextureRole::Normal;
+		if (typeName == "spec")
+			return TextureRole::Spec;
+		if (typeName == "alpha")
+			return TextureRole::Alpha;
+		if (typeName == "roughness")
+			return TextureRole::Roughness;
+		if (typeName == "occlusion")
+			return TextureRole::Occlusion;
+		return TextureRole::Unknown;
+	}
 
-			MaterialInfo newMaterial;
-			newMaterial.name = scene->mMaterials[m]->GetName().C_Str();
-			newMaterial.baseEffect = "default";
+	//Packs the spec, roughness and occlusion maps of a material into the R, G and B channels of one texture
+	void PackMaterialTextures(MaterialInfo& material, const std::unordered_map<std::string, std::pair<fs::path, fs::path>>& textureFiles, const fs::path& input, const fs::path& rootPath)
+	{
+		static const std::array<std::string, 3> packedTypes = { "spec", "roughness", "occlusion" };
+
+		PackedTextureSources sources;
+		fs::path packedPath;
+		std::string packedName;
+		uint32_t sourceCount = 0;
+		for (size_t c = 0; c < packedTypes.size(); ++c)
+		{
+			auto file = textureFiles.find(packedTypes[c]);
+			if (file == textureFiles.end())
+				continue;
 
-			aiMaterial* material = scene->mMaterials[m];
-			newMaterial.transparency = TransparencyMode::Opaque;
-			for (unsigned int p = 0; p < material->mNumProperties; p++)
+			sources.channels[c] = file->second.first;
+			if (packedPath.empty())
+				packedPath = file->second.second.parent_path();
+
+			packedName += file->second.first.stem().string() + "_";
+			sourceCount++;
+		}
+
+		//nothing to gain from a single map
+		if (sourceCount < 2)
+			return;
+
+		//named after the sources so materials using the same maps share the texture
+		packedPath /= packedName + "packed.tx";
+		RegisterTextureRole(packedPath, TextureRole::Packed, input);
+		RegisterPackedTexture(packedPath, sources, input);
+
+		const std::string relativePath = GetRelativePathFrom(packedPath, rootPath.string()).string();
+		for (uint32_t c = 0; c < packedTypes.size(); ++c)
+		{
+			if (sources.channels[c].empty())
+				continue;
+
+			material.textures[packedTypes[c]] = relativePath;
+			material.textureChannels[packedTypes[c]] = c;
+		}
+	}
+
+	void ConvertAssimpMaterial(const aiScene* scene, unsigned int m, const fs::path& input, const fs::path& outputFolder, const fs::path& rootPath, const std::string& modelAsset, const ConverterSettings& settings, bool write)
+	{
+		std::string matname = AssimpMaterialName(scene, m);
+
+		MaterialInfo newMaterial;
+		newMaterial.name = scene->mMaterials[m]->GetName().C_Str();
+		newMaterial.baseEffect = "default";
+
+		aiMaterial* material = scene->mMaterials[m];
+		newMaterial.transparency = TransparencyMode::Opaque;
+		for (unsigned int p = 0; p < material->mNumProperties; p++)
+		{
+			aiMaterialProperty* pt = material->mProperties[p];
+			switch (pt->mType)
+			{
+			case aiPTI_Float:
 			{
-				aiMaterialProperty* pt = material->mProperties[p];
-				switch (pt->mType)
-				{
-				case aiPTI_Float:
-				{
 
-					if (strcmp(pt->mKey.C_Str(), "$mat.opacity") == 0)
+				if (strcmp(pt->mKey.C_Str(), "$mat.opacity") == 0)
+				{
+					float num = *(float*)pt->mData;
+					if (num != 1.0)
 					{
-						float num = *(float*)pt->mData;
-						if (num != 1.0)
-						{
-							newMaterial.transparency = TransparencyMode::Transparent;
-						}
+						newMaterial.transparency = TransparencyMode::Transparent;
 					}
 				}
-				break;
-				}
 			}
+			break;
+			}
+		}
 
 
-			//Convert the assimp texture types to our own format and add them to the matieral
-			std::unordered_map<std::string, std::vector<aiTextureType>> textureTypeMap;
-			textureTypeMap.emplace("baseColor", std::vector<aiTextureType>
-			{
-				aiTextureType_DIFFUSE,
-				aiTextureType_BASE_COLOR 
-			});
+		//Convert the assimp texture types to our own format and add them to the matieral
+		std::unordered_map<std::string, std::vector<aiTextureType>> textureTypeMap;
+		textureTypeMap.emplace("baseColor", std::vector<aiTextureType>
+		{
+			aiTextureType_DIFFUSE,
+			aiTextureType_BASE_COLOR 
+		});
 
-			textureTypeMap.emplace("spec", std::vector<aiTextureType>
-			{
-				aiTextureType_SPECULAR,
-				aiTextureType_METALNESS
-			});
+		textureTypeMap.emplace("spec", std::vector<aiTextureType>
+		{
+			aiTextureType_SPECULAR,
+			aiTextureType_METALNESS
+		});
 
-			textureTypeMap.emplace("normal", std::vector<aiTextureType>
-			{
-				aiTextureType_NORMALS,
-				aiTextureType_NORMAL_CAMERA,
-			});
+		textureTypeMap.emplace("normal", std::vector<aiTextureType>
+		{
+			aiTextureType_NORMALS,
+			aiTextureType_NORMAL_CAMERA,
+		});
 
-			textureTypeMap.emplace("alpha", std::vector<aiTextureType>
-			{
-				aiTextureType_OPACITY,
-			});
+		textureTypeMap.emplace("alpha", std::vector<aiTextureType>
+		{
+			aiTextureType_OPACITY,
+		});
 
+		textureTypeMap.emplace("roughness", std::vector<aiTextureType>
+		{
+			aiTextureType_DIFFUSE_ROUGHNESS,
+		});
 
-			for (const auto& textureType : textureTypeMap)
-			{
-				const std::string& typeName = textureType.first;
+		textureTypeMap.emplace("occlusion", std::vector<aiTextureType>
+		{
+			aiTextureType_AMBIENT_OCCLUSION,
+			aiTextureType_LIGHTMAP,
+		});
 
-				for (const auto& typeEnum : textureType.second)
+		std::unordered_map<std::string, std::pair<fs::path, fs::path>> textureFiles; // name/type -> source image, output texture
+
+		for (const auto& textureType : textureTypeMap)
+		{
+			const std::string& typeName = textureType.first;
+
+			for (const auto& typeEnum : textureType.second)
+			{
+				//check opacity
+				std::string texPath = "";
+				if (material->GetTextureCount(typeEnum))
 				{
-					//check opacity
-					std::string texPath = "";
-					if (material->GetTextureCount(typeEnum))
-					{
-						aiString assimppath;
-						material->GetTexture(typeEnum, 0, &assimppath);
+					aiString assimppath;
+					material->GetTexture(typeEnum, 0, &assimppath);
 
-						fs::path texturePath = &assimppath.data[0];
-						texPath = texturePath.string();
-					}
+					fs::path texturePath = &assimppath.data[0];
+					texPath = texturePath.string();
+				}
 
-					if (!texPath.empty())
-					{
-						fs::path baseColorPath = outputFolder.parent_path() / texPath;
+				if (!texPath.empty())
+				{
+					fs::path baseColorPath = outputFolder.parent_path() / texPath;
 
-						baseColorPath.replace_extension(".tx");
-						baseColorPath = GetRelativePathFrom(baseColorPath, rootPath.string());
+					baseColorPath.replace_extension(".tx");
+					RegisterTextureRole(baseColorPath, TextureRoleFromType(typeName), input);
+					textureFiles[typeName] = { input.parent_path() / texPath, baseColorPath };
+					baseColorPath = GetRelativePathFrom(baseColorPath, rootPath.string());
 
-						newMaterial.textures[typeName] = baseColorPath.string();
-						break; //Texture found
-					}
+					newMaterial.textures[typeName] = baseColorPath.string();
+					break; //Texture found
 				}
 			}
+		}
+
+		if (settings.packTextureChannels)
+			PackMaterialTextures(newMaterial, textureFiles, input, rootPath);
 
-			//convert material parameters (e.g shininess)
-			float shininess;
-			if (aiGetMaterialFloat(material, AI_MATKEY_SHININESS, &shininess) == AI_SUCCESS)
+		//convert material parameters (e.g shininess)
+		float shininess;
+		if (aiGetMaterialFloat(material, AI_MATKEY_SHININESS, &shininess) == AI_SUCCESS)
+		{
+			newMaterial.floatParamters["shininess"] = shininess;
+		}
+		float shininessStrength;
+		if (aiGetMaterialFloat(material, AI_MATKEY_SHININESS_STRENGTH, &shininessStrength) == AI_SUCCESS)
+		{
+			newMaterial.floatParamters["specularStrength"] = shininessStrength;
+		}
+		aiColor4D spec_color;
+		if (aiGetMaterialColor(material, AI_MATKEY_COLOR_SPECULAR, &spec_color) == AI_SUCCESS)
+		{
+			std::array<float, 4> color;
+			memcpy(color.data(), &spec_color[0], 16);
+			newMaterial.vec4Paramters["specularColour"] = color;
+
+		}
+
+		fs::path materialPath = outputFolder / (matname + ".mat");
+
+		//the model uses the material, the material uses its textures
+		const std::string materialAsset = ManifestPath(materialPath, rootPath);
+		RegisterAsset(materialAsset, AssetKind::Material);
+		RegisterDependency(DependencyEdge{ modelAsset, materialAsset, AssetKind::Material });
+		for (const auto& [type, texture] : newMaterial.textures)
+			RegisterDependency(DependencyEdge{ materialAsset, fs::path(texture).lexically_normal().generic_string(), AssetKind::Texture });
+
+		if (!write)
+			return;
+
+		AssetFile newFile = PackMaterial(newMaterial);
+
+		//save to disk
+		ProfileScope profile(ProfileStage::Write);
+		ProfileOutputBytes(OutputWriter::Shared().WriteAsset(materialPath.string(), newFile));
+	}
+
+	//Without write the materials are only registered, for models converted by another shard
+	bool ConvertAssimpMaterials(const aiScene* scene, const fs::path& input, const fs::path& outputFolder, const fs::path& rootPath, const std::string& modelAsset, const ConverterSettings& settings, bool write = true)
+	{
+		//materials are independent, each one is a sub-job of the model
+		const std::string* profileAsset = CurrentProfileAsset();
+		JobSystem::Shared().ParallelFor(scene->mNumMaterials, [&](uint32_t m)
 			{
-				newMaterial.floatParamters["shininess"] = shininess;
-			}
-			float shininessStrength;
-			if (aiGetMaterialFloat(material, AI_MATKEY_SHININESS_STRENGTH, &shininessStrength) == AI_SUCCESS)
+				ProfileAssetContext profile(profileAsset);
+				ConvertAssimpMaterial(scene, m, input, outputFolder, rootPath, modelAsset, settings, write);
+			}, scene->mNumMaterials);
+		return true;
+	}
+
+	Mesh ConvertAssimpMesh(const aiMesh* aiMesh, const ConverterSettings& settings)
+	{
+		Mesh mesh;
+		mesh.vertexBuffer.inputTypes =
+		{
+			VertexDataType::PositionFloat3,
+			VertexDataType::NormalFloat3,
+			VertexDataType::TexCoordFloat2
+		};
+		mesh.vertexBuffer.interleaved = true;
+		uint32_t stride = mesh.vertexBuffer.GetStride();
+
+		mesh.vertexBuffer.data.resize(aiMesh->mNumVertices * stride);
+		for (unsigned int v = 0; v < aiMesh->mNumVertices; v++)
+		{
+			size_t index = v * stride;
+			memcpy(&mesh.vertexBuffer.data[index], &aiMesh->mVertices[v], sizeof(float) * 3);
+			index += sizeof(float) * 3;
+
+			memcpy(&mesh.vertexBuffer.data[index], &aiMesh->mNormals[v], sizeof(float) * 3);
+			index += sizeof(float) * 3;
+
+			if (aiMesh->GetNumUVChannels() >= 1)
 			{
-				newMaterial.floatParamters["specularStrength"] = shininessStrength;
+				memcpy(&mesh.vertexBuffer.data[index], &aiMesh->mTextureCoords[0][v], sizeof(float) * 2);
+				index += sizeof(float) * 2;
 			}
-			aiColor4D spec_color;
-			if (aiGetMaterialColor(material, AI_MATKEY_COLOR_SPECULAR, &spec_color) == AI_SUCCESS)
-			{
-				std::array<float, 4> color;
-				memcpy(color.data(), &spec_color[0], 16);
-				newMaterial.vec4Paramters["specularColour"] = color;
-
+			else {
+				mesh.vertexBuffer.data.at(index++) = 0;
+				mesh.vertexBuffer.data.at(index++) = 0;
 			}
+		}
 
-			fs::path materialPath = outputFolder / (matname + ".mat");
-
-			AssetFile newFile = PackMaterial(newMaterial);
+		mesh.indexBuffer.resize(aiMesh->mNumFaces * 3);
+		for (unsigned int f = 0; f < aiMesh->mNumFaces; f++)
+		{
+			mesh.indexBuffer[f * 3 + 0] = aiMesh->mFaces[f].mIndices[0];
+			mesh.indexBuffer[f * 3 + 1] = aiMesh->mFaces[f].mIndices[1];
+			mesh.indexBuffer[f * 3 + 2] = aiMesh->mFaces[f].mIndices[2];
+		}
 
-			//save to disk
-			newFile.SaveBinaryFile(materialPath.string().c_str());
+		if (settings.weldVertices)
+		{
+			WeldSettings weldSettings{ settings.weldPositionTolerance, settings.weldNormalTolerance, settings.weldTexCoordTolerance };
+			weldInputVertices += aiMesh->mNumVertices;
+			weldRemovedVertices += WeldVertices(mesh, weldSettings);
 		}
-		return true;
+
+		ComputeMeshBounds(mesh);
+
+		if (settings.generateMeshlets)
+			BuildMeshlets(mesh, settings.meshletMaxVertices, settings.meshletMaxTriangles);
+
+		//processing above works on interleaved vertices, split into streams last
+		if (settings.separateVertexStreams)
+			mesh.vertexBuffer.Deinterleave();
+
+		return mesh;
 	}
 
-	bool ConvertNodes(const aiScene* scene, const fs::path& input, const fs::path& outputFolder, const fs::path& rootPath)
+	ModelInfo ConvertNodes(const aiScene* scene, const fs::path& outputFolder, const fs::path& rootPath, const ConverterSettings& settings)
 	{
 		ModelInfo model;
 
-		glm::mat4 ident{ 1.f };
-
-		std::array<float, 16> identityMatrix;
-		memcpy(&identityMatrix, &ident, sizeof(glm::mat4));
+		std::unordered_map<unsigned int, uint32_t> meshTableIndices; //assimp mesh index -> mesh table index
+		std::vector<const aiMesh*> meshSources; //mesh table index -> assimp mesh, converted once the table is known
 
-		uint64_t lastNode = 0;
-		std::function<void(aiNode* node, aiMatrix4x4& parentmat, uint64_t)> process_node = [&](aiNode* node, aiMatrix4x4& parentmat, uint64_t parentID) 
+		//Nodes are written depth first so parents always come before their children. Assimp nodes without meshes are not written,
+		//their transform is folded into the local transform of the nodes below them
+		std::function<void(aiNode* node, const aiMatrix4x4& parentmat, int32_t)> process_node = [&](aiNode* node, const aiMatrix4x4& parentmat, int32_t parentID)
 		{
-			aiMatrix4x4 node_mat = /*parentmat * */node->mTransformation;
-
-			uint64_t nodeindex = lastNode;
+			aiMatrix4x4 node_mat = parentmat * node->mTransformation;
 
-			if (node->mNumMeshes == 0)
-				lastNode++;
+			int32_t nodeindex = parentID;
 
 			//TODO treat each mesh as a child node to the parent
 			for (unsigned int msh = 0; msh < node->mNumMeshes; msh++)
 			{
-				nodeindex = lastNode;
-				lastNode++;
+				nodeindex = static_cast<int32_t>(model.meshNames.size());
 
 				auto aiMesh = scene->mMeshes[node->mMeshes[msh]];
 
-
-				if (parentID > 0)
+				model.nodeParents.emplace_back(parentID);
+				if (parentID >= 0)
 					model.meshParents[nodeindex] = parentID;
 
-				std::string meshName = aiMesh->mName.length > 0 ? aiMesh->mName.C_Str() : "mesh_" + nodeindex + input.filename().string();
 				model.meshNames.emplace_back(node->mName.C_Str());
 
-				model.transformMatrix.emplace_back(*reinterpret_cast<Mat4x4*>(&node->mTransformation));
-
-				Mesh mesh;
-				mesh.vertexBuffer.inputTypes =
-				{
-					VertexDataType::PositionFloat3,
-					VertexDataType::NormalFloat3,
-					VertexDataType::TexCoordFloat2
-				};
-				mesh.vertexBuffer.interleaved = true;
-				uint32_t stride = mesh.vertexBuffer.GetStride();
+				model.transformMatrix.emplace_back(*reinterpret_cast<Mat4x4*>(&node_mat));
 
 				std::string matname = AssimpMaterialName(scene, aiMesh->mMaterialIndex);
 				fs::path materialRelativePath = GetRelativePathFrom(outputFolder, rootPath.string());
 				std::string materialpath = (materialRelativePath.string() + "_materials/" + matname + ".mat");
 				model.meshMaterials.emplace_back(materialpath);
 
-				mesh.vertexBuffer.data.resize(aiMesh->mNumVertices * stride);
-				for (unsigned int v = 0; v < aiMesh->mNumVertices; v++)
+				//Nodes that share an assimp mesh reference the same entry in the mesh table
+				auto meshEntry = meshTableIndices.find(node->mMeshes[msh]);
+				if (meshEntry == meshTableIndices.end())
 				{
-					size_t index = v * stride;
-					memcpy(&mesh.vertexBuffer.data[index], &aiMesh->mVertices[v], sizeof(float) * 3);
-					index += sizeof(float) * 3;
-
-					memcpy(&mesh.vertexBuffer.data[index], &aiMesh->mNormals[v], sizeof(float) * 3);
-					index += sizeof(float) * 3;
-
-					if (aiMesh->GetNumUVChannels() >= 1)
-					{
-						memcpy(&mesh.vertexBuffer.data[index], &aiMesh->mTextureCoords[0][v], sizeof(float) * 2);
-						index += sizeof(float) * 2;
-					}
-					else {
-						mesh.vertexBuffer.data.at(index++) = 0;
-						mesh.vertexBuffer.data.at(index++) = 0;
-					}
+					meshEntry = meshTableIndices.emplace(node->mMeshes[msh], static_cast<uint32_t>(meshSources.size())).first;
+					meshSources.push_back(aiMesh);
 				}
 
-				mesh.indexBuffer.resize(aiMesh->mNumFaces * 3);
-				for (unsigned int f = 0; f < aiMesh->mNumFaces; f++)
-				{
-					mesh.indexBuffer[f * 3 + 0] = aiMesh->mFaces[f].mIndices[0];
-					mesh.indexBuffer[f * 3 + 1] = aiMesh->mFaces[f].mIndices[1];
-					mesh.indexBuffer[f * 3 + 2] = aiMesh->mFaces[f].mIndices[2];
-				}
-
-				model.meshes.emplace_back(std::move(mesh));
+				model.nodeMeshes.emplace_back(meshEntry->second);
 			}
 
+			//children of a written node are relative to it, otherwise keep accumulating
+			const aiMatrix4x4 childParentMat = nodeindex != parentID ? aiMatrix4x4() : node_mat;
+
 			for (unsigned int ch = 0; ch < node->mNumChildren; ch++)
 			{
-				process_node(node->mChildren[ch], node_mat, nodeindex);
+				process_node(node->mChildren[ch], childParentMat, nodeindex);
 			}
 		};
 
-		aiMatrix4x4 mat{};
-		glm::mat4 rootmat{ 1 };// (, rootMatrix.v);
+		process_node(scene->mRootNode, aiMatrix4x4(), -1);
 
-		for (int y = 0; y < 4; y++)
-		{
-			for (int x = 0; x < 4; x++)
+		//meshes are independent, each one is a sub-job of the model
+		model.meshes.resize(meshSources.size());
+		JobSystem::Shared().ParallelFor(static_cast<uint32_t>(meshSources.size()), [&](uint32_t i)
 			{
-				mat[x][y] = rootmat[y][x];
-			}
+				model.meshes[i] = ConvertAssimpMesh(meshSources[i], settings);
+			}, static_cast<uint32_t>(meshSources.size()));
+
+		std::vector<Mat4x4> worldTransforms;
+		model.ComputeWorldTransforms(worldTransforms);
+
+		for (size_t node = 0; node < model.GetNodeCount(); ++node)
+		{
+			model.modelSpaceBounds.emplace_back(TransformBoundingBox(model.GetNodeMesh(node).bounds, worldTransforms[node]));
 		}
 
-		process_node(scene->mRootNode, mat, 0);
+		if (settings.storeWorldTransforms)
+			model.worldMatrix = std::move(worldTransforms);
 
-		AssetFile newFile = PackModel(model);
+		BuildBVH(model.modelSpaceBounds, model.bvhNodes, model.bvhIndices);
 
-		fs::path scenefilepath = (outputFolder.parent_path()) / input.stem();
+		return model;
+	}
 
-		scenefilepath.replace_extension(".modl");
+}
 
-		newFile.checksum = checksum++;
 
-		//save to disk
-		newFile.SaveBinaryFile(scenefilepath.string().c_str());
-		return true;
+std::vector<fs::path> GetModelSideFiles(const fs::path& input)
+{
+	std::vector<fs::path> files;
+	const std::string extension = input.extension().string();
+	if (extension == ".obj")
+	{
+		//the rest of the line is the library name, as assimp reads it
+		std::ifstream obj(input);
+		std::string line;
+		while (std::getline(obj, line))
+		{
+			if (line.compare(0, 7, "mtllib ") != 0)
+				continue;
+
+			const size_t begin = line.find_first_not_of(" \t", 7);
+			const size_t end = line.find_last_not_of(" \t\r");
+			if (begin != std::string::npos && end >= begin)
+				files.push_back(input.parent_path() / line.substr(begin, end - begin + 1));
+		}
 	}
+	else if (extension == ".gltf")
+	{
+		std::ifstream gltfFile(input);
+		const nlohmann::json gltf = nlohmann::json::parse(gltfFile, nullptr, false);
+		if (gltf.is_discarded())
+			return files;
 
-}
+		for (const char* list : { "buffers", "images" })
+		{
+			if (!gltf.contains(list))
+				continue;
 
+			for (const auto& entry : gltf[list])
+			{
+				//embedded data is part of the gltf itself
+				const std::string uri = entry.value("uri", std::string());
+				if (uri.empty() || uri.compare(0, 5, "data:") == 0)
+					continue;
 
-bool ConvertMesh(const fs::path& input, const fs::path& outputFolder, const fs::path& rootPath)
+				std::string decoded;
+				for (size_t i = 0; i < uri.size(); ++i)
+				{
+					if (uri[i] == '%' && i + 2 < uri.size() && std::isxdigit(static_cast<unsigned char>(uri[i + 1])) && std::isxdigit(static_cast<unsigned char>(uri[i + 2])))
+					{
+						decoded += static_cast<char>(std::stoi(uri.substr(i + 1, 2), nullptr, 16));
+						i += 2;
+					}
+					else
+					{
+						decoded += uri[i];
+					}
+				}
+				files.push_back(input.parent_path() / decoded);
+			}
+		}
+	}
+
+	for (auto& file : files)
+		file = file.lexically_normal();
+	std::sort(files.begin(), files.end());
+	files.erase(std::unique(files.begin(), files.end()), files.end());
+	return files;
+}
+
+bool ConvertMesh(const fs::path& input, const fs::path& outputFolder, const fs::path& rootPath, const ConverterSettings& settings)
 {
 	// Check if file exists
 	std::ifstream fin(input.string().c_str());
@@ -271,8 +508,17 @@ bool ConvertMesh(const fs::path& input, const fs::path& outputFolder, const fs::
 		return false;
 	}
 
-	Assimp::Importer importer;
-	const aiScene* scene = importer.ReadFile(input.string().c_str(), aiProcessPreset_TargetRealtime_Quality | aiProcess_FlipUVs);
+	std::error_code sizeError;
+	ProfileInputBytes(fs::file_size(input, sizeError));
+
+	//assimp reads the file itself, reading and importing are one stage
+	PooledImporter importer;
+	const aiScene* scene;
+	{
+		StageScope import(PipelineStage::Decode);
+		ProfileScope profile(ProfileStage::Import);
+		scene = importer->ReadFile(input.string().c_str(), aiProcessPreset_TargetRealtime_Quality | aiProcess_FlipUVs);
+	}
 
 	fs::path outputDir = outputFolder;
 	outputDir.replace_extension();
@@ -280,7 +526,47 @@ bool ConvertMesh(const fs::path& input, const fs::path& outputFolder, const fs::
 
 	fs::create_directories(materialDir);
 
-	bool success = ConvertAssimpMaterials(scene, input, materialDir, rootPath);
-	success = ConvertNodes(scene, input, outputDir, rootPath);
-	return success;
+	fs::path scenefilepath = (outputDir.parent_path()) / input.stem();
+
+	scenefilepath.replace_extension(".modl");
+
+	ModelInfo model;
+	{
+		ProfileScope profile(ProfileStage::Process);
+		ConvertAssimpMaterials(scene, input, materialDir, rootPath, ManifestPath(scenefilepath, rootPath), settings);
+		model = ConvertNodes(scene, outputDir, rootPath, settings);
+	}
+
+	AssetFile newFile;
+	{
+		ProfileScope profile(ProfileStage::Compress);
+		newFile = PackModel(model);
+	}
+
+	//save to disk
+	ProfileScope profile(ProfileStage::Write);
+	ProfileOutputBytes(OutputWriter::Shared().WriteAsset(scenefilepath.string(), newFile));
+	return true;
+}
+
+bool ScanMeshMaterials(const fs::path& input, const fs::path& outputFolder, const fs::path& rootPath, const ConverterSettings& settings)
+{
+	//only the materials are needed, removing the redundant ones keeps their names the same as a full import
+	PooledImporter importer;
+	const aiScene* scene;
+	{
+		StageScope import(PipelineStage::Decode);
+		scene = importer->ReadFile(input.string().c_str(), aiProcess_RemoveRedundantMaterials);
+	}
+	if (!scene)
+		return false;
+
+	fs::path outputDir = outputFolder;
+	outputDir.replace_extension();
+	const fs::path materialDir = outputDir.string() + "_materials";
+
+	fs::path scenefilepath = (outputDir.parent_path()) / input.stem();
+	scenefilepath.replace_extension(".modl");
+
+	return ConvertAssimpMaterials(scene, input, materialDir, rootPath, ManifestPath(scenefilepath, rootPath), settings, false);
 }
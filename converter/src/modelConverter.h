@@ -1,4 +1,15 @@
 #pragma once
 #include <filesystem>
+#include <atomic>
+#include <vector>
+#include "converterSettings.h"
 
-bool ConvertMesh(const std::filesystem::path& input, const std::filesystem::path& outputFolder, const std::filesystem::path& rootPath);
\ No newline at end of file
+bool ConvertMesh(const std::filesystem::path& input, const std::filesystem::path& outputFolder, const std::filesystem::path& rootPath, const ConverterSettings& settings);
+//Files assimp reads next to the model: the .mtl libraries of an obj, and the buffers and images of a gltf. Sorted, they may not exist
+std::vector<std::filesystem::path> GetModelSideFiles(const std::filesystem::path& input);
+//Registers the texture roles, packed textures and dependencies of a model's materials without converting it
+bool ScanMeshMaterials(const std::filesystem::path& input, const std::filesystem::path& outputFolder, const std::filesystem::path& rootPath, const ConverterSettings& settings);
+
+//Vertex welding statistics across all converted models
+extern std::atomic<uint64_t> weldInputVertices;
+extern std::atomic<uint64_t> weldRemovedVertices;
@@ -0,0 +1,324 @@
+#include "outputWriter.h"
+#include <iostream>
+#include <fstream>
+#include <algorithm>
+
+#if __has_include(<unistd.h>) && __has_include(<fcntl.h>)
+#include <unistd.h>
+#include <fcntl.h>
+#define JAAM_PWRITE
+#endif
+
+#if defined(JAAM_IO_URING) && defined(JAAM_PWRITE)
+#include <liburing.h>
+#else
+#undef JAAM_IO_URING
+#endif
+
+using namespace Asset;
+
+namespace
+{
+#ifdef JAAM_PWRITE
+	//A file of a batch being written, written counts the bytes that are done
+	struct OpenFile
+	{
+		const std::vector<uint8_t>* data;
+		size_t written;
+		int fd;
+	};
+
+	//Largest single write, the result of a write has to fit in an int
+	constexpr size_t MaxWriteSize = size_t(1) << 30;
+
+	int OpenForWrite(const std::string& path)
+	{
+		return open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+	}
+
+	bool WriteWithPwrite(OpenFile& file)
+	{
+		while (file.written < file.data->size())
+		{
+			const size_t size = std::min(file.data->size() - file.written, MaxWriteSize);
+			const ssize_t result = pwrite(file.fd, file.data->data() + file.written, size, static_cast<off_t>(file.written));
+			if (result <= 0)
+				return false;
+			file.written += static_cast<size_t>(result);
+		}
+		return true;
+	}
+#endif
+
+#ifdef JAAM_IO_URING
+	//The ring belongs to the writer thread, it is set up on the first batch
+	thread_local struct io_uring ring;
+	thread_local uint32_t ringDepth = 0;
+	thread_local bool ringFailed = false;
+
+	bool SetupRing(uint32_t depth)
+	{
+		if (ringDepth >= depth)
+			return true;
+		if (ringFailed)
+			return false;
+
+		if (ringDepth)
+			io_uring_queue_exit(&ring);
+		ringDepth = 0;
+
+		//containers and old kernels can refuse io_uring, pwrite is used from then on
+		if (io_uring_queue_init(depth, &ring, 0) < 0)
+		{
+			ringFailed = true;
+			return false;
+		}
+		ringDepth = depth;
+		return true;
+	}
+
+	void CloseRing()
+	{
+		if (ringDepth)
+			io_uring_queue_exit(&ring);
+		ringDepth = 0;
+	}
+
+	//Writes every file of the batch, short writes are queued again for the rest of the file
+	void WriteWithRing(const std::vector<OpenFile*>& files, std::vector<bool>& failed)
+	{
+		std::deque<size_t> pending;
+		for (size_t i = 0; i < files.size(); ++i)
+			pending.push_back(i);
+
+		uint32_t inFlight = 0;
+		while (!pending.empty() || inFlight > 0)
+		{
+			while (inFlight < ringDepth && !pending.empty())
+			{
+				io_uring_sqe* sqe = io_uring_get_sqe(&ring);
+				if (!sqe)
+					break;
+
+				const size_t index = pending.front();
+				pending.pop_front();
+
+				OpenFile& file = *files[index];
+				const size_t size = std::min(file.data->size() - file.written, MaxWriteSize);
+				io_uring_prep_write(sqe, file.fd, file.data->data() + file.written, static_cast<unsigned>(size), file.written);
+				io_uring_sqe_set_data(sqe, reinterpret_cast<void*>(index));
+				inFlight++;
+			}
+
+			if (inFlight == 0)
+				break;
+			io_uring_submit_and_wait(&ring, 1);
+
+			io_uring_cqe* cqe;
+			while (io_uring_peek_cqe(&ring, &cqe) == 0)
+			{
+				const size_t index = reinterpret_cast<size_t>(io_uring_cqe_get_data(cqe));
+				const int result = cqe->res;
+				io_uring_cqe_seen(&ring, cqe);
+				inFlight--;
+
+				OpenFile& file = *files[index];
+				if (result <= 0)
+				{
+					failed[index] = true;
+					continue;
+				}
+
+				file.written += static_cast<size_t>(result);
+				if (file.written < file.data->size())
+					pending.push_back(index);
+			}
+		}
+	}
+#endif
+}
+
+OutputWriter::OutputWriter() : m_queuedBytes(0), m_writing(0), m_batchSize(16), m_queueLimit(0), m_failed(false), m_stop(false)
+{
+	m_thread = std::thread(&OutputWriter::Work, this);
+}
+
+OutputWriter::~OutputWriter()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_lock);
+		m_stop = true;
+	}
+	m_queued.notify_all();
+	m_thread.join();
+}
+
+void OutputWriter::Configure(uint32_t batchSize, uint64_t queueLimit)
+{
+	std::lock_guard<std::mutex> lock(m_lock);
+	m_batchSize = std::max(1u, batchSize);
+	m_queueLimit = queueLimit;
+}
+
+void OutputWriter::Write(const std::string& path, std::vector<uint8_t> data)
+{
+	const uint64_t size = data.size();
+	{
+		std::unique_lock<std::mutex> lock(m_lock);
+
+		//a file bigger than the limit still goes through once the queue is empty
+		m_written.wait(lock, [&]() { return m_queueLimit == 0 || m_queue.empty() || m_queuedBytes + size <= m_queueLimit; });
+
+		m_queue.push_back(PendingFile{ path, std::move(data) });
+		m_queuedBytes += size;
+	}
+	m_queued.notify_one();
+}
+
+uint64_t OutputWriter::WriteAsset(const std::string& path, AssetFile& file)
+{
+	std::vector<uint8_t> binary = file.SerializeBinary();
+	const uint64_t size = binary.size() + file.json.size();
+
+	Write(AssetFile::MetaPath(path), std::vector<uint8_t>(file.json.begin(), file.json.end()));
+	Write(path, std::move(binary));
+	return size;
+}
+
+bool OutputWriter::Flush()
+{
+	std::unique_lock<std::mutex> lock(m_lock);
+	m_written.wait(lock, [this]() { return m_queue.empty() && m_writing == 0; });
+
+	const bool succeeded = !m_failed;
+	m_failed = false;
+	return succeeded;
+}
+
+OutputWriter& OutputWriter::Shared()
+{
+	static OutputWriter writer;
+	return writer;
+}
+
+void OutputWriter::Work()
+{
+	std::vector<PendingFile> batch;
+	while (true)
+	{
+		{
+			std::unique_lock<std::mutex> lock(m_lock);
+			m_queued.wait(lock, [this]() { return m_stop || !m_queue.empty(); });
+
+			//queued files are written before the writer stops
+			if (m_queue.empty())
+				break;
+
+			//everything that is waiting goes in one batch, small files add up to few submissions
+			while (!m_queue.empty())
+			{
+				m_queuedBytes -= m_queue.front().data.size();
+				batch.emplace_back(std::move(m_queue.front()));
+				m_queue.pop_front();
+			}
+			m_writing = static_cast<uint32_t>(batch.size());
+		}
+		m_written.notify_all();
+
+		const bool succeeded = WriteBatch(batch);
+		batch.clear();
+
+		{
+			std::lock_guard<std::mutex> lock(m_lock);
+			m_writing = 0;
+			m_failed |= !succeeded;
+		}
+		m_written.notify_all();
+	}
+
+#ifdef JAAM_IO_URING
+	CloseRing();
+#endif
+}
+
+bool OutputWriter::WriteBatch(std::vector<PendingFile>& batch)
+{
+	std::vector<bool> failed(batch.size(), false);
+
+#ifdef JAAM_PWRITE
+	uint32_t batchSize;
+	{
+		std::lock_guard<std::mutex> lock(m_lock);
+		batchSize = m_batchSize;
+	}
+
+	//files are opened a batch size at a time so a big batch doesn't run out of descriptors
+	for (size_t first = 0; first < batch.size(); first += batchSize)
+	{
+		const size_t last = std::min(batch.size(), first + batchSize);
+
+		std::vector<OpenFile> files;
+		files.reserve(last - first);
+		for (size_t i = first; i < last; ++i)
+		{
+			files.push_back(OpenFile{ &batch[i].data, 0, OpenForWrite(batch[i].path) });
+			failed[i] = files.back().fd < 0;
+		}
+
+#ifdef JAAM_IO_URING
+		if (SetupRing(batchSize))
+		{
+			std::vector<OpenFile*> opened;
+			std::vector<size_t> openedIndices;
+			for (size_t i = first; i < last; ++i)
+			{
+				if (!failed[i])
+				{
+					opened.push_back(&files[i - first]);
+					openedIndices.push_back(i);
+				}
+			}
+
+			std::vector<bool> openedFailed(opened.size(), false);
+			WriteWithRing(opened, openedFailed);
+
+			for (size_t i = 0; i < opened.size(); ++i)
+				failed[openedIndices[i]] = openedFailed[i];
+		}
+		else
+#endif
+		{
+			for (size_t i = first; i < last; ++i)
+			{
+				if (!failed[i])
+					failed[i] = !WriteWithPwrite(files[i - first]);
+			}
+		}
+
+		//a failed close can be the first report of a failed write
+		for (size_t i = first; i < last; ++i)
+		{
+			if (files[i - first].fd >= 0 && close(files[i - first].fd) != 0)
+				failed[i] = true;
+		}
+	}
+#else
+	for (size_t i = 0; i < batch.size(); ++i)
+	{
+		std::ofstream file(batch[i].path, std::ios::binary | std::ios::out);
+		file.write(reinterpret_cast<const char*>(batch[i].data.data()), batch[i].data.size());
+		failed[i] = !file.good();
+	}
+#endif
+
+	bool succeeded = true;
+	for (size_t i = 0; i < batch.size(); ++i)
+	{
+		if (failed[i])
+		{
+			std::cout << "Failed to write " << batch[i].path << std::endl;
+			succeeded = false;
+		}
+	}
+	return succeeded;
+}
@@ -0,0 +1,59 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <deque>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include "assetFile.h"
+
+/// <summary>
+/// Writes converted files from a dedicated thread so jobs never wait on the disk. Each file is handed over as one buffer and the
+/// writer takes every queued file at once, submitting the batch through io_uring when the converter is built with it and the
+/// kernel allows it, otherwise with pwrite (or a stream where there is no pwrite).
+/// Queuing only blocks when more than the queue limit is waiting to be written.
+/// </summary>
+class OutputWriter
+{
+public:
+	OutputWriter();
+	~OutputWriter();
+
+	OutputWriter(const OutputWriter&) = delete;
+	OutputWriter& operator=(const OutputWriter&) = delete;
+
+	//Files written at once and the bytes that can wait in the queue (0 = unlimited), call before writing
+	void Configure(uint32_t batchSize, uint64_t queueLimit);
+
+	void Write(const std::string& path, std::vector<uint8_t> data);
+	//Queues the binary file and its .meta, returns the bytes queued
+	uint64_t WriteAsset(const std::string& path, Asset::AssetFile& file);
+
+	//Waits until everything queued is on disk, false if a write failed since the last flush
+	bool Flush();
+
+	static OutputWriter& Shared();
+private:
+	struct PendingFile
+	{
+		std::string path;
+		std::vector<uint8_t> data;
+	};
+
+	void Work();
+	bool WriteBatch(std::vector<PendingFile>& batch);
+
+	std::mutex m_lock;
+	std::condition_variable m_queued;
+	std::condition_variable m_written;
+	std::deque<PendingFile> m_queue;
+	uint64_t m_queuedBytes;
+	uint32_t m_writing; //Files taken off the queue but not written yet
+	uint32_t m_batchSize;
+	uint64_t m_queueLimit;
+	bool m_failed;
+	bool m_stop;
+
+	std::thread m_thread;
+};
@@ -0,0 +1,115 @@
+#include "pipeline.h"
+#include <array>
+#include <mutex>
+#include <condition_variable>
+#include "stb_image.h"
+#include "outputWriter.h"
+
+namespace
+{
+	//A texture is decoded to RGBA8 and processed as float texels plus the converted levels
+	constexpr uint64_t TextureMemoryFactor = 8;
+	//Assimp's scene and the converted meshes take several times the size of the file
+	constexpr uint64_t ModelMemoryFactor = 16;
+
+	struct Gate
+	{
+		std::mutex lock;
+		std::condition_variable released;
+		uint32_t limit = 1;
+		uint32_t active = 0;
+	};
+
+	std::array<Gate, static_cast<size_t>(PipelineStage::Count)> stageGates;
+
+	std::mutex budgetLock;
+	std::condition_variable budgetReleased;
+	uint64_t memoryBudget = 0;
+	uint64_t memoryInFlight = 0;
+	uint32_t conversionsInFlight = 0;
+	uint32_t queueDepth = 1;
+
+	//under budgetLock
+	bool MemoryAvailable(uint64_t bytes)
+	{
+		if (conversionsInFlight >= queueDepth)
+			return false;
+		return memoryBudget == 0 || conversionsInFlight == 0 || memoryInFlight + bytes <= memoryBudget;
+	}
+}
+
+void ConfigurePipeline(const ConverterSettings& settings)
+{
+	const uint32_t threads = JobSystem::Shared().GetWorkerCount() + 1;
+
+	stageGates[static_cast<size_t>(PipelineStage::Read)].limit = std::max(1u, settings.readJobs);
+	stageGates[static_cast<size_t>(PipelineStage::Decode)].limit = settings.decodeJobs ? settings.decodeJobs : threads;
+
+	OutputWriter::Shared().Configure(settings.writeJobs, uint64_t(settings.writeQueueMB) * 1024 * 1024);
+
+	std::lock_guard<std::mutex> lock(budgetLock);
+	memoryBudget = uint64_t(settings.memoryBudgetMB) * 1024 * 1024;
+	//enough queued work that no worker waits for the next file
+	queueDepth = threads * 2;
+}
+
+StageScope::StageScope(PipelineStage stage) : m_stage(stage)
+{
+	Gate& gate = stageGates[static_cast<size_t>(m_stage)];
+	std::unique_lock<std::mutex> lock(gate.lock);
+	gate.released.wait(lock, [&gate]() { return gate.active < gate.limit; });
+	gate.active++;
+}
+
+StageScope::~StageScope()
+{
+	Gate& gate = stageGates[static_cast<size_t>(m_stage)];
+	{
+		std::lock_guard<std::mutex> lock(gate.lock);
+		gate.active--;
+	}
+	gate.released.notify_one();
+}
+
+uint64_t EstimateTextureMemory(const std::filesystem::path& input)
+{
+	int width, height, channels;
+	if (!stbi_info(input.string().c_str(), &width, &height, &channels))
+		return 0;
+
+	return uint64_t(width) * height * 4 * TextureMemoryFactor;
+}
+
+uint64_t EstimateModelMemory(const std::filesystem::path& input)
+{
+	std::error_code error;
+	const uint64_t size = std::filesystem::file_size(input, error);
+	return error ? 0 : size * ModelMemoryFactor;
+}
+
+bool TryAcquireConversionMemory(uint64_t bytes)
+{
+	std::lock_guard<std::mutex> lock(budgetLock);
+	if (!MemoryAvailable(bytes))
+		return false;
+
+	memoryInFlight += bytes;
+	conversionsInFlight++;
+	return true;
+}
+
+void ReleaseConversionMemory(uint64_t bytes)
+{
+	{
+		std::lock_guard<std::mutex> lock(budgetLock);
+		memoryInFlight -= bytes;
+		conversionsInFlight--;
+	}
+	budgetReleased.notify_all();
+}
+
+void WaitForConversionMemory(uint64_t bytes)
+{
+	std::unique_lock<std::mutex> lock(budgetLock);
+	budgetReleased.wait(lock, [bytes]() { return MemoryAvailable(bytes); });
+}
@@ -0,0 +1,60 @@
+#pragma once
+#include <cstdint>
+#include <filesystem>
+#include "jobSystem.h"
+#include "converterSettings.h"
+
+//Stages of a conversion that are limited to a number of concurrent jobs. Processing and block compression are not gated,
+//they wait on sub-jobs and are bounded by the job system's workers. Writing is done by the OutputWriter
+enum class PipelineStage
+{
+	Read, //Reading source files
+	Decode, //Decoding images and importing models
+	Count
+};
+
+//Sets the stage limits, the memory budget and the output writer's batching from the settings, call before converting
+void ConfigurePipeline(const ConverterSettings& settings);
+
+//Holds a slot of a stage for its lifetime. Stages must only wrap work that never waits on other jobs
+class StageScope
+{
+public:
+	explicit StageScope(PipelineStage stage);
+	~StageScope();
+
+	StageScope(const StageScope&) = delete;
+	StageScope& operator=(const StageScope&) = delete;
+private:
+	PipelineStage m_stage;
+};
+
+//Rough peak memory of converting a source, taken from the image header or the model file size
+uint64_t EstimateTextureMemory(const std::filesystem::path& input);
+uint64_t EstimateModelMemory(const std::filesystem::path& input);
+
+//Takes bytes of the memory budget if they fit and fewer conversions than the queue depth are in flight.
+//A conversion bigger than the whole budget is let through once nothing else is in flight
+bool TryAcquireConversionMemory(uint64_t bytes);
+void ReleaseConversionMemory(uint64_t bytes);
+//Blocks until TryAcquireConversionMemory could succeed
+void WaitForConversionMemory(uint64_t bytes);
+
+//Runs func as a job once its memory is available, the memory is released when the job is done.
+//The caller helps with the queued jobs while it waits, so it must not be a job itself
+template <typename F>
+void SubmitConversion(JobSystem& jobs, JobCounter& counter, uint64_t estimatedBytes, const F& func)
+{
+	while (!TryAcquireConversionMemory(estimatedBytes))
+	{
+		//anything still queued holds memory, running it frees some
+		if (!jobs.RunPendingJob())
+			WaitForConversionMemory(estimatedBytes);
+	}
+
+	jobs.Run(counter, [func, estimatedBytes]()
+		{
+			func();
+			ReleaseConversionMemory(estimatedBytes);
+		});
+}
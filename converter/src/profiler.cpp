@@ -0,0 +1,241 @@
+#include "profiler.h"
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <vector>
+#include <map>
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <iomanip>
+#include "nlohmann/json.hpp"
+
+namespace
+{
+	struct ProfileEvent
+	{
+		std::string asset;
+		ProfileStage stage;
+		uint32_t thread;
+		int64_t start; //Microseconds since profiling was enabled
+		int64_t duration;
+	};
+
+	struct AssetBytes
+	{
+		uint64_t input = 0;
+		uint64_t output = 0;
+	};
+
+	constexpr std::array<const char*, static_cast<size_t>(ProfileStage::Count)> StageNames =
+	{
+		"Convert",
+		"Read",
+		"Import",
+		"Process",
+		"Compress",
+		"Write"
+	};
+
+	bool profilingEnabled = false;
+	std::chrono::steady_clock::time_point profileStart;
+
+	std::mutex profileLock;
+	std::vector<ProfileEvent> events;
+	std::map<std::string, AssetBytes> assetBytes;
+
+	std::atomic<uint32_t> nextThread = 0;
+	thread_local const std::string* currentAsset = nullptr;
+
+	int64_t Now()
+	{
+		return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - profileStart).count();
+	}
+
+	//small ids in the order threads first record something, the trace viewer shows one row per id
+	uint32_t ThreadId()
+	{
+		thread_local const uint32_t id = nextThread++;
+		return id;
+	}
+
+	double Milliseconds(int64_t microseconds)
+	{
+		return microseconds / 1000.0;
+	}
+
+	double Ratio(const AssetBytes& bytes)
+	{
+		return bytes.output ? static_cast<double>(bytes.input) / bytes.output : 0.0;
+	}
+}
+
+void EnableProfiling()
+{
+	profileStart = std::chrono::steady_clock::now();
+	profilingEnabled = true;
+}
+
+bool ProfilingEnabled()
+{
+	return profilingEnabled;
+}
+
+ProfileAssetContext::ProfileAssetContext(const std::string* asset) : m_previous(currentAsset)
+{
+	currentAsset = asset;
+}
+
+ProfileAssetContext::~ProfileAssetContext()
+{
+	currentAsset = m_previous;
+}
+
+const std::string* CurrentProfileAsset()
+{
+	return currentAsset;
+}
+
+ProfileScope::ProfileScope(ProfileStage stage) : m_stage(stage), m_asset(currentAsset), m_start(0)
+{
+	if (profilingEnabled)
+		m_start = Now();
+}
+
+ProfileScope::~ProfileScope()
+{
+	if (!profilingEnabled || !m_asset)
+		return;
+
+	ProfileEvent event{ *m_asset, m_stage, ThreadId(), m_start, Now() - m_start };
+
+	std::lock_guard<std::mutex> lock(profileLock);
+	events.emplace_back(std::move(event));
+}
+
+ProfileAsset::ProfileAsset(std::string name) : m_name(std::move(name)), m_context(&m_name), m_convert(ProfileStage::Convert)
+{
+
+}
+
+void ProfileInputBytes(uint64_t bytes)
+{
+	if (!profilingEnabled || !currentAsset)
+		return;
+
+	std::lock_guard<std::mutex> lock(profileLock);
+	assetBytes[*currentAsset].input += bytes;
+}
+
+void ProfileOutputBytes(uint64_t bytes)
+{
+	if (!profilingEnabled || !currentAsset)
+		return;
+
+	std::lock_guard<std::mutex> lock(profileLock);
+	assetBytes[*currentAsset].output += bytes;
+}
+
+bool WriteProfileTrace(const std::filesystem::path& path)
+{
+	std::lock_guard<std::mutex> lock(profileLock);
+
+	nlohmann::json traceEvents = nlohmann::json::array();
+	for (uint32_t thread = 0; thread < nextThread; ++thread)
+	{
+		traceEvents.push_back({ {"name", "thread_name"}, {"ph", "M"}, {"pid", 0}, {"tid", thread}, {"args", {{"name", "Thread " + std::to_string(thread)}}} });
+	}
+
+	for (const ProfileEvent& event : events)
+	{
+		nlohmann::json traceEvent;
+		traceEvent["ph"] = "X";
+		traceEvent["pid"] = 0;
+		traceEvent["tid"] = event.thread;
+		traceEvent["ts"] = event.start;
+		traceEvent["dur"] = event.duration;
+		traceEvent["args"]["asset"] = event.asset;
+
+		//the whole conversion is named after the asset so it reads as the parent of its stages
+		if (event.stage == ProfileStage::Convert)
+		{
+			const AssetBytes& bytes = assetBytes[event.asset];
+			traceEvent["name"] = event.asset;
+			traceEvent["cat"] = "asset";
+			traceEvent["args"]["input_bytes"] = bytes.input;
+			traceEvent["args"]["output_bytes"] = bytes.output;
+			traceEvent["args"]["compression_ratio"] = Ratio(bytes);
+		}
+		else
+		{
+			traceEvent["name"] = StageNames[static_cast<size_t>(event.stage)];
+			traceEvent["cat"] = "stage";
+		}
+		traceEvents.push_back(traceEvent);
+	}
+
+	nlohmann::json trace;
+	trace["traceEvents"] = traceEvents;
+	trace["displayTimeUnit"] = "ms";
+
+	std::ofstream file(path, std::ios::out);
+	if (!file.is_open())
+		return false;
+
+	file << trace.dump();
+	return true;
+}
+
+void PrintProfileSummary(uint32_t count)
+{
+	std::lock_guard<std::mutex> lock(profileLock);
+
+	typedef std::array<int64_t, static_cast<size_t>(ProfileStage::Count)> StageTimes;
+
+	StageTimes totals{};
+	std::map<std::string, StageTimes> assetTimes;
+	for (const ProfileEvent& event : events)
+	{
+		totals[static_cast<size_t>(event.stage)] += event.duration;
+		assetTimes[event.asset][static_cast<size_t>(event.stage)] += event.duration;
+	}
+
+	uint64_t inputBytes = 0, outputBytes = 0;
+	for (const auto& [asset, bytes] : assetBytes)
+	{
+		inputBytes += bytes.input;
+		outputBytes += bytes.output;
+	}
+
+	std::cout << std::fixed << std::setprecision(1);
+	std::cout << "profiled " << assetTimes.size() << " assets, " << inputBytes / 1024 << " KB in, " << outputBytes / 1024 << " KB out\n";
+	std::cout << "time per stage summed over all threads:\n";
+	for (size_t stage = 0; stage < totals.size(); ++stage)
+	{
+		std::cout << "  " << std::left << std::setw(10) << StageNames[stage] << std::right << std::setw(12) << Milliseconds(totals[stage]) << " ms\n";
+	}
+
+	std::vector<std::pair<std::string, const StageTimes*>> slowest;
+	for (const auto& [asset, times] : assetTimes)
+		slowest.emplace_back(asset, &times);
+
+	//stable on the name so equal times list the same way every run
+	std::stable_sort(slowest.begin(), slowest.end(), [](const auto& a, const auto& b) { return (*a.second)[0] > (*b.second)[0]; });
+	slowest.resize(std::min(slowest.size(), static_cast<size_t>(count)));
+
+	std::cout << "slowest assets (ms):\n";
+	std::cout << std::setw(10) << "total";
+	for (size_t stage = 1; stage < StageNames.size(); ++stage)
+		std::cout << std::setw(10) << StageNames[stage];
+	std::cout << std::setw(12) << "in KB" << std::setw(12) << "out KB" << std::setw(8) << "ratio" << "  asset\n";
+
+	for (const auto& [asset, times] : slowest)
+	{
+		const AssetBytes& bytes = assetBytes[asset];
+		for (int64_t time : *times)
+			std::cout << std::setw(10) << Milliseconds(time);
+		std::cout << std::setw(12) << bytes.input / 1024 << std::setw(12) << bytes.output / 1024 << std::setw(8) << std::setprecision(2) << Ratio(bytes) << std::setprecision(1) << "  " << asset << "\n";
+	}
+	std::cout << std::defaultfloat;
+}
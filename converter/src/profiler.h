@@ -0,0 +1,74 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <filesystem>
+
+//Parts of an asset's conversion that are timed. Convert covers the whole asset
+enum class ProfileStage
+{
+	Convert,
+	Read, //Reading source files
+	Import, //Decoding images and importing models
+	Process, //Mips, channel analysis, mesh processing and materials
+	Compress, //Block compression and blob compression
+	Write, //Saving converted assets
+	Count
+};
+
+//Profiling is off until enabled, enable before any conversion starts
+void EnableProfiling();
+bool ProfilingEnabled();
+
+//Sets the asset the calling thread works on, stages and bytes are recorded against it. The previous asset is restored when done.
+//Sub-jobs of an asset run on other threads and set it again with the name from CurrentProfileAsset
+class ProfileAssetContext
+{
+public:
+	explicit ProfileAssetContext(const std::string* asset);
+	~ProfileAssetContext();
+
+	ProfileAssetContext(const ProfileAssetContext&) = delete;
+	ProfileAssetContext& operator=(const ProfileAssetContext&) = delete;
+private:
+	const std::string* m_previous;
+};
+
+const std::string* CurrentProfileAsset();
+
+//Times a stage of the current asset. A thread waiting on sub-jobs helps with other jobs, so a stage can include time spent on another asset
+class ProfileScope
+{
+public:
+	explicit ProfileScope(ProfileStage stage);
+	~ProfileScope();
+
+	ProfileScope(const ProfileScope&) = delete;
+	ProfileScope& operator=(const ProfileScope&) = delete;
+private:
+	ProfileStage m_stage;
+	const std::string* m_asset;
+	int64_t m_start;
+};
+
+//Names the asset the calling thread converts and times the whole conversion
+class ProfileAsset
+{
+public:
+	explicit ProfileAsset(std::string name);
+
+	ProfileAsset(const ProfileAsset&) = delete;
+	ProfileAsset& operator=(const ProfileAsset&) = delete;
+private:
+	std::string m_name;
+	ProfileAssetContext m_context;
+	ProfileScope m_convert;
+};
+
+//Source bytes read and converted bytes written by the current asset
+void ProfileInputBytes(uint64_t bytes);
+void ProfileOutputBytes(uint64_t bytes);
+
+//Chrome trace event json, open in chrome://tracing or Perfetto
+bool WriteProfileTrace(const std::filesystem::path& path);
+//Time per stage over every asset and the count slowest assets with their stages, bytes and compression ratio
+void PrintProfileSummary(uint32_t count);
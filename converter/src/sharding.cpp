@@ -0,0 +1,121 @@
+#include "sharding.h"
+#include <iostream>
+#include <algorithm>
+#include <set>
+#include "core/assetHash.h"
+#include "manifest.h"
+#include "deduplication.h"
+#include "textureConverter.h"
+
+namespace
+{
+	const std::string ShardManifestPrefix = "manifest.shard-";
+}
+
+bool InShard(const std::string& asset, const ConverterSettings& settings)
+{
+	//the hash of the path and not the order files are found in, so every process agrees on the shards
+	return settings.shardCount == 0 || Asset::HashXXH64(asset.data(), asset.size()) % settings.shardCount == settings.shardIndex;
+}
+
+uint64_t HashShardSources(std::vector<std::string> sources, const std::vector<std::string>& roots)
+{
+	std::sort(sources.begin(), sources.end());
+	sources.insert(sources.end(), roots.begin(), roots.end());
+
+	uint64_t hash = 0;
+	for (const std::string& source : sources)
+		hash = Asset::HashXXH64(source.data(), source.size() + 1, hash); //with the terminator so names can't run into each other
+	return hash;
+}
+
+std::filesystem::path ShardManifestPath(const std::filesystem::path& outputFolder, uint32_t index, uint32_t count)
+{
+	return outputFolder / (ShardManifestPrefix + std::to_string(index) + "-of-" + std::to_string(count) + ".json");
+}
+
+bool MergeShards(const std::filesystem::path& outputFolder, const std::filesystem::path& rootPath, const ConverterSettings& settings)
+{
+	const uint64_t settingsHash = HashConverterSettings(settings);
+
+	std::vector<std::filesystem::path> shardFiles;
+	std::error_code error;
+	for (const auto& file : std::filesystem::directory_iterator(outputFolder, error))
+	{
+		const std::string name = file.path().filename().string();
+		if (name.rfind(ShardManifestPrefix, 0) == 0 && file.path().extension() == ".json")
+			shardFiles.push_back(file.path());
+	}
+
+	if (shardFiles.empty())
+	{
+		std::cout << "no shard manifests found in " << outputFolder << std::endl;
+		return false;
+	}
+
+	BuildManifest manifest;
+	std::set<uint32_t> shards;
+	uint32_t count = 0;
+	uint64_t sourcesHash = 0;
+	uint32_t missingOutputs = 0;
+	for (const auto& file : shardFiles)
+	{
+		BuildManifest shard;
+		if (!shard.Load(file) || !shard.GetShard())
+		{
+			std::cout << "could not read the shard manifest " << file << std::endl;
+			return false;
+		}
+
+		const ShardRecord& record = *shard.GetShard();
+		if (shards.empty())
+		{
+			count = record.count;
+			sourcesHash = record.sourcesHash;
+		}
+
+		//left over manifests of an earlier run have to be removed first
+		if (record.count != count || record.sourcesHash != sourcesHash || record.settingsHash != settingsHash)
+		{
+			std::cout << file << " was converted from other sources or with other options than the other shards" << std::endl;
+			return false;
+		}
+		shards.insert(record.index);
+
+		//shards run on other machines have to be copied into the output folder
+		for (const std::string& output : record.outputs)
+		{
+			if (!std::filesystem::exists(outputFolder / output))
+			{
+				std::cout << "shard " << record.index << " output " << output << " is missing" << std::endl;
+				missingOutputs++;
+			}
+		}
+
+		manifest.Merge(shard);
+	}
+
+	if (shards.size() != count)
+	{
+		std::cout << "only " << shards.size() << " of " << count << " shards are done" << std::endl;
+		return false;
+	}
+	if (missingOutputs > 0)
+		return false;
+
+	//the material passes need every material, no shard had them all
+	if (settings.deduplicate)
+		DeduplicateTextures(outputFolder, rootPath, manifest);
+	RemapMaterialTextures(outputFolder, manifest);
+	if (settings.deduplicate)
+		DeduplicateMaterials(outputFolder, rootPath, manifest);
+
+	if (!manifest.Empty() && !manifest.Save(outputFolder / "manifest.json"))
+		return false;
+
+	for (const auto& file : shardFiles)
+		std::filesystem::remove(file, error);
+
+	std::cout << "merged " << count << " shards" << std::endl;
+	return true;
+}
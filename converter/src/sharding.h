@@ -0,0 +1,19 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <filesystem>
+#include "converterSettings.h"
+
+//True if this process converts the asset, every asset belongs to the shard picked by the hash of its manifest path. Always true when not sharded
+bool InShard(const std::string& asset, const ConverterSettings& settings);
+
+//Hash of every source found (relative to the input folder), in any order, and the roots
+uint64_t HashShardSources(std::vector<std::string> sources, const std::vector<std::string>& roots);
+
+//Partial manifest a shard writes to the output folder
+std::filesystem::path ShardManifestPath(const std::filesystem::path& outputFolder, uint32_t index, uint32_t count);
+
+//Combines the partial manifests of every shard into manifest.json and does the passes that need every converted material.
+//Run once all shards are done and their outputs are in one output folder, with the options the shards were run with
+bool MergeShards(const std::filesystem::path& outputFolder, const std::filesystem::path& rootPath, const ConverterSettings& settings);
@@ -0,0 +1,500 @@
+#include "textureConverter.h"
+#include <iostream>
+#include <fstream>
+#include <functional>
+#include <mutex>
+#include <map>
+#include <cmath>
+#include <optional>
+
+#include "stb_image.h"
+
+#include "jaam.h"
+#include "util.h"
+#include "textureProcessing.h"
+#include "blockCompression.h"
+#include "atlasPacking.h"
+#include "pipeline.h"
+#include "profiler.h"
+#include "outputWriter.h"
+#include "deduplication.h"
+
+using namespace Asset;
+
+namespace
+{
+	//Small texture waiting for atlas packing
+	struct AtlasCandidate
+	{
+		std::filesystem::path output;
+		std::string texturePath; //As the materials refer to it
+		std::vector<uint8_t> pixels;
+		uint32_t width;
+		uint32_t height;
+		TextureRole role;
+		std::string originalFile;
+	};
+
+	std::mutex atlasLock;
+	std::vector<AtlasCandidate> atlasCandidates;
+
+	constexpr uint32_t MaxArrayLayers = 256;
+
+	//Reading and decoding are separate pipeline stages so slow disks don't hold up the decoders
+	stbi_uc* LoadImage(const std::filesystem::path& input, int& width, int& height)
+	{
+		std::vector<stbi_uc> file;
+		{
+			StageScope read(PipelineStage::Read);
+			ProfileScope profile(ProfileStage::Read);
+
+			std::ifstream stream(input, std::ios::binary | std::ios::ate);
+			if (!stream.is_open())
+				return nullptr;
+
+			file.resize(static_cast<size_t>(stream.tellg()));
+			stream.seekg(0);
+			stream.read(reinterpret_cast<char*>(file.data()), file.size());
+		}
+		ProfileInputBytes(file.size());
+
+		StageScope decode(PipelineStage::Decode);
+		ProfileScope profile(ProfileStage::Import);
+		int channels;
+		return stbi_load_from_memory(file.data(), static_cast<int>(file.size()), &width, &height, &channels, STBI_rgb_alpha);
+	}
+
+	TextureFormat SelectBlockFormat(TextureRole role, bool hasAlpha, bool useBC7)
+	{
+		switch (role)
+		{
+		case TextureRole::Normal:
+			return TextureFormat::BC5;
+		case TextureRole::Spec:
+		case TextureRole::Alpha:
+		case TextureRole::Roughness:
+		case TextureRole::Occlusion:
+			return TextureFormat::BC4;
+		case TextureRole::Packed:
+			return useBC7 ? TextureFormat::BC7 : TextureFormat::BC1;
+		default:
+			if (useBC7)
+				return TextureFormat::BC7;
+			return hasAlpha ? TextureFormat::BC3 : TextureFormat::BC1;
+		}
+	}
+
+	uint32_t ChannelCount(TextureRole role, const ChannelUsage& usage)
+	{
+		if (role == TextureRole::Packed)
+			return 3;
+		return (usage.grayscale ? 1 : 3) + (usage.hasAlpha ? 1 : 0);
+	}
+
+	TextureFormat ChannelFormat(uint32_t channelCount)
+	{
+		static constexpr TextureFormat formats[4] = { TextureFormat::R8, TextureFormat::RG8, TextureFormat::RGB8, TextureFormat::RGBA8 };
+		return formats[channelCount - 1];
+	}
+
+	//Format the texture is stored in
+	TextureFormat EncodedFormat(TextureRole role, const ChannelUsage& usage, const ConverterSettings& settings)
+	{
+		if (settings.compressTextures)
+			return SelectBlockFormat(role, usage.hasAlpha, settings.useBC7);
+		if (settings.reduceTextureChannels)
+			return ChannelFormat(ChannelCount(role, usage));
+		return TextureFormat::RGBA8;
+	}
+
+	bool IsColor(TextureRole role)
+	{
+		//normal and single channel maps hold data, not color
+		return role == TextureRole::BaseColor || role == TextureRole::Unknown;
+	}
+
+	//Channel single channel formats keep, opacity maps without an alpha channel store it in the color
+	uint32_t SourceChannel(TextureRole role, const ChannelUsage& usage)
+	{
+		return role == TextureRole::Alpha && usage.hasAlpha ? 3 : 0;
+	}
+
+	//Re-encodes every layer of every level of a chain and rewrites the level table for the new sizes
+	std::vector<uint8_t> EncodeLevels(const uint8_t* chain, std::vector<MipLevel>& levels, uint32_t layers, const std::function<std::vector<uint8_t>(const uint8_t*, const MipLevel&)>& encode)
+	{
+		std::vector<uint8_t> encoded;
+		for (MipLevel& level : levels)
+		{
+			const uint64_t layerSize = level.size / layers;
+			const uint64_t offset = encoded.size();
+			for (uint32_t layer = 0; layer < layers; ++layer)
+			{
+				std::vector<uint8_t> layerData = encode(chain + level.offset + layer * layerSize, level);
+				encoded.insert(encoded.end(), layerData.begin(), layerData.end());
+			}
+			level.offset = offset;
+			level.size = encoded.size() - offset;
+		}
+		return encoded;
+	}
+
+	//Materials and the manifest compare paths in this form
+	std::string NormalizedTexturePath(const std::string& path)
+	{
+		return std::filesystem::path(path).lexically_normal().generic_string();
+	}
+
+	void WriteArrays(const std::vector<const AtlasCandidate*>& group, const ChannelUsage& usage, const std::filesystem::path& atlasFolder, const std::filesystem::path& rootPath,
+		const ConverterSettings& settings, BuildManifest& manifest, uint32_t& atlasIndex)
+	{
+		const size_t layerSize = static_cast<size_t>(group[0]->width) * group[0]->height * 4;
+		for (size_t first = 0; first < group.size(); first += MaxArrayLayers)
+		{
+			const uint32_t layers = static_cast<uint32_t>(std::min<size_t>(MaxArrayLayers, group.size() - first));
+
+			std::vector<uint8_t> pixels(layerSize * layers);
+			for (uint32_t layer = 0; layer < layers; ++layer)
+				memcpy(&pixels[layer * layerSize], group[first + layer]->pixels.data(), layerSize);
+
+			const std::filesystem::path arrayPath = atlasFolder / ("array_" + std::to_string(atlasIndex++) + ".tx");
+			ProfileAsset profile(ManifestPath(arrayPath, rootPath));
+			WriteTexture(TextureImage{ pixels.data(), group[0]->width, group[0]->height, layers, group[0]->role, "", 0, usage }, arrayPath, settings);
+
+			const std::string arrayTexture = GetRelativePathFrom(arrayPath, rootPath.string()).string();
+			for (uint32_t layer = 0; layer < layers; ++layer)
+				manifest.AddAtlasEntry(group[first + layer]->texturePath, AtlasEntry{ arrayTexture, { 0.0f, 0.0f, 1.0f, 1.0f }, static_cast<int32_t>(layer) });
+		}
+	}
+
+	void WriteAtlases(const std::vector<const AtlasCandidate*>& group, const ChannelUsage& usage, const std::filesystem::path& atlasFolder, const std::filesystem::path& rootPath,
+		const ConverterSettings& settings, BuildManifest& manifest, uint32_t& atlasIndex)
+	{
+		//rects start on a block so they can be block compressed independently of their neighbours
+		constexpr uint32_t alignment = 4;
+		const uint32_t padding = settings.atlasPadding;
+
+		std::vector<PackRect> rects;
+		for (const AtlasCandidate* candidate : group)
+			rects.push_back(PackRect{ candidate->width + padding * 2, candidate->height + padding * 2, 0, 0, 0 });
+
+		const uint32_t binCount = PackRects(rects, settings.atlasSize, settings.atlasSize, alignment);
+
+		//the padding only protects the levels it still covers
+		const uint32_t maxMipLevels = 1 + static_cast<uint32_t>(std::log2(std::max(padding, 1u)));
+
+		for (uint32_t bin = 0; bin < binCount; ++bin)
+		{
+			uint32_t width = alignment;
+			uint32_t height = alignment;
+			for (const PackRect& rect : rects)
+			{
+				if (rect.bin != bin)
+					continue;
+				width = std::max(width, (rect.x + rect.width + alignment - 1) / alignment * alignment);
+				height = std::max(height, (rect.y + rect.height + alignment - 1) / alignment * alignment);
+			}
+
+			//unused texels are opaque black
+			std::vector<uint8_t> pixels(static_cast<size_t>(width) * height * 4, 0);
+			for (size_t i = 3; i < pixels.size(); i += 4)
+				pixels[i] = 255;
+			const std::filesystem::path atlasPath = atlasFolder / ("atlas_" + std::to_string(atlasIndex++) + ".tx");
+			const std::string atlasTexture = GetRelativePathFrom(atlasPath, rootPath.string()).string();
+
+			for (size_t i = 0; i < group.size(); ++i)
+			{
+				const PackRect& rect = rects[i];
+				if (rect.bin != bin)
+					continue;
+
+				//the padding repeats the edge texels
+				const AtlasCandidate& candidate = *group[i];
+				for (uint32_t y = 0; y < rect.height; ++y)
+				{
+					const uint32_t sy = std::min(static_cast<uint32_t>(std::max(static_cast<int>(y) - static_cast<int>(padding), 0)), candidate.height - 1);
+					for (uint32_t x = 0; x < rect.width; ++x)
+					{
+						const uint32_t sx = std::min(static_cast<uint32_t>(std::max(static_cast<int>(x) - static_cast<int>(padding), 0)), candidate.width - 1);
+						memcpy(&pixels[((static_cast<size_t>(rect.y) + y) * width + rect.x + x) * 4], &candidate.pixels[(static_cast<size_t>(sy) * candidate.width + sx) * 4], 4);
+					}
+				}
+
+				const std::array<float, 4> uvRect =
+				{
+					static_cast<float>(rect.x + padding) / width,
+					static_cast<float>(rect.y + padding) / height,
+					static_cast<float>(rect.x + padding + candidate.width) / width,
+					static_cast<float>(rect.y + padding + candidate.height) / height
+				};
+				manifest.AddAtlasEntry(candidate.texturePath, AtlasEntry{ atlasTexture, uvRect, -1 });
+			}
+
+			ProfileAsset profile(ManifestPath(atlasPath, rootPath));
+			WriteTexture(TextureImage{ pixels.data(), width, height, 1, group[0]->role, "", maxMipLevels, usage }, atlasPath, settings);
+		}
+	}
+}
+
+bool WriteTexture(const TextureImage& image, const std::filesystem::path& output, const ConverterSettings& settings)
+{
+	const uint32_t layers = image.layers;
+	const size_t layerTexels = static_cast<size_t>(image.width) * image.height;
+	const size_t layerSize = layerTexels * 4;
+
+	TextureInfo texinfo;
+	texinfo.textureSize = static_cast<int>(layerSize * layers);
+	texinfo.pixelsize[0] = image.width;
+	texinfo.pixelsize[1] = image.height;
+	texinfo.pixelsize[2] = layers > 1 ? layers : 0;
+	texinfo.textureFormat = TextureFormat::RGBA8;
+	texinfo.originalFile = image.originalFile;
+
+	std::optional<ProfileScope> profile(std::in_place, ProfileStage::Process);
+
+	const ChannelUsage usage = image.usage ? *image.usage : AnalyzeChannels(image.pixels, layerTexels * layers);
+
+	std::vector<uint8_t> mipChain;
+	if (settings.generateMips)
+	{
+		MipSettings mipSettings{ settings.mipFilter, IsColor(image.role), settings.mipAlphaCoverage && usage.hasAlpha, settings.alphaCutoff };
+
+		//each layer has its own chain, levels hold every layer back to back
+		std::vector<std::vector<uint8_t>> layerChains(layers);
+		for (uint32_t layer = 0; layer < layers; ++layer)
+			layerChains[layer] = GenerateMipChain(image.pixels + layer * layerSize, image.width, image.height, mipSettings, texinfo.mips);
+
+		if (image.maxMipLevels > 0 && texinfo.mips.size() > image.maxMipLevels)
+			texinfo.mips.resize(image.maxMipLevels);
+
+		for (MipLevel& level : texinfo.mips)
+		{
+			const uint64_t offset = mipChain.size();
+			for (const std::vector<uint8_t>& layerChain : layerChains)
+				mipChain.insert(mipChain.end(), layerChain.begin() + level.offset, layerChain.begin() + level.offset + level.size);
+
+			level.offset = offset;
+			level.size = mipChain.size() - offset;
+		}
+		texinfo.textureSize = static_cast<int>(mipChain.size());
+	}
+	else
+	{
+		texinfo.mips.emplace_back(MipLevel{ image.width, image.height, 0, static_cast<uint64_t>(texinfo.textureSize) });
+	}
+
+	const uint8_t* source = mipChain.empty() ? image.pixels : mipChain.data();
+
+	profile.emplace(ProfileStage::Compress);
+
+	const TextureFormat format = EncodedFormat(image.role, usage, settings);
+	if (format != TextureFormat::RGBA8)
+	{
+		const uint32_t channel = SourceChannel(image.role, usage);
+		const uint32_t channelCount = ChannelCount(image.role, usage);
+
+		mipChain = EncodeLevels(source, texinfo.mips, layers, [&](const uint8_t* level, const MipLevel& mip)
+			{
+				if (settings.compressTextures)
+					return CompressBlocks(level, mip.width, mip.height, format, channel, settings.encodeThreads);
+				return ReduceChannels(level, static_cast<size_t>(mip.width) * mip.height, channelCount);
+			});
+		texinfo.textureFormat = format;
+		texinfo.textureSize = static_cast<int>(mipChain.size());
+	}
+
+	//tiles split single images, array levels stay whole
+	const uint32_t tileSize = layers > 1 ? 0 : settings.textureTileSize;
+
+	AssetFile newImage = PackTexture(&texinfo, mipChain.empty() ? const_cast<uint8_t*>(image.pixels) : mipChain.data(), settings.streamableTextures, tileSize);
+
+	profile.emplace(ProfileStage::Write);
+	ProfileOutputBytes(OutputWriter::Shared().WriteAsset(output.string(), newImage));
+
+	return true;
+}
+
+bool ConvertImage(const std::filesystem::path& input, const std::filesystem::path& output, const std::filesystem::path& rootPath, const ConverterSettings& settings)
+{
+	int texWidth, texHeight;
+
+	stbi_uc* pixels = LoadImage(input, texWidth, texHeight);
+
+	if (!pixels) {
+		std::cout << "Failed to load texture file " << input << std::endl;
+		return false;
+	}
+
+	//models are converted first so the materials have registered how this texture is used
+	const TextureRole role = GetTextureRole(output);
+	const std::string originalFile = GetRelativePathFrom(input, rootPath.string()).string();
+
+	bool success = true;
+	if (settings.atlasTextures && static_cast<uint32_t>(texWidth) <= settings.atlasMaxSourceSize && static_cast<uint32_t>(texHeight) <= settings.atlasMaxSourceSize)
+	{
+		AtlasCandidate candidate;
+		candidate.output = output;
+		candidate.texturePath = NormalizedTexturePath(GetRelativePathFrom(output, rootPath.string()).string());
+		candidate.pixels.assign(pixels, pixels + static_cast<size_t>(texWidth) * texHeight * 4);
+		candidate.width = texWidth;
+		candidate.height = texHeight;
+		candidate.role = role;
+		candidate.originalFile = originalFile;
+
+		std::lock_guard<std::mutex> lock(atlasLock);
+		atlasCandidates.emplace_back(std::move(candidate));
+	}
+	else
+	{
+		success = WriteTexture(TextureImage{ pixels, static_cast<uint32_t>(texWidth), static_cast<uint32_t>(texHeight), 1, role, originalFile, 0, {} }, output, settings);
+	}
+
+	stbi_image_free(pixels);
+
+	return success;
+}
+
+bool ConvertPackedImage(const std::filesystem::path& output, const PackedTextureSources& sources, const std::filesystem::path& rootPath, const ConverterSettings& settings)
+{
+	//the first source decides the size, the others are point sampled to it
+	int width = 0, height = 0;
+	std::vector<uint8_t> packed;
+	std::string originalFile;
+
+	for (size_t c = 0; c < sources.channels.size(); ++c)
+	{
+		if (sources.channels[c].empty())
+			continue;
+
+		int texWidth, texHeight;
+		stbi_uc* pixels = LoadImage(sources.channels[c], texWidth, texHeight);
+		if (!pixels) {
+			std::cout << "Failed to load texture file " << sources.channels[c] << std::endl;
+			continue;
+		}
+
+		if (packed.empty())
+		{
+			width = texWidth;
+			height = texHeight;
+			packed.assign(static_cast<size_t>(width) * height * 4, 255);
+			originalFile = GetRelativePathFrom(sources.channels[c], rootPath.string()).string();
+		}
+
+		for (int y = 0; y < height; ++y)
+		{
+			const int sy = y * texHeight / height;
+			for (int x = 0; x < width; ++x)
+			{
+				const int sx = x * texWidth / width;
+				packed[(static_cast<size_t>(y) * width + x) * 4 + c] = pixels[(static_cast<size_t>(sy) * texWidth + sx) * 4];
+			}
+		}
+
+		stbi_image_free(pixels);
+	}
+
+	if (packed.empty())
+		return false;
+
+	return WriteTexture(TextureImage{ packed.data(), static_cast<uint32_t>(width), static_cast<uint32_t>(height), 1, TextureRole::Packed, originalFile, 0, {} }, output, settings);
+}
+
+void BuildTextureAtlases(const std::filesystem::path& outputFolder, const std::filesystem::path& rootPath, const ConverterSettings& settings, BuildManifest& manifest)
+{
+	std::lock_guard<std::mutex> lock(atlasLock);
+
+	//textures are only packed with others of the same role stored in the same format from the same channel (and of the same size for arrays)
+	std::map<std::string, std::vector<const AtlasCandidate*>> groups;
+	std::map<std::string, ChannelUsage> groupUsage;
+	for (const AtlasCandidate& candidate : atlasCandidates)
+	{
+		const ChannelUsage usage = AnalyzeChannels(candidate.pixels.data(), static_cast<size_t>(candidate.width) * candidate.height);
+		std::string key = std::to_string(static_cast<int>(EncodedFormat(candidate.role, usage, settings))) + (IsColor(candidate.role) ? "_srgb" : "_linear")
+			+ "_" + std::to_string(static_cast<int>(candidate.role)) + "_" + std::to_string(SourceChannel(candidate.role, usage));
+		if (settings.atlasArrays)
+			key += "_" + std::to_string(candidate.width) + "x" + std::to_string(candidate.height);
+
+		//the atlas is encoded for its textures, not for the padding between them
+		ChannelUsage& merged = groupUsage.try_emplace(key, usage).first->second;
+		merged.hasAlpha |= usage.hasAlpha;
+		merged.grayscale &= usage.grayscale;
+
+		groups[key].push_back(&candidate);
+	}
+
+	const std::filesystem::path atlasFolder = outputFolder / "atlases";
+	std::filesystem::create_directories(atlasFolder);
+
+	uint32_t atlasIndex = 0;
+	for (auto& [key, group] : groups)
+	{
+		//same order on every run
+		std::sort(group.begin(), group.end(), [](const AtlasCandidate* a, const AtlasCandidate* b) { return a->texturePath < b->texturePath; });
+
+		//nothing to share with, write it as it is
+		if (group.size() == 1)
+		{
+			const AtlasCandidate& candidate = *group[0];
+			ProfileAsset profile(ManifestPath(candidate.output, rootPath));
+			WriteTexture(TextureImage{ candidate.pixels.data(), candidate.width, candidate.height, 1, candidate.role, candidate.originalFile, 0, {} }, candidate.output, settings);
+			continue;
+		}
+
+		if (settings.atlasArrays)
+			WriteArrays(group, groupUsage[key], atlasFolder, rootPath, settings, manifest, atlasIndex);
+		else
+			WriteAtlases(group, groupUsage[key], atlasFolder, rootPath, settings, manifest, atlasIndex);
+	}
+
+	atlasCandidates.clear();
+}
+
+void RemapMaterialTextures(const std::filesystem::path& outputFolder, const BuildManifest& manifest)
+{
+	const auto& atlasEntries = manifest.GetAtlasEntries();
+	if (atlasEntries.empty() && manifest.GetAliases().empty())
+		return;
+
+	for (const auto& file : std::filesystem::recursive_directory_iterator(outputFolder))
+	{
+		if (file.path().extension() != ".mat")
+			continue;
+
+		AssetFile materialFile;
+		if (!materialFile.LoadBinaryFile(file.path().string()))
+			continue;
+
+		MaterialInfo material(materialFile);
+
+		bool remapped = false;
+		for (auto& [slot, texture] : material.textures)
+		{
+			//duplicates point at the texture that was stored
+			const std::string path = NormalizedTexturePath(texture);
+			const std::string resolved = manifest.ResolveAlias(path);
+			if (resolved != path)
+			{
+				texture = resolved;
+				remapped = true;
+			}
+
+			auto entry = atlasEntries.find(resolved);
+			if (entry == atlasEntries.end())
+				continue;
+
+			//identical atlases and arrays are collapsed too
+			texture = manifest.ResolveAlias(NormalizedTexturePath(entry->second.atlas));
+			if (entry->second.layer >= 0)
+				material.textureLayers[slot] = static_cast<uint32_t>(entry->second.layer);
+			else
+				material.textureRects[slot] = entry->second.rect;
+			remapped = true;
+		}
+
+		if (remapped)
+		{
+			AssetFile newFile = PackMaterial(material);
+			newFile.SaveBinaryFile(file.path().string());
+		}
+	}
+}
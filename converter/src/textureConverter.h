@@ -0,0 +1,31 @@
+#pragma once
+#include <filesystem>
+#include <string>
+#include <optional>
+#include "converterSettings.h"
+#include "manifest.h"
+#include "textureProcessing.h"
+
+//Decoded RGBA8 image to write as a texture, array layers are stored back to back
+struct TextureImage
+{
+	const uint8_t* pixels;
+	uint32_t width;
+	uint32_t height;
+	uint32_t layers = 1;
+	TextureRole role = TextureRole::Unknown;
+	std::string originalFile;
+	uint32_t maxMipLevels = 0; //0 = full chain
+	std::optional<ChannelUsage> usage; //Analyzed from the pixels when not given
+};
+
+bool WriteTexture(const TextureImage& image, const std::filesystem::path& output, const ConverterSettings& settings);
+
+//Small textures are held back for atlas packing when it is enabled
+bool ConvertImage(const std::filesystem::path& input, const std::filesystem::path& output, const std::filesystem::path& rootPath, const ConverterSettings& settings);
+bool ConvertPackedImage(const std::filesystem::path& output, const PackedTextureSources& sources, const std::filesystem::path& rootPath, const ConverterSettings& settings);
+
+//Packs the textures held back by ConvertImage into atlases (or arrays) in outputFolder/atlases and records where each one went
+void BuildTextureAtlases(const std::filesystem::path& outputFolder, const std::filesystem::path& rootPath, const ConverterSettings& settings, BuildManifest& manifest);
+//Points material textures at the stored copy of duplicates and at their atlas rect or array layer
+void RemapMaterialTextures(const std::filesystem::path& outputFolder, const BuildManifest& manifest);
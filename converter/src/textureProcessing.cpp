@@ -0,0 +1,378 @@
+#include "textureProcessing.h"
+#include "core/simd.h"
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+#include <mutex>
+#include <unordered_map>
+
+using namespace Asset;
+
+namespace
+{
+	std::mutex textureRoleLock;
+	std::unordered_map<std::string, TextureRole> textureRoles;
+	std::unordered_map<std::string, std::pair<std::filesystem::path, PackedTextureSources>> packedTextures;
+	std::unordered_map<std::string, ModelTextureRegistrations> modelRegistrations; //model path -> what it registered
+
+	//4 float channels per texel, SSE register when available
+#if JAAM_SIMD_SSE
+	struct Texel
+	{
+		__m128 v;
+	};
+
+	Texel LoadTexel(const float* src) { return { _mm_loadu_ps(src) }; }
+	void StoreTexel(float* dst, Texel t) { _mm_storeu_ps(dst, t.v); }
+	Texel ZeroTexel() { return { _mm_setzero_ps() }; }
+	Texel MulAdd(Texel acc, Texel t, float weight) { return { _mm_add_ps(acc.v, _mm_mul_ps(t.v, _mm_set1_ps(weight))) }; }
+	Texel Saturate(Texel t) { return { _mm_min_ps(_mm_max_ps(t.v, _mm_setzero_ps()), _mm_set1_ps(1.0f)) }; }
+#else
+	struct Texel
+	{
+		std::array<float, 4> v;
+	};
+
+	Texel LoadTexel(const float* src) { Texel t; memcpy(t.v.data(), src, sizeof(float) * 4); return t; }
+	void StoreTexel(float* dst, Texel t) { memcpy(dst, t.v.data(), sizeof(float) * 4); }
+	Texel ZeroTexel() { return { { 0.0f, 0.0f, 0.0f, 0.0f } }; }
+	Texel MulAdd(Texel acc, Texel t, float weight)
+	{
+		for (int i = 0; i < 4; ++i)
+			acc.v[i] += t.v[i] * weight;
+		return acc;
+	}
+	Texel Saturate(Texel t)
+	{
+		for (float& c : t.v)
+			c = std::clamp(c, 0.0f, 1.0f);
+		return t;
+	}
+#endif
+
+	struct Image
+	{
+		uint32_t width;
+		uint32_t height;
+		std::vector<float> texels; //RGBA, linear
+	};
+
+	//Downsampling kernel, the source texel for tap i of destination x is 2 * x + firstTap + i
+	struct Kernel
+	{
+		int firstTap;
+		std::vector<float> weights;
+	};
+
+	double BesselI0(double x)
+	{
+		double sum = 1.0;
+		double term = 1.0;
+		for (int k = 1; k < 32; ++k)
+		{
+			term *= (x / (2.0 * k)) * (x / (2.0 * k));
+			sum += term;
+		}
+		return sum;
+	}
+
+	Kernel MakeKernel(MipFilter filter)
+	{
+		if (filter == MipFilter::Box)
+			return Kernel{ 0, { 0.5f, 0.5f } };
+
+		//Kaiser windowed sinc over 6 source texels, distances are in destination texels
+		constexpr double alpha = 4.0;
+		constexpr double halfWidth = 1.5;
+		constexpr double pi = 3.14159265358979323846;
+
+		Kernel kernel{ -2, {} };
+		double total = 0.0;
+		for (int tap = -2; tap <= 3; ++tap)
+		{
+			const double x = (tap - 0.5) * 0.5;
+			const double sinc = x == 0.0 ? 1.0 : std::sin(pi * x) / (pi * x);
+			const double ratio = x / halfWidth;
+			const double window = BesselI0(alpha * std::sqrt(std::max(0.0, 1.0 - ratio * ratio))) / BesselI0(alpha);
+
+			kernel.weights.emplace_back(static_cast<float>(sinc * window));
+			total += sinc * window;
+		}
+
+		for (float& weight : kernel.weights)
+			weight = static_cast<float>(weight / total);
+
+		return kernel;
+	}
+
+	//Separable 2x downsample, edges are clamped
+	Image Downsample(const Image& src, const Kernel& kernel)
+	{
+		const uint32_t width = std::max(1u, src.width / 2);
+		const uint32_t height = std::max(1u, src.height / 2);
+
+		//a dimension that is already 1 is copied instead of filtered
+		const bool filterX = src.width > 1;
+		const bool filterY = src.height > 1;
+
+		Image horizontal{ width, src.height, std::vector<float>(size_t(width) * src.height * 4) };
+		for (uint32_t y = 0; y < src.height; ++y)
+		{
+			const float* row = &src.texels[size_t(y) * src.width * 4];
+			for (uint32_t x = 0; x < width; ++x)
+			{
+				Texel sum = ZeroTexel();
+				if (!filterX)
+				{
+					sum = LoadTexel(row);
+				}
+				else
+				{
+					for (size_t i = 0; i < kernel.weights.size(); ++i)
+					{
+						const int sx = std::clamp(int(x * 2) + kernel.firstTap + int(i), 0, int(src.width) - 1);
+						sum = MulAdd(sum, LoadTexel(row + size_t(sx) * 4), kernel.weights[i]);
+					}
+				}
+				StoreTexel(&horizontal.texels[(size_t(y) * width + x) * 4], sum);
+			}
+		}
+
+		Image result{ width, height, std::vector<float>(size_t(width) * height * 4) };
+		for (uint32_t y = 0; y < height; ++y)
+		{
+			for (uint32_t x = 0; x < width; ++x)
+			{
+				Texel sum = ZeroTexel();
+				if (!filterY)
+				{
+					sum = LoadTexel(&horizontal.texels[size_t(x) * 4]);
+				}
+				else
+				{
+					for (size_t i = 0; i < kernel.weights.size(); ++i)
+					{
+						const int sy = std::clamp(int(y * 2) + kernel.firstTap + int(i), 0, int(src.height) - 1);
+						sum = MulAdd(sum, LoadTexel(&horizontal.texels[(size_t(sy) * width + x) * 4]), kernel.weights[i]);
+					}
+				}
+
+				//sharper kernels ring, keep the result in range
+				StoreTexel(&result.texels[(size_t(y) * width + x) * 4], Saturate(sum));
+			}
+		}
+
+		return result;
+	}
+
+	float SrgbToLinear(float c)
+	{
+		return c <= 0.04045f ? c / 12.92f : std::pow((c + 0.055f) / 1.055f, 2.4f);
+	}
+
+	float LinearToSrgb(float c)
+	{
+		return c <= 0.0031308f ? c * 12.92f : 1.055f * std::pow(c, 1.0f / 2.4f) - 0.055f;
+	}
+
+	const std::array<float, 256>& SrgbToLinearTable()
+	{
+		static const std::array<float, 256> table = []()
+		{
+			std::array<float, 256> values;
+			for (int i = 0; i < 256; ++i)
+				values[i] = SrgbToLinear(i / 255.0f);
+			return values;
+		}();
+		return table;
+	}
+
+	//linear values are quantized to 12 bits before the lookup
+	const std::array<uint8_t, 4096>& LinearToSrgbTable()
+	{
+		static const std::array<uint8_t, 4096> table = []()
+		{
+			std::array<uint8_t, 4096> values;
+			for (int i = 0; i < 4096; ++i)
+				values[i] = static_cast<uint8_t>(std::lround(LinearToSrgb(i / 4095.0f) * 255.0f));
+			return values;
+		}();
+		return table;
+	}
+
+	Image ToLinear(const uint8_t* pixels, uint32_t width, uint32_t height, bool srgb)
+	{
+		const std::array<float, 256>& table = SrgbToLinearTable();
+
+		Image image{ width, height, std::vector<float>(size_t(width) * height * 4) };
+		for (size_t i = 0; i < image.texels.size(); ++i)
+		{
+			const bool colorChannel = (i & 3) != 3;
+			image.texels[i] = srgb && colorChannel ? table[pixels[i]] : pixels[i] / 255.0f;
+		}
+		return image;
+	}
+
+	void FromLinear(const Image& image, bool srgb, uint8_t* pixels)
+	{
+		const std::array<uint8_t, 4096>& table = LinearToSrgbTable();
+
+		for (size_t i = 0; i < image.texels.size(); ++i)
+		{
+			const bool colorChannel = (i & 3) != 3;
+			const float value = std::clamp(image.texels[i], 0.0f, 1.0f);
+			pixels[i] = srgb && colorChannel ? table[std::lround(value * 4095.0f)] : static_cast<uint8_t>(std::lround(value * 255.0f));
+		}
+	}
+
+	float AlphaCoverage(const Image& image, float cutoff, float scale)
+	{
+		size_t covered = 0;
+		for (size_t i = 3; i < image.texels.size(); i += 4)
+		{
+			if (image.texels[i] * scale > cutoff)
+				covered++;
+		}
+		return float(covered) / float(image.texels.size() / 4);
+	}
+
+	//Scales the alpha of a level so the same fraction of texels passes the alpha test as in level 0
+	void PreserveAlphaCoverage(Image& image, float cutoff, float targetCoverage)
+	{
+		float low = 0.0f;
+		float high = 4.0f;
+		for (int i = 0; i < 12; ++i)
+		{
+			const float scale = (low + high) * 0.5f;
+			if (AlphaCoverage(image, cutoff, scale) > targetCoverage)
+				high = scale;
+			else
+				low = scale;
+		}
+
+		const float scale = (low + high) * 0.5f;
+		for (size_t i = 3; i < image.texels.size(); i += 4)
+		{
+			image.texels[i] = std::min(1.0f, image.texels[i] * scale);
+		}
+	}
+}
+
+std::vector<uint8_t> GenerateMipChain(const uint8_t* pixels, uint32_t width, uint32_t height, const MipSettings& settings, std::vector<MipLevel>& levels)
+{
+	levels.clear();
+
+	uint64_t totalSize = 0;
+	for (uint32_t w = width, h = height; ; w = std::max(1u, w / 2), h = std::max(1u, h / 2))
+	{
+		const uint64_t size = uint64_t(w) * h * 4;
+		levels.emplace_back(MipLevel{ w, h, totalSize, size });
+		totalSize += size;
+
+		if (w == 1 && h == 1)
+			break;
+	}
+
+	std::vector<uint8_t> chain(totalSize);
+	memcpy(chain.data(), pixels, levels[0].size);
+
+	const Kernel kernel = MakeKernel(settings.filter);
+	Image image = ToLinear(pixels, width, height, settings.srgb);
+	const float coverage = settings.preserveAlphaCoverage ? AlphaCoverage(image, settings.alphaCutoff, 1.0f) : 0.0f;
+
+	//each level is filtered from the unquantized previous level
+	for (size_t level = 1; level < levels.size(); ++level)
+	{
+		image = Downsample(image, kernel);
+
+		Image output = image;
+		if (settings.preserveAlphaCoverage)
+			PreserveAlphaCoverage(output, settings.alphaCutoff, coverage);
+
+		FromLinear(output, settings.srgb, &chain[levels[level].offset]);
+	}
+
+	return chain;
+}
+
+ChannelUsage AnalyzeChannels(const uint8_t* pixels, size_t texelCount)
+{
+	ChannelUsage usage{ false, true };
+	for (size_t i = 0; i < texelCount; ++i)
+	{
+		const uint8_t* texel = pixels + i * 4;
+		usage.hasAlpha |= texel[3] != 255;
+		usage.grayscale &= texel[0] == texel[1] && texel[1] == texel[2];
+	}
+	return usage;
+}
+
+std::vector<uint8_t> ReduceChannels(const uint8_t* pixels, size_t texelCount, uint32_t channelCount)
+{
+	//source channel of each output channel
+	static constexpr uint32_t channelMap[4][4] =
+	{
+		{ 0 },
+		{ 0, 3 },
+		{ 0, 1, 2 },
+		{ 0, 1, 2, 3 }
+	};
+	const uint32_t* map = channelMap[channelCount - 1];
+
+	std::vector<uint8_t> reduced(texelCount * channelCount);
+	for (size_t i = 0; i < texelCount; ++i)
+	{
+		for (uint32_t c = 0; c < channelCount; ++c)
+			reduced[i * channelCount + c] = pixels[i * 4 + map[c]];
+	}
+	return reduced;
+}
+
+void RegisterTextureRole(const std::filesystem::path& texturePath, TextureRole role, const std::filesystem::path& model)
+{
+	std::lock_guard<std::mutex> lock(textureRoleLock);
+	textureRoles[texturePath.lexically_normal().generic_string()] = role;
+
+	if (!model.empty())
+		modelRegistrations[model.lexically_normal().generic_string()].roles.emplace_back(texturePath, role);
+}
+
+TextureRole GetTextureRole(const std::filesystem::path& texturePath)
+{
+	std::lock_guard<std::mutex> lock(textureRoleLock);
+	auto role = textureRoles.find(texturePath.lexically_normal().generic_string());
+	return role != textureRoles.end() ? role->second : TextureRole::Unknown;
+}
+
+void RegisterPackedTexture(const std::filesystem::path& texturePath, const PackedTextureSources& sources, const std::filesystem::path& model)
+{
+	std::lock_guard<std::mutex> lock(textureRoleLock);
+	packedTextures.emplace(texturePath.lexically_normal().generic_string(), std::make_pair(texturePath, sources));
+
+	if (!model.empty())
+		modelRegistrations[model.lexically_normal().generic_string()].packed.emplace_back(texturePath, sources);
+}
+
+std::vector<std::pair<std::filesystem::path, PackedTextureSources>> GetPackedTextures()
+{
+	std::lock_guard<std::mutex> lock(textureRoleLock);
+
+	std::vector<std::pair<std::filesystem::path, PackedTextureSources>> textures;
+	for (const auto& texture : packedTextures)
+		textures.emplace_back(texture.second);
+	return textures;
+}
+
+ModelTextureRegistrations GetModelTextureRegistrations(const std::filesystem::path& model)
+{
+	std::lock_guard<std::mutex> lock(textureRoleLock);
+	auto registrations = modelRegistrations.find(model.lexically_normal().generic_string());
+	return registrations != modelRegistrations.end() ? registrations->second : ModelTextureRegistrations();
+}
+
+void ClearModelTextureRegistrations(const std::filesystem::path& model)
+{
+	std::lock_guard<std::mutex> lock(textureRoleLock);
+	modelRegistrations.erase(model.lexically_normal().generic_string());
+}
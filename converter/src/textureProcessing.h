@@ -0,0 +1,73 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include <array>
+#include <filesystem>
+#include "assetTexture.h"
+
+enum class MipFilter
+{
+	Box,
+	Kaiser
+};
+
+struct MipSettings
+{
+	MipFilter filter;
+	bool srgb; //Filter the color channels in linear space
+	bool preserveAlphaCoverage; //Keep the fraction of texels above alphaCutoff constant across levels
+	float alphaCutoff;
+};
+
+//Builds the full mip chain of an RGBA8 image. Returns every level concatenated (level 0 first) and fills in the level table
+std::vector<uint8_t> GenerateMipChain(const uint8_t* pixels, uint32_t width, uint32_t height, const MipSettings& settings, std::vector<Asset::MipLevel>& levels);
+
+//Which channels of an RGBA8 image carry information
+struct ChannelUsage
+{
+	bool hasAlpha; //Any alpha below 255
+	bool grayscale; //Red, green and blue are equal everywhere
+};
+
+ChannelUsage AnalyzeChannels(const uint8_t* pixels, size_t texelCount);
+
+//Keeps channelCount channels of each RGBA8 texel: 1 = R, 2 = R and A, 3 = RGB, 4 = RGBA
+std::vector<uint8_t> ReduceChannels(const uint8_t* pixels, size_t texelCount, uint32_t channelCount);
+
+//How a material samples a texture, decides the block compressed format
+enum class TextureRole
+{
+	Unknown,
+	BaseColor,
+	Normal,
+	Spec,
+	Alpha,
+	Roughness,
+	Occlusion,
+	Packed //Single channel maps packed into the channels of one texture
+};
+
+//Roles are registered by the model converter against the output .tx path and looked up when the texture is converted.
+//The model that registered them is remembered for the build cache
+void RegisterTextureRole(const std::filesystem::path& texturePath, TextureRole role, const std::filesystem::path& model = {});
+TextureRole GetTextureRole(const std::filesystem::path& texturePath);
+
+//Source images of a packed texture, the red channel of each goes into the matching output channel. Empty sources are left white
+struct PackedTextureSources
+{
+	std::array<std::filesystem::path, 3> channels;
+};
+
+//Packed textures are registered by the model converter and built after all models are converted
+void RegisterPackedTexture(const std::filesystem::path& texturePath, const PackedTextureSources& sources, const std::filesystem::path& model = {});
+std::vector<std::pair<std::filesystem::path, PackedTextureSources>> GetPackedTextures();
+
+//Everything a model registered, a model that is not reconverted registers it again from the build cache
+struct ModelTextureRegistrations
+{
+	std::vector<std::pair<std::filesystem::path, TextureRole>> roles;
+	std::vector<std::pair<std::filesystem::path, PackedTextureSources>> packed;
+};
+ModelTextureRegistrations GetModelTextureRegistrations(const std::filesystem::path& model);
+//Forgets what a model registered before it is converted again, the roles stay until it registers them again
+void ClearModelTextureRegistrations(const std::filesystem::path& model);
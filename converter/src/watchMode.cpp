@@ -0,0 +1,255 @@
+#include "watchMode.h"
+#include <iostream>
+#include <chrono>
+#include <unordered_map>
+#include <algorithm>
+#include "assetFile.h"
+#include "util.h"
+#include "fileWatcher.h"
+#include "changeNotifier.h"
+#include "modelConverter.h"
+#include "textureConverter.h"
+#include "textureProcessing.h"
+#include "deduplication.h"
+#include "jobSystem.h"
+#include "pipeline.h"
+#include "outputWriter.h"
+
+using namespace Asset;
+
+namespace
+{
+	//What one batch of changes converts, sources with the output path main gives them
+	struct WatchBatch
+	{
+		std::vector<std::pair<fs::path, fs::path>> models;
+		std::vector<std::pair<fs::path, fs::path>> textures;
+		std::vector<std::pair<fs::path, PackedTextureSources>> packed;
+		std::vector<std::string> converted;
+		std::vector<std::string> removed;
+	};
+
+	std::string NormalPath(const fs::path& path)
+	{
+		return path.lexically_normal().generic_string();
+	}
+
+	fs::path ModelPath(const fs::path& output)
+	{
+		return fs::path(output).replace_extension(".modl");
+	}
+
+	void RemoveOutput(const fs::path& output)
+	{
+		std::error_code error;
+		fs::remove_all(output, error);
+		fs::remove(AssetFile::MetaPath(output.string()), error);
+	}
+
+	bool UsesSource(const PackedTextureSources& packed, const fs::path& source)
+	{
+		for (const auto& channel : packed.channels)
+		{
+			if (!channel.empty() && NormalPath(channel) == NormalPath(source))
+				return true;
+		}
+		return false;
+	}
+}
+
+void RunWatchMode(FileWatcher& watcher, const fs::path& inputFolder, const fs::path& outputFolder, const ConverterSettings& settings,
+	const std::unordered_set<std::string>& textureExtensions, const std::unordered_set<std::string>& modelExtensions)
+{
+	const fs::path rootPath = inputFolder.filename();
+	JobSystem& jobs = JobSystem::Shared();
+
+	const fs::path socketPath = settings.notifySocket.empty() ? outputFolder / ".jaam_watch.sock" : fs::path(settings.notifySocket);
+	ChangeNotifier notifier(socketPath);
+	if (notifier.IsOpen())
+		std::cout << "sending changed assets to " << socketPath << std::endl;
+	else
+		std::cout << "could not open " << socketPath << ", changed assets are not sent" << std::endl;
+
+	//models register their textures by output path, a texture they now use differently is converted from its source again
+	std::unordered_map<std::string, std::pair<fs::path, fs::path>> textureSources; //output -> source, output
+	//an edited .mtl, buffer or image converts the models that read it
+	std::unordered_map<std::string, std::pair<fs::path, std::vector<fs::path>>> sideFiles; //model source -> source, files assimp reads next to it
+	std::error_code error;
+	for (const auto& file : fs::recursive_directory_iterator(inputFolder, error))
+	{
+		const std::string extension = file.path().extension().string();
+		if (modelExtensions.count(extension))
+			sideFiles[NormalPath(file.path())] = { file.path(), GetModelSideFiles(file.path()) };
+		if (!textureExtensions.count(extension))
+			continue;
+
+		fs::path newpath = ChangeRoot(inputFolder, outputFolder, file.path());
+		newpath.replace_extension(".tx");
+		textureSources[NormalPath(newpath)] = { file.path(), newpath };
+	}
+
+	std::cout << "watching " << inputFolder << " for changes" << std::endl;
+	while (true)
+	{
+		const std::vector<fs::path> changed = watcher.WaitForChanges(std::chrono::milliseconds(settings.watchDelayMS));
+		const auto start = std::chrono::steady_clock::now();
+
+		WatchBatch batch;
+		std::unordered_set<std::string> queued; //Sources are converted once per batch however they were reached
+		auto queueModel = [&](const fs::path& source)
+			{
+				fs::path newpath = ChangeRoot(inputFolder, outputFolder, source);
+				newpath.replace_extension(".mesh");
+				if (!queued.insert(NormalPath(newpath)).second)
+					return;
+
+				fs::create_directories(newpath.parent_path());
+				sideFiles[NormalPath(source)] = { source, GetModelSideFiles(source) };
+				batch.models.emplace_back(source, newpath);
+			};
+
+		for (const fs::path& source : changed)
+		{
+			std::vector<fs::path> readers;
+			for (const auto& [model, reader] : sideFiles)
+			{
+				const auto& [modelSource, files] = reader;
+				if (std::find(files.begin(), files.end(), source.lexically_normal()) != files.end())
+					readers.push_back(modelSource);
+			}
+			for (const fs::path& model : readers)
+			{
+				if (fs::exists(model))
+					queueModel(model);
+			}
+
+			const std::string extension = source.extension().string();
+			const bool texture = textureExtensions.count(extension) > 0;
+			if (!texture && !modelExtensions.count(extension))
+				continue;
+
+			fs::path newpath = ChangeRoot(inputFolder, outputFolder, source);
+			newpath.replace_extension(texture ? ".tx" : ".mesh");
+
+			if (!fs::exists(source))
+			{
+				if (texture)
+				{
+					textureSources.erase(NormalPath(newpath));
+					RemoveOutput(newpath);
+					batch.removed.push_back(ManifestPath(newpath, rootPath));
+				}
+				else
+				{
+					sideFiles.erase(NormalPath(source));
+					fs::path outputDir = newpath;
+					outputDir.replace_extension();
+					RemoveOutput(ModelPath(newpath));
+					RemoveOutput(outputDir.string() + "_materials");
+					batch.removed.push_back(ManifestPath(ModelPath(newpath), rootPath));
+				}
+				continue;
+			}
+
+			if (!texture)
+			{
+				queueModel(source);
+				continue;
+			}
+
+			fs::create_directories(newpath.parent_path());
+
+			textureSources[NormalPath(newpath)] = { source, newpath };
+			if (queued.insert(NormalPath(newpath)).second)
+				batch.textures.emplace_back(source, newpath);
+		}
+
+		//models first, how their materials use a texture decides its format
+		std::vector<ModelTextureRegistrations> previous;
+		JobCounter modelJobs;
+		for (size_t i = 0; i < batch.models.size(); ++i)
+		{
+			previous.push_back(GetModelTextureRegistrations(batch.models[i].first));
+			ClearModelTextureRegistrations(batch.models[i].first);
+
+			SubmitConversion(jobs, modelJobs, EstimateModelMemory(batch.models[i].first), [&, i]()
+				{
+					ConvertMesh(batch.models[i].first, batch.models[i].second, rootPath, settings);
+				});
+		}
+		jobs.Wait(modelJobs);
+
+		for (size_t i = 0; i < batch.models.size(); ++i)
+		{
+			batch.converted.push_back(ManifestPath(ModelPath(batch.models[i].second), rootPath));
+
+			std::unordered_map<std::string, TextureRole> previousRoles;
+			for (const auto& [texture, role] : previous[i].roles)
+				previousRoles[NormalPath(texture)] = role;
+			std::unordered_set<std::string> previousPacked;
+			for (const auto& [texture, sources] : previous[i].packed)
+				previousPacked.insert(NormalPath(texture));
+
+			const ModelTextureRegistrations registrations = GetModelTextureRegistrations(batch.models[i].first);
+			for (const auto& [texture, role] : registrations.roles)
+			{
+				auto previousRole = previousRoles.find(NormalPath(texture));
+				auto source = textureSources.find(NormalPath(texture));
+				if ((previousRole != previousRoles.end() && previousRole->second == role) || source == textureSources.end())
+					continue;
+
+				if (queued.insert(source->first).second)
+					batch.textures.push_back(source->second);
+			}
+			for (const auto& [texture, sources] : registrations.packed)
+			{
+				if (!previousPacked.count(NormalPath(texture)) && queued.insert(NormalPath(texture)).second)
+					batch.packed.emplace_back(texture, sources);
+			}
+		}
+
+		//packed textures are built from the changed maps too
+		for (const auto& [texture, sources] : GetPackedTextures())
+		{
+			for (const auto& [source, newpath] : batch.textures)
+			{
+				if (UsesSource(sources, source) && queued.insert(NormalPath(texture)).second)
+					batch.packed.emplace_back(texture, sources);
+			}
+		}
+
+		JobCounter textureJobs;
+		for (size_t i = 0; i < batch.textures.size(); ++i)
+		{
+			SubmitConversion(jobs, textureJobs, EstimateTextureMemory(batch.textures[i].first), [&, i]()
+				{
+					ConvertImage(batch.textures[i].first, batch.textures[i].second, rootPath, settings);
+				});
+			batch.converted.push_back(ManifestPath(batch.textures[i].second, rootPath));
+		}
+		for (size_t i = 0; i < batch.packed.size(); ++i)
+		{
+			uint64_t estimate = 0;
+			for (const auto& channel : batch.packed[i].second.channels)
+				estimate = std::max(estimate, channel.empty() ? 0 : EstimateTextureMemory(channel));
+
+			SubmitConversion(jobs, textureJobs, estimate, [&, i]()
+				{
+					ConvertPackedImage(batch.packed[i].first, batch.packed[i].second, rootPath, settings);
+				});
+			batch.converted.push_back(ManifestPath(batch.packed[i].first, rootPath));
+		}
+		jobs.Wait(textureJobs);
+
+		//a runtime is only told once the files are on disk
+		if (!OutputWriter::Shared().Flush())
+			std::cout << "some converted files could not be written\n";
+
+		notifier.Notify("removed", batch.removed);
+		notifier.Notify("converted", batch.converted);
+
+		const auto milliseconds = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+		if (!batch.converted.empty() || !batch.removed.empty())
+			std::cout << batch.converted.size() << " converted and " << batch.removed.size() << " removed in " << milliseconds.count() << "ms" << std::endl;
+	}
+}
@@ -0,0 +1,12 @@
+#pragma once
+#include <string>
+#include <unordered_set>
+#include <filesystem>
+#include "converterSettings.h"
+#include "fileWatcher.h"
+
+//Converts sources again as they change until the converter is stopped, each batch of changes is sent to the notify socket.
+//Run after a full conversion, the texture roles and packed textures it registered are kept. The watcher is created before the
+//full conversion starts, so sources saved while it ran make up the first batch
+void RunWatchMode(FileWatcher& watcher, const std::filesystem::path& inputFolder, const std::filesystem::path& outputFolder, const ConverterSettings& settings,
+	const std::unordered_set<std::string>& textureExtensions, const std::unordered_set<std::string>& modelExtensions);
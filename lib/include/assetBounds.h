@@ -0,0 +1,61 @@
+#pragma once
+#include <cstdint>
+#include <array>
+#include <vector>
+
+namespace Asset
+{
+	struct BoundingBox
+	{
+		std::array<float, 3> min;
+		std::array<float, 3> max;
+
+		std::array<float, 3> Center() const;
+		bool Intersects(const BoundingBox& other) const;
+		void Merge(const BoundingBox& other);
+	};
+
+	struct BoundingSphere
+	{
+		std::array<float, 3> center;
+		float radius;
+	};
+
+	struct Ray
+	{
+		std::array<float, 3> origin;
+		std::array<float, 3> direction;
+
+		//Returns the entry distance along the ray or a negative value if the box is missed
+		float Intersects(const BoundingBox& box, float maxDistance) const;
+	};
+
+	/// <summary>
+	/// Six planes (nx, ny, nz, d) with the normals pointing inwards, a point p is inside a plane if dot(n, p) + d >= 0
+	/// </summary>
+	struct Frustum
+	{
+		std::array<std::array<float, 4>, 6> planes;
+
+		//Extracts the planes from a row-major view projection matrix (column vectors, OpenGL style clip space)
+		static Frustum FromMatrix(const std::array<float, 16>& viewProjection);
+
+		bool Intersects(const BoundingBox& box) const;
+	};
+
+	//Transforms a box by a row-major matrix (translation in the last column), the same layout as ModelInfo::transformMatrix
+	BoundingBox TransformBoundingBox(const BoundingBox& box, const std::array<float, 16>& matrix);
+
+	/// <summary>
+	/// Node of a compact bvh (32 bytes). Interior nodes have a count of 0 and their children are stored at offset and offset + 1.
+	/// Leaf nodes reference count entries starting at offset in the bvh index array.
+	/// </summary>
+	struct BVHNode
+	{
+		BoundingBox bounds;
+		uint32_t offset;
+		uint32_t count;
+	};
+
+	void BuildBVH(const std::vector<BoundingBox>& itemBounds, std::vector<BVHNode>& nodes, std::vector<uint32_t>& indices, uint32_t maxLeafSize = 4);
+}
@@ -9,19 +9,36 @@ namespace Asset
 {
 	typedef std::array<char, 4> FileType;
 
+	//Versions PackTexture, PackModel and PackMaterial write, files of any other version are not loaded.
+	//Files from before the checksum grew to 64 bits have a smaller header and are older versions
+	constexpr uint32_t TextureFileVersion = 2;
+	constexpr uint32_t ModelFileVersion = 3;
+	constexpr uint32_t MaterialFileVersion = 2;
+
 	struct AssetFile
 	{
 		AssetFile();
 
 		FileType type;
 		uint32_t version;
-		uint16_t checksum;
+		uint64_t checksum; //XXH64 of the type, version, json and blob, set when saved and checked when the blob is loaded
 		std::string json;
 		//std::vector<char> binaryBlob;
 		Buffer binaryBlob;
 
+		std::string path; //Set when loaded, used to read blob ranges later
+		uint64_t blobDataOffset; //File offset of the blob data
+		bool blobLoaded;
+
 		bool SaveBinaryFile(std::string_view path);
-		bool LoadBinaryFile(std::string_view path);
+		//Sets the checksum and builds the binary file in one buffer, the json goes to the file at MetaPath
+		std::vector<uint8_t> SerializeBinary();
+		static std::string MetaPath(std::string_view path);
+		//When loadBlob is false only the blob header is read, ranges can be read on demand with ReadBlobRange.
+		//Textures, models and materials of another version fail with a message to convert them again
+		bool LoadBinaryFile(std::string_view path, bool loadBlob = true);
+		bool ReadBlobRange(uint64_t offset, uint64_t size, void* dst) const; //Uncompressed blobs only
+		uint64_t ComputeChecksum() const;
 	};
 
 	CompressionMode ParseCompression(const char* f);
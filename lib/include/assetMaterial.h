@@ -19,6 +19,9 @@ namespace Asset
 		std::string name;
 		std::string baseEffect;
 		std::unordered_map<std::string, std::string >textures; // name/type -> path
+		std::unordered_map<std::string, uint32_t> textureChannels; // name/type -> channel, only for textures packed into a channel of a shared texture
+		std::unordered_map<std::string, std::array<float, 4>> textureRects; // name/type -> UV rect (min x, min y, max x, max y), only for textures in an atlas
+		std::unordered_map<std::string, uint32_t> textureLayers; // name/type -> layer, only for textures in a texture array
 
 		std::unordered_map<std::string, float> floatParamters;
 		std::unordered_map<std::string, int> intParamters;
@@ -1,5 +1,6 @@
 #pragma once
 #include "assetFile.h"
+#include "assetBounds.h"
 #include <unordered_map>
 
 namespace Asset
@@ -14,6 +15,8 @@ namespace Asset
 		TexCoordFloat2,
 	};
 
+	uint32_t GetVertexDataTypeSize(VertexDataType type);
+
 	struct VertexBuffer
 	{
 		std::vector<VertexDataType> inputTypes;
@@ -22,30 +25,101 @@ namespace Asset
 		std::vector<uint8_t> data;
 		uint32_t GetStride() const;
 		size_t GetVertexCount() const;
+
+		bool HasAttribute(VertexDataType type) const;
+
+		//Byte offset of the first element of an attribute and the distance between elements, works for both layouts
+		size_t GetAttributeOffset(VertexDataType type) const;
+		uint32_t GetAttributeStride(VertexDataType type) const;
+
+		//Copies a single attribute tightly packed into dst (GetVertexCount() * GetVertexDataTypeSize(type) bytes)
+		void ExtractAttribute(VertexDataType type, void* dst) const;
+
+		//Converts between one interleaved stream and one stream per attribute (in inputTypes order)
+		void Interleave();
+		void Deinterleave();
 	};
 
 	typedef std::vector<uint32_t> IndexBuffer;
-	typedef std::array<float, 16> Mat4x4;
+	typedef std::array<float, 16> Mat4x4; //Row-major with the translation in the last column (assimp layout)
+
+	/// <summary>
+	/// A cluster of up to 255 vertices with precomputed culling bounds.
+	/// The cone is for backface culling, the meshlet can be skipped if dot(normalize(coneApex - cameraPosition), coneAxis) >= coneCutoff
+	/// </summary>
+	struct Meshlet
+	{
+		uint32_t vertexOffset;   //First entry in Mesh::meshletVertices
+		uint32_t triangleOffset; //First byte in Mesh::meshletTriangles
+		uint32_t vertexCount;
+		uint32_t triangleCount;
+
+		std::array<float, 3> center;
+		float radius;
+
+		std::array<float, 3> coneApex;
+		std::array<float, 3> coneAxis;
+		float coneCutoff;
+	};
 
 	struct Mesh
 	{
 		VertexBuffer vertexBuffer;
 		IndexBuffer indexBuffer;
+
+		//Local space bounds
+		BoundingBox bounds;
+		BoundingSphere boundingSphere;
+
+		//Optional meshlets, empty if the model was converted without them
+		std::vector<Meshlet> meshlets;
+		std::vector<uint32_t> meshletVertices; //Meshlet local vertex -> index into the vertex buffer
+		std::vector<uint8_t> meshletTriangles; //3 meshlet local vertex indices per triangle
 	};
 
 
+	struct RayHit
+	{
+		uint32_t node;
+		float distance; //Distance to the node bounds along the ray
+	};
+
 	struct ModelInfo 
 	{
 		ModelInfo();
 		ModelInfo(const AssetFile& assetFile);
 
+		//Node table, one entry per mesh instance
 		std::vector<std::string> meshNames;
 		std::unordered_map<uint64_t, uint64_t> meshParents;  //Key = Mesh to get the parent for, Value = ParentId
 		std::vector<std::string> meshMaterials;
+		std::vector<uint32_t> nodeMeshes; //Node -> index into meshes, nodes can share a mesh
+		std::vector<int32_t> nodeParents; //Node -> parent node or -1, nodes are ordered so a parent always comes before its children
 
 		//Binary members
-		std::vector<Mat4x4> transformMatrix;
-		std::vector<Mesh> meshes;
+		std::vector<Mat4x4> transformMatrix; //Local transform relative to the parent node
+		std::vector<Mat4x4> worldMatrix; //Optional precomputed model space transforms, empty if not stored
+		std::vector<Mesh> meshes; //Mesh table, every unique mesh is stored once
+
+		//Bounds of every node in model space and a bvh over them, empty for models converted without bounds
+		std::vector<BoundingBox> modelSpaceBounds;
+		std::vector<BVHNode> bvhNodes;
+		std::vector<uint32_t> bvhIndices;
+
+		size_t GetNodeCount() const;
+		const Mesh& GetNodeMesh(size_t node) const;
+
+		//Model space transform of every node in a single pass over the node table
+		void ComputeWorldTransforms(std::vector<Mat4x4>& worldTransforms) const;
+
+		//Instancing, the nodes that reference a mesh from the mesh table
+		size_t GetInstanceCount(uint32_t mesh) const;
+		void GetInstances(uint32_t mesh, std::vector<uint32_t>& nodes) const;
+
+		//BVH queries in model space, results are node indices
+		void QueryFrustum(const Frustum& frustum, std::vector<uint32_t>& results) const;
+		void QueryBox(const BoundingBox& box, std::vector<uint32_t>& results) const;
+		void QueryRay(const Ray& ray, float maxDistance, std::vector<RayHit>& results) const; //Sorted by distance
 	};
 
 
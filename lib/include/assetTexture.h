@@ -6,7 +6,38 @@ namespace Asset
 	enum class TextureFormat
 	{
 		Unknown,
-		RGBA8
+		RGBA8,
+		R8,
+		RG8, //Grayscale textures with alpha store it in G
+		RGB8,
+		BC1, //RGB, 4 bits per texel
+		BC3, //RGBA, 8 bits per texel
+		BC4, //R, 4 bits per texel
+		BC5, //RG, 8 bits per texel
+		BC7 //RGBA, 8 bits per texel
+	};
+
+	struct MipLevel
+	{
+		uint32_t width;
+		uint32_t height;
+		uint64_t offset; //Byte offset into TextureInfo::data
+		uint64_t size;
+	};
+
+	//Independently LZ4 compressed part of a streamable or tiled texture: a tile of one level, or the whole mip tail
+	struct TextureChunk
+	{
+		uint32_t firstMip;
+		uint32_t mipCount;
+		uint64_t offset; //Byte offset into the file blob
+		uint64_t compressedSize;
+
+		//Texel rect within firstMip, the rows of the rect are stored contiguously
+		uint32_t x;
+		uint32_t y;
+		uint32_t width;
+		uint32_t height;
 	};
 
 	struct TextureInfo 
@@ -16,12 +47,30 @@ namespace Asset
 
 		int textureSize;
 		TextureFormat textureFormat;
-		std::array<uint32_t, 3> pixelsize; //[0] width [1] height [2] depth
+		std::array<uint32_t, 3> pixelsize; //[0] width [1] height [2] depth, the layer count of texture arrays (each level holds all layers back to back)
 		std::string originalFile;
+		std::vector<MipLevel> mips; //Level 0 is the full size image, textures without mips have a single level
+
+		std::vector<TextureChunk> chunks; //Empty unless the texture was packed streamable
+		uint32_t residentMip; //Most detailed level in data
+		AssetFile streamSource; //Header only, used to fetch chunks
+
+		std::vector<uint8_t> data; //Mip levels residentMip and below
+
+		const uint8_t* GetMipData(uint32_t level) const;
+
+		bool IsStreamable() const;
+		//Loads or drops whole chunks so level is the most detailed resident mip, returns false if nothing changed
+		bool SetResidentMip(uint32_t level);
 
-		std::vector<uint8_t> data;
+		//Copies a texel rect of a level into dst (rows packed), decoding only the tiles it overlaps when the level is not resident.
+		//Block compressed regions start on a block
+		bool ReadRegion(uint32_t level, uint32_t x, uint32_t y, uint32_t width, uint32_t height, uint8_t* dst) const;
 	};
 
-	TextureInfo ReadTextureInfo(const AssetFile& assetFile);
-	AssetFile PackTexture(TextureInfo* info, void* pixelData);
+	TextureInfo ReadTextureInfo(const AssetFile& assetFile); //Streamable textures loaded without their blob start with only the mip tail resident, data is empty if it fails
+	bool ReadTextureInfo(const AssetFile& assetFile, TextureInfo& info); //False if the blob or a chunk can't be read or decoded
+	//pixelData holds every mip level at the offsets in info->mips. Streamable textures compress each large mip and the mip tail separately,
+	//a tileSize splits the large mips into tiles of that many texels which are decoded in parallel
+	AssetFile PackTexture(TextureInfo* info, void* pixelData, bool streamable = false, uint32_t tileSize = 0);
 }
\ No newline at end of file
@@ -8,9 +8,12 @@ namespace Asset
 	enum class CompressionMode : uint8_t
 	{
 		None,
-		LZ4
+		LZ4,
+		LZ4Chunked //Independent LZ4 chunks of LZ4ChunkSize bytes, compressed and decompressed in parallel
 	};
 
+	constexpr size_t LZ4ChunkSize = 256 * 1024;
+
 	struct Buffer
 	{
 	public:
@@ -18,8 +21,17 @@ namespace Asset
 
 		void CopyFrom(const void* src, size_t size, CompressionMode compressionMode);
 		void CopyTo(void* dst) const;
+		void CopyRangeTo(void* dst, size_t offset, size_t size) const; //Raw bytes of an uncompressed buffer
+
+		//operator>> split in two, so the data can be left on disk
+		std::istream& ReadHeader(std::istream& is);
+		std::istream& ReadData(std::istream& is);
 
 		size_t TotalBufferSize() const;
+		//Bytes operator<< writes, and the same bytes written to dst in one go, returns the end of what was written
+		size_t SerializedSize() const;
+		uint8_t* Serialize(uint8_t* dst) const;
+		uint64_t Hash(uint64_t seed) const; //XXH64 of the header and stored bytes, the data has to be loaded
 
 		friend std::ostream& operator<<(std::ostream& os, const Buffer& buffer);
 		friend std::istream& operator>>(std::istream& os, Buffer& buffer);
@@ -50,6 +50,9 @@ namespace Asset
 	};
 	
 	extern AssetHandle InvalidHandle;
+
+	//Folds an asset file checksum into a handle checksum, never the value used for released slots
+	HandleChecksum FoldChecksum(uint64_t checksum);
 }
 
 namespace std
@@ -0,0 +1,9 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+
+namespace Asset
+{
+	//XXH64 of a block of memory
+	uint64_t HashXXH64(const void* data, size_t size, uint64_t seed = 0);
+}
@@ -23,7 +23,14 @@ namespace Asset
 	public:
 		BaseAssetManager();
 		virtual void Release(HandleIndex index);
+
+		//Duplicates are stored once by the converter, loading an alias returns the handle of the asset it points at
+		void AddAlias(const std::string& alias, const std::string& uri);
+		//Reads the aliases from a converter manifest.json
+		bool LoadAliases(const std::string& manifestPath);
 	protected:
+		std::string ResolveAlias(const std::string& uri) const;
+
 		void Reference(HandleIndex index);
 		void Dereference(HandleIndex index);
 
@@ -38,6 +45,7 @@ namespace Asset
 		std::queue<HandleIndex> m_free;
 
 		std::unordered_map<std::string, HandleIndex> m_uriMap;
+		std::unordered_map<std::string, std::string> m_aliases;
 		std::deque<std::atomic<uint16_t>> m_refCount;
 		std::vector<HandleChecksum> m_checkSums;
 		friend struct AssetHandle;
@@ -48,13 +56,17 @@ namespace Asset
 	{
 	public:
 		AssetManager();
-		AssetHandle Load(const std::string& uri, bool keepFileData = true);
+		//streaming only applies to textures, they load with just the mip tail resident
+		AssetHandle Load(const std::string& uri, bool keepFileData = true, bool streaming = false);
 
 		bool Exists(const AssetHandle& handle);
 		T* Get(const AssetHandle& handle);
 
 		UserT* GetUserData(const AssetHandle& handle);
 
+		//Textures only. Streams mip levels in or out, returns true if the resident data changed
+		bool SetResidentMipLevel(const AssetHandle& handle, uint32_t level);
+
 		void Release(HandleIndex index) override;
 
 		void SetOnLoadCallback(std::function<void(const T&, UserT&)> onLoadCallback);
@@ -150,8 +162,18 @@ namespace Asset
 	}
 
 	template <typename T, typename UserT>
-	AssetHandle Asset::AssetManager<T, UserT>::Load(const std::string& uri, bool keepFileData)
+	bool Asset::AssetManager<T, UserT>::SetResidentMipLevel(const AssetHandle& handle, uint32_t level)
 	{
+		static_assert(std::is_same<T, TextureInfo>::value, "Only textures have mip levels");
+
+		T* texture = Get(handle);
+		return texture && texture->SetResidentMip(level);
+	}
+
+	template <typename T, typename UserT>
+	AssetHandle Asset::AssetManager<T, UserT>::Load(const std::string& requestedUri, bool keepFileData, bool streaming)
+	{
+		const std::string uri = ResolveAlias(requestedUri);
 		if (UriExists(uri))
 		{
 			return AssetHandle(GetIndexFromUri(uri), GetChecksumFromUri(uri), this);
@@ -159,7 +181,8 @@ namespace Asset
 
 		//Load asset File
 		AssetFile file;
-		if(!file.LoadBinaryFile(uri.c_str()))
+		const bool loadBlob = !streaming || !std::is_same<T, TextureInfo>::value;
+		if(!file.LoadBinaryFile(uri.c_str(), loadBlob))
 			return InvalidHandle;
 
 
@@ -171,10 +194,24 @@ namespace Asset
 
 
 
+		//textures are decoded before the handle is added, a chunk that fails to read or decode fails the load
+		std::unique_ptr<T> data;
+		if constexpr (std::is_same<T, TextureInfo>::value)
+		{
+			data = std::make_unique<T>();
+			if (!ReadTextureInfo(file, *data))
+				return InvalidHandle;
+		}
+		else
+		{
+			data = std::make_unique<T>(file);
+		}
+
 		HandleIndex index = static_cast<uint16_t>(m_data.size() - 1);
-		AddNew(index, uri, file.checksum);
+		const HandleChecksum checksum = FoldChecksum(file.checksum);
+		AddNew(index, uri, checksum);
 
-		m_data[index] = std::make_unique<T>(file);
+		m_data[index] = std::move(data);
 
 		if (m_onLoadCallback)
 			m_onLoadCallback(*m_data.at(index).get(), m_userData.at(index));
@@ -182,7 +219,7 @@ namespace Asset
 		if (!keepFileData)
 			m_data[index].reset();
 
-		return AssetHandle(index, file.checksum, this);
+		return AssetHandle(index, checksum, this);
 	}
 
 	template <typename T, typename UserT>
@@ -0,0 +1,9 @@
+#pragma once
+
+//SSE is part of every x64 target, fall back to scalar code everywhere else
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define JAAM_SIMD_SSE 1
+#include <emmintrin.h>
+#else
+#define JAAM_SIMD_SSE 0
+#endif
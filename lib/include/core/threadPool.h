@@ -0,0 +1,57 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <atomic>
+
+namespace Asset
+{
+	/// <summary>
+	/// Fixed set of worker threads that split loops between them, the calling thread works on the loop as well.
+	/// Loops started from inside a worker, or while another loop is running, run inline on the calling thread.
+	/// A pool with an executor has no workers, its loops are handed to the executor
+	/// </summary>
+	class ThreadPool
+	{
+	public:
+		//Runs func(i) for every i in [0, count) and returns once all calls are done, it can be called from any thread at once
+		typedef std::function<void(uint32_t count, const std::function<void(uint32_t)>& func)> Executor;
+
+		ThreadPool(uint32_t workerCount, Executor executor = nullptr);
+		~ThreadPool();
+
+		//Calls func(i) for every i in [0, count) and returns once all calls are done
+		void ParallelFor(uint32_t count, const std::function<void(uint32_t)>& func);
+
+		uint32_t GetWorkerCount() const;
+
+		static ThreadPool& Shared(); //hardware concurrency - 1 workers, used for decoding
+		//Applications with their own scheduler hand the shared pool's loops to it instead of running a second set of threads.
+		//Call before the shared pool is first used
+		static void SetSharedExecutor(Executor executor);
+	private:
+		struct Loop
+		{
+			const std::function<void(uint32_t)>* func;
+			uint32_t count;
+			std::atomic<uint32_t> next;
+			uint32_t activeWorkers;
+		};
+
+		void Work();
+		static void RunLoop(Loop& loop);
+
+		Executor m_executor;
+		std::vector<std::thread> m_workers;
+		std::mutex m_loopLock; //One loop at a time
+		std::mutex m_lock;
+		std::condition_variable m_wake;
+		std::condition_variable m_finished;
+		Loop* m_loop;
+		uint64_t m_generation;
+		bool m_stop;
+	};
+}
@@ -0,0 +1,184 @@
+#include "assetBounds.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+using namespace Asset;
+
+namespace
+{
+	BoundingBox EmptyBox()
+	{
+		constexpr float maxValue = std::numeric_limits<float>::max();
+		return BoundingBox{ { maxValue, maxValue, maxValue }, { -maxValue, -maxValue, -maxValue } };
+	}
+
+	void BuildBVHNode(const std::vector<BoundingBox>& itemBounds, std::vector<BVHNode>& nodes, std::vector<uint32_t>& indices,
+		uint32_t maxLeafSize, size_t nodeIndex, uint32_t begin, uint32_t end)
+	{
+		BoundingBox bounds = EmptyBox();
+		BoundingBox centroidBounds = EmptyBox();
+		for (uint32_t i = begin; i < end; ++i)
+		{
+			const BoundingBox& box = itemBounds[indices[i]];
+			bounds.Merge(box);
+
+			std::array<float, 3> center = box.Center();
+			centroidBounds.Merge(BoundingBox{ center, center });
+		}
+
+		nodes[nodeIndex].bounds = bounds;
+
+		if (end - begin <= maxLeafSize)
+		{
+			nodes[nodeIndex].offset = begin;
+			nodes[nodeIndex].count = end - begin;
+			return;
+		}
+
+		//median split on the axis with the largest centroid extent
+		int axis = 0;
+		for (int i = 1; i < 3; ++i)
+		{
+			if (centroidBounds.max[i] - centroidBounds.min[i] > centroidBounds.max[axis] - centroidBounds.min[axis])
+				axis = i;
+		}
+
+		const uint32_t middle = begin + (end - begin) / 2;
+		std::nth_element(indices.begin() + begin, indices.begin() + middle, indices.begin() + end, [&](uint32_t a, uint32_t b)
+		{
+			return itemBounds[a].Center()[axis] < itemBounds[b].Center()[axis];
+		});
+
+		const uint32_t childIndex = static_cast<uint32_t>(nodes.size());
+		nodes.resize(nodes.size() + 2);
+		nodes[nodeIndex].offset = childIndex;
+		nodes[nodeIndex].count = 0;
+
+		BuildBVHNode(itemBounds, nodes, indices, maxLeafSize, childIndex, begin, middle);
+		BuildBVHNode(itemBounds, nodes, indices, maxLeafSize, childIndex + 1, middle, end);
+	}
+}
+
+std::array<float, 3> BoundingBox::Center() const
+{
+	return { (min[0] + max[0]) * 0.5f, (min[1] + max[1]) * 0.5f, (min[2] + max[2]) * 0.5f };
+}
+
+bool BoundingBox::Intersects(const BoundingBox& other) const
+{
+	return min[0] <= other.max[0] && max[0] >= other.min[0] &&
+		min[1] <= other.max[1] && max[1] >= other.min[1] &&
+		min[2] <= other.max[2] && max[2] >= other.min[2];
+}
+
+void BoundingBox::Merge(const BoundingBox& other)
+{
+	for (int i = 0; i < 3; ++i)
+	{
+		min[i] = std::min(min[i], other.min[i]);
+		max[i] = std::max(max[i], other.max[i]);
+	}
+}
+
+float Ray::Intersects(const BoundingBox& box, float maxDistance) const
+{
+	float tMin = 0.0f;
+	float tMax = maxDistance;
+
+	for (int i = 0; i < 3; ++i)
+	{
+		const float invDirection = 1.0f / direction[i];
+		float t0 = (box.min[i] - origin[i]) * invDirection;
+		float t1 = (box.max[i] - origin[i]) * invDirection;
+		if (t0 > t1)
+			std::swap(t0, t1);
+
+		tMin = std::max(tMin, t0);
+		tMax = std::min(tMax, t1);
+
+		if (tMin > tMax)
+			return -1.0f;
+	}
+
+	return tMin;
+}
+
+Frustum Frustum::FromMatrix(const std::array<float, 16>& m)
+{
+	Frustum frustum;
+
+	for (int i = 0; i < 3; ++i)
+	{
+		for (int c = 0; c < 4; ++c)
+		{
+			frustum.planes[i * 2 + 0][c] = m[12 + c] + m[i * 4 + c];
+			frustum.planes[i * 2 + 1][c] = m[12 + c] - m[i * 4 + c];
+		}
+	}
+
+	for (std::array<float, 4>& plane : frustum.planes)
+	{
+		const float length = std::sqrt(plane[0] * plane[0] + plane[1] * plane[1] + plane[2] * plane[2]);
+		if (length > 0.0f)
+		{
+			for (float& value : plane)
+				value /= length;
+		}
+	}
+
+	return frustum;
+}
+
+bool Frustum::Intersects(const BoundingBox& box) const
+{
+	for (const std::array<float, 4>& plane : planes)
+	{
+		//test the corner furthest along the plane normal
+		const float x = plane[0] >= 0.0f ? box.max[0] : box.min[0];
+		const float y = plane[1] >= 0.0f ? box.max[1] : box.min[1];
+		const float z = plane[2] >= 0.0f ? box.max[2] : box.min[2];
+
+		if (plane[0] * x + plane[1] * y + plane[2] * z + plane[3] < 0.0f)
+			return false;
+	}
+
+	return true;
+}
+
+BoundingBox Asset::TransformBoundingBox(const BoundingBox& box, const std::array<float, 16>& matrix)
+{
+	BoundingBox result;
+
+	for (int row = 0; row < 3; ++row)
+	{
+		result.min[row] = result.max[row] = matrix[row * 4 + 3];
+
+		for (int col = 0; col < 3; ++col)
+		{
+			const float a = matrix[row * 4 + col] * box.min[col];
+			const float b = matrix[row * 4 + col] * box.max[col];
+			result.min[row] += std::min(a, b);
+			result.max[row] += std::max(a, b);
+		}
+	}
+
+	return result;
+}
+
+void Asset::BuildBVH(const std::vector<BoundingBox>& itemBounds, std::vector<BVHNode>& nodes, std::vector<uint32_t>& indices, uint32_t maxLeafSize)
+{
+	nodes.clear();
+	indices.resize(itemBounds.size());
+	for (uint32_t i = 0; i < indices.size(); ++i)
+	{
+		indices[i] = i;
+	}
+
+	if (itemBounds.empty())
+		return;
+
+	nodes.reserve(itemBounds.size() * 2);
+	nodes.resize(1);
+	BuildBVHNode(itemBounds, nodes, indices, std::max(maxLeafSize, 1u), 0, 0, static_cast<uint32_t>(indices.size()));
+}
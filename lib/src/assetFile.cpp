@@ -1,53 +1,92 @@
 #include "assetFile.h"
 #include <fstream>
 #include <filesystem>
+#include <iostream>
+#include "core/assetHash.h"
 
 using namespace Asset;
 
+namespace
+{
+	//0 for types without a version to check
+	uint32_t ExpectedVersion(const FileType& type)
+	{
+		if (type == FileType{ 'T','E','X','I' })
+			return TextureFileVersion;
+		if (type == FileType{ 'M','O','D','L' })
+			return ModelFileVersion;
+		if (type == FileType{ 'M','A','T','X' })
+			return MaterialFileVersion;
+		return 0;
+	}
+}
 
 AssetFile::AssetFile() :
 	type{0,0,0,0},
-	version(0)
+	version(0),
+	checksum(0),
+	blobDataOffset(0),
+	blobLoaded(false)
 {
 
 }
 
 bool AssetFile::SaveBinaryFile(std::string_view path)
 {
-	std::filesystem::path jsonPath(path);
-	jsonPath.replace_extension(jsonPath.extension().string() + ".meta");
 	std::ofstream jsonFile;
-	jsonFile.open(jsonPath, std::ios::out);
+	jsonFile.open(MetaPath(path), std::ios::out);
 	jsonFile << json.data();
 	jsonFile.close();
 
+	const std::vector<uint8_t> binary = SerializeBinary();
+
 	std::ofstream binFile;
 	binFile.open(path.data(), std::ios::binary | std::ios::out);
+	binFile.write(reinterpret_cast<const char*>(binary.data()), binary.size());
+	binFile.close();
 
-	binFile.write(type.data(), type.size());
+	return true;
+}
+
+std::vector<uint8_t> AssetFile::SerializeBinary()
+{
+	//derived from the contents so the same asset always saves to the same bytes
+	checksum = ComputeChecksum();
+
+	std::vector<uint8_t> binary(type.size() + sizeof(version) + sizeof(checksum) + binaryBlob.SerializedSize());
+	uint8_t* dst = binary.data();
+
+	memcpy(dst, type.data(), type.size());
+	dst += type.size();
 
 	//version
-	binFile.write(reinterpret_cast<const char*>(&version), sizeof(version));
+	memcpy(dst, &version, sizeof(version));
+	dst += sizeof(version);
 
 	//checksum
-	binFile.write(reinterpret_cast<const char*>(&checksum), sizeof(checksum));
+	memcpy(dst, &checksum, sizeof(checksum));
+	dst += sizeof(checksum);
 
 	//blob data
-	binFile << binaryBlob;
-
-	binFile.close();
+	binaryBlob.Serialize(dst);
 
-	return true;
+	return binary;
 }
 
-bool AssetFile::LoadBinaryFile(std::string_view path)
+std::string AssetFile::MetaPath(std::string_view path)
 {
 	std::filesystem::path jsonPath(path);
 	jsonPath.replace_extension(jsonPath.extension().string() + ".meta");
+	return jsonPath.string();
+}
+
+bool AssetFile::LoadBinaryFile(std::string_view path, bool loadBlob)
+{
+	this->path = path;
 
 	std::ifstream jsonFile;
 	std::stringstream buffer;
-	jsonFile.open(jsonPath, std::ios::in);
+	jsonFile.open(MetaPath(path), std::ios::in);
 	if (!jsonFile.is_open()) return false;
 
 	buffer << jsonFile.rdbuf();
@@ -62,24 +101,78 @@ bool AssetFile::LoadBinaryFile(std::string_view path)
 
 	infile.read(type.data(), type.size());
 
-	//version
+	//version, the rest of the header depends on it
 	infile.read(reinterpret_cast<char*>(&version), sizeof(version));
+	if (!infile)
+		return false;
+
+	const uint32_t expectedVersion = ExpectedVersion(type);
+	if (expectedVersion != 0 && version != expectedVersion)
+	{
+		std::cerr << path << " is version " << version << " of its format, this build reads version " << expectedVersion << ", convert it again" << std::endl;
+		return false;
+	}
 
 	//checksum
 	infile.read(reinterpret_cast<char*>(&checksum), sizeof(checksum));
 
 	//blob data
-	infile >> binaryBlob;
+	binaryBlob.ReadHeader(infile);
+	blobDataOffset = static_cast<uint64_t>(infile.tellg());
+
+	if (loadBlob)
+		binaryBlob.ReadData(infile);
+	blobLoaded = loadBlob;
+
+	//a streamed blob is left on disk so it can't be checked here
+	if (loadBlob)
+	{
+		const uint64_t computed = ComputeChecksum();
+		if (computed != checksum)
+		{
+			std::cerr << path << " is corrupt, its checksum is " << std::hex << checksum << " but its contents hash to " << computed << std::dec << std::endl;
+			return false;
+		}
+	}
 
 	return true;
 }
 
+bool AssetFile::ReadBlobRange(uint64_t offset, uint64_t size, void* dst) const
+{
+	if (blobLoaded)
+	{
+		binaryBlob.CopyRangeTo(dst, offset, size);
+		return true;
+	}
+
+	std::ifstream infile;
+	infile.open(path, std::ios::binary | std::ios::in);
+	if (!infile.is_open()) return false;
+
+	infile.seekg(blobDataOffset + offset);
+	infile.read(reinterpret_cast<char*>(dst), size);
+	return static_cast<uint64_t>(infile.gcount()) == size;
+}
+
+uint64_t AssetFile::ComputeChecksum() const
+{
+	uint64_t hash = HashXXH64(type.data(), type.size());
+	hash = HashXXH64(&version, sizeof(version), hash);
+	hash = HashXXH64(json.data(), json.size(), hash);
+	return binaryBlob.Hash(hash);
+}
+
 CompressionMode Asset::ParseCompression(const char* f)
 {
 	if (strcmp(f, "LZ4") == 0)
 	{
 		return CompressionMode::LZ4;
 	}
+	else if (strcmp(f, "LZ4Chunked") == 0)
+	{
+		return CompressionMode::LZ4Chunked;
+	}
 	else
 	{
 		return CompressionMode::None;
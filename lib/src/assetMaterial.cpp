@@ -29,6 +29,24 @@ MaterialInfo Asset::ReadMaterialInfo(const AssetFile& file)
 		info.textures[key] = value;
 	}
 
+	auto channels = material_metadata.find("textureChannels");
+	if (channels != material_metadata.end())
+	{
+		info.textureChannels = channels->get<std::unordered_map<std::string, uint32_t>>();
+	}
+
+	auto rects = material_metadata.find("textureRects");
+	if (rects != material_metadata.end())
+	{
+		info.textureRects = rects->get<std::unordered_map<std::string, std::array<float, 4>>>();
+	}
+
+	auto layers = material_metadata.find("textureLayers");
+	if (layers != material_metadata.end())
+	{
+		info.textureLayers = layers->get<std::unordered_map<std::string, uint32_t>>();
+	}
+
 	info.floatParamters = material_metadata["floatParamters"];
 	info.intParamters = material_metadata["intParamters"];
 	info.vec3Paramters = material_metadata["float3Paramters"];
@@ -59,6 +77,12 @@ AssetFile Asset::PackMaterial(MaterialInfo& info)
 	material_metadata["name"] = info.name;
 	material_metadata["baseEffect"] = info.baseEffect;
 	material_metadata["textures"] = info.textures;
+	if (!info.textureChannels.empty())
+		material_metadata["textureChannels"] = info.textureChannels;
+	if (!info.textureRects.empty())
+		material_metadata["textureRects"] = info.textureRects;
+	if (!info.textureLayers.empty())
+		material_metadata["textureLayers"] = info.textureLayers;
 
 	material_metadata["floatParamters"] = info.floatParamters;
 	material_metadata["intParamters"] = info.intParamters;
@@ -85,7 +109,7 @@ AssetFile Asset::PackMaterial(MaterialInfo& info)
 	file.type[1] = 'A';
 	file.type[2] = 'T';
 	file.type[3] = 'X';
-	file.version = 1;
+	file.version = MaterialFileVersion;
 
 	std::string stringified = material_metadata.dump();
 	file.json = stringified;
@@ -1,6 +1,7 @@
 #include "assetModel.h"
 #include "nlohmann/json.hpp"
 #include "lz4.H"
+#include "core/simd.h"
 
 using namespace Asset;
 
@@ -8,7 +9,7 @@ namespace
 {
 	size_t GetMeshDataSize(const std::vector<Mesh>& meshes)
 	{
-		size_t size = sizeof(size_t); //Store the mesh count
+		size_t size = sizeof(uint32_t); //Store the mesh count
 
 		size += std::accumulate(meshes.begin(), meshes.end(), size_t(0), [](size_t sum, const Mesh& mesh) -> size_t
 		{
@@ -16,16 +17,30 @@ namespace
 			sizeof(uint8_t) + // input element count
 			sizeof(VertexDataType) * mesh.vertexBuffer.inputTypes.size() +
 			sizeof(bool) + // interleaved
-			sizeof(uint64_t) + // vertex buffer size;
+			sizeof(uint32_t) + // vertex buffer size;
 			mesh.vertexBuffer.data.size() +
-			sizeof(uint64_t) + // index buffer size;
+			sizeof(uint32_t) + // index buffer size;
 			mesh.indexBuffer.size() * sizeof(uint32_t); //index is a 32bit uint
 		});
 
 		return size;
 	}
 
-	void PackMeshData(const std::vector<Mesh>& meshes, std::vector<char>& binaryBlob, size_t startIndex)
+	size_t GetMeshletDataSize(const std::vector<Mesh>& meshes)
+	{
+		return std::accumulate(meshes.begin(), meshes.end(), size_t(0), [](size_t sum, const Mesh& mesh) -> size_t
+		{
+			return sum +
+			sizeof(uint32_t) + // meshlet count
+			mesh.meshlets.size() * sizeof(Meshlet) +
+			sizeof(uint32_t) + // meshlet vertex count
+			mesh.meshletVertices.size() * sizeof(uint32_t) +
+			sizeof(uint32_t) + // meshlet triangle byte count
+			mesh.meshletTriangles.size();
+		});
+	}
+
+	size_t PackMeshData(const std::vector<Mesh>& meshes, std::vector<char>& binaryBlob, size_t startIndex)
 	{
 		uint32_t meshCount = static_cast<uint32_t>(meshes.size());
 
@@ -34,7 +49,7 @@ namespace
 
 		size_t srcIndex = startIndex;
 
-		for (int i = 0; i < meshes.size(); ++i)
+		for (size_t i = 0; i < meshes.size(); ++i)
 		{
 			const Mesh& mesh = meshes[i];
 
@@ -69,9 +84,11 @@ namespace
 			srcIndex += mesh.indexBuffer.size() * sizeof(uint32_t);
 
 		}
+
+		return srcIndex;
 	}
 
-	void ReadMeshData(ModelInfo& info, std::vector<char>& binaryBlob, size_t startIndex)
+	size_t ReadMeshData(ModelInfo& info, std::vector<char>& binaryBlob, size_t startIndex)
 	{
 		uint32_t meshCount = 0;
 		memcpy(&meshCount, &binaryBlob[startIndex], sizeof(meshCount));
@@ -118,6 +135,286 @@ namespace
 			srcIndex += mesh.indexBuffer.size() * sizeof(uint32_t);
 
 		}
+
+		return srcIndex;
+	}
+
+	size_t PackMeshletData(const std::vector<Mesh>& meshes, std::vector<char>& binaryBlob, size_t startIndex)
+	{
+		size_t srcIndex = startIndex;
+
+		for (const Mesh& mesh : meshes)
+		{
+			uint32_t meshletCount = static_cast<uint32_t>(mesh.meshlets.size());
+			memcpy(&binaryBlob[srcIndex], &meshletCount, sizeof(uint32_t));
+			srcIndex += sizeof(uint32_t);
+
+			memcpy(&binaryBlob[srcIndex], mesh.meshlets.data(), mesh.meshlets.size() * sizeof(Meshlet));
+			srcIndex += mesh.meshlets.size() * sizeof(Meshlet);
+
+			uint32_t vertexCount = static_cast<uint32_t>(mesh.meshletVertices.size());
+			memcpy(&binaryBlob[srcIndex], &vertexCount, sizeof(uint32_t));
+			srcIndex += sizeof(uint32_t);
+
+			memcpy(&binaryBlob[srcIndex], mesh.meshletVertices.data(), mesh.meshletVertices.size() * sizeof(uint32_t));
+			srcIndex += mesh.meshletVertices.size() * sizeof(uint32_t);
+
+			uint32_t triangleBytes = static_cast<uint32_t>(mesh.meshletTriangles.size());
+			memcpy(&binaryBlob[srcIndex], &triangleBytes, sizeof(uint32_t));
+			srcIndex += sizeof(uint32_t);
+
+			memcpy(&binaryBlob[srcIndex], mesh.meshletTriangles.data(), mesh.meshletTriangles.size());
+			srcIndex += mesh.meshletTriangles.size();
+		}
+
+		return srcIndex;
+	}
+
+	size_t ReadMeshletData(ModelInfo& info, std::vector<char>& binaryBlob, size_t startIndex)
+	{
+		size_t srcIndex = startIndex;
+
+		for (Mesh& mesh : info.meshes)
+		{
+			uint32_t meshletCount = 0;
+			memcpy(&meshletCount, &binaryBlob[srcIndex], sizeof(uint32_t));
+			mesh.meshlets.resize(meshletCount);
+			srcIndex += sizeof(uint32_t);
+
+			memcpy(mesh.meshlets.data(), &binaryBlob[srcIndex], mesh.meshlets.size() * sizeof(Meshlet));
+			srcIndex += mesh.meshlets.size() * sizeof(Meshlet);
+
+			uint32_t vertexCount = 0;
+			memcpy(&vertexCount, &binaryBlob[srcIndex], sizeof(uint32_t));
+			mesh.meshletVertices.resize(vertexCount);
+			srcIndex += sizeof(uint32_t);
+
+			memcpy(mesh.meshletVertices.data(), &binaryBlob[srcIndex], mesh.meshletVertices.size() * sizeof(uint32_t));
+			srcIndex += mesh.meshletVertices.size() * sizeof(uint32_t);
+
+			uint32_t triangleBytes = 0;
+			memcpy(&triangleBytes, &binaryBlob[srcIndex], sizeof(uint32_t));
+			mesh.meshletTriangles.resize(triangleBytes);
+			srcIndex += sizeof(uint32_t);
+
+			memcpy(mesh.meshletTriangles.data(), &binaryBlob[srcIndex], mesh.meshletTriangles.size());
+			srcIndex += mesh.meshletTriangles.size();
+		}
+
+		return srcIndex;
+	}
+	size_t GetBoundsDataSize(const ModelInfo& info)
+	{
+		return info.meshes.size() * (sizeof(BoundingBox) + sizeof(BoundingSphere)) +
+			sizeof(uint32_t) + info.modelSpaceBounds.size() * sizeof(BoundingBox) +
+			sizeof(uint32_t) + info.bvhNodes.size() * sizeof(BVHNode) +
+			sizeof(uint32_t) + info.bvhIndices.size() * sizeof(uint32_t);
+	}
+
+	template <typename T>
+	size_t PackArray(const std::vector<T>& array, std::vector<char>& binaryBlob, size_t srcIndex)
+	{
+		uint32_t count = static_cast<uint32_t>(array.size());
+		memcpy(&binaryBlob[srcIndex], &count, sizeof(uint32_t));
+		srcIndex += sizeof(uint32_t);
+
+		memcpy(&binaryBlob[srcIndex], array.data(), array.size() * sizeof(T));
+		return srcIndex + array.size() * sizeof(T);
+	}
+
+	template <typename T>
+	size_t ReadArray(std::vector<T>& array, std::vector<char>& binaryBlob, size_t srcIndex)
+	{
+		uint32_t count = 0;
+		memcpy(&count, &binaryBlob[srcIndex], sizeof(uint32_t));
+		array.resize(count);
+		srcIndex += sizeof(uint32_t);
+
+		memcpy(array.data(), &binaryBlob[srcIndex], array.size() * sizeof(T));
+		return srcIndex + array.size() * sizeof(T);
+	}
+
+	size_t PackBoundsData(const ModelInfo& info, std::vector<char>& binaryBlob, size_t startIndex)
+	{
+		size_t srcIndex = startIndex;
+
+		for (const Mesh& mesh : info.meshes)
+		{
+			memcpy(&binaryBlob[srcIndex], &mesh.bounds, sizeof(BoundingBox));
+			srcIndex += sizeof(BoundingBox);
+
+			memcpy(&binaryBlob[srcIndex], &mesh.boundingSphere, sizeof(BoundingSphere));
+			srcIndex += sizeof(BoundingSphere);
+		}
+
+		srcIndex = PackArray(info.modelSpaceBounds, binaryBlob, srcIndex);
+		srcIndex = PackArray(info.bvhNodes, binaryBlob, srcIndex);
+		srcIndex = PackArray(info.bvhIndices, binaryBlob, srcIndex);
+
+		return srcIndex;
+	}
+
+	size_t ReadBoundsData(ModelInfo& info, std::vector<char>& binaryBlob, size_t startIndex)
+	{
+		size_t srcIndex = startIndex;
+
+		for (Mesh& mesh : info.meshes)
+		{
+			memcpy(&mesh.bounds, &binaryBlob[srcIndex], sizeof(BoundingBox));
+			srcIndex += sizeof(BoundingBox);
+
+			memcpy(&mesh.boundingSphere, &binaryBlob[srcIndex], sizeof(BoundingSphere));
+			srcIndex += sizeof(BoundingSphere);
+		}
+
+		srcIndex = ReadArray(info.modelSpaceBounds, binaryBlob, srcIndex);
+		srcIndex = ReadArray(info.bvhNodes, binaryBlob, srcIndex);
+		srcIndex = ReadArray(info.bvhIndices, binaryBlob, srcIndex);
+
+		return srcIndex;
+	}
+
+	//Walks the bvh, boundsTest culls whole subtrees and nodeTest is run on the model nodes of the visited leaves
+	template <typename BoundsTest, typename NodeTest>
+	void TraverseBVH(const ModelInfo& info, BoundsTest boundsTest, NodeTest nodeTest)
+	{
+		if (info.bvhNodes.empty())
+			return;
+
+		uint32_t stack[64];
+		uint32_t stackSize = 0;
+		stack[stackSize++] = 0;
+
+		while (stackSize > 0)
+		{
+			const BVHNode& bvhNode = info.bvhNodes[stack[--stackSize]];
+			if (!boundsTest(bvhNode.bounds))
+				continue;
+
+			if (bvhNode.count == 0)
+			{
+				stack[stackSize++] = bvhNode.offset;
+				stack[stackSize++] = bvhNode.offset + 1;
+				continue;
+			}
+
+			for (uint32_t i = bvhNode.offset; i < bvhNode.offset + bvhNode.count; ++i)
+			{
+				const uint32_t node = info.bvhIndices[i];
+				nodeTest(node, info.modelSpaceBounds[node]);
+			}
+		}
+	}
+	template <size_t Size>
+	void CopyStrided(const uint8_t* src, size_t srcStride, uint8_t* dst, size_t dstStride, size_t count)
+	{
+		for (size_t i = 0; i < count; ++i)
+		{
+			memcpy(dst + i * dstStride, src + i * srcStride, Size);
+		}
+	}
+
+#if JAAM_SIMD_SSE
+	//Gathers float3 elements into a packed array, 4 elements (three 16 byte stores) per iteration
+	size_t GatherFloat3(const uint8_t* src, size_t srcStride, uint8_t* dst, size_t count)
+	{
+		//each 16 byte load reads 4 bytes past the element, stop before the last one
+		size_t i = 0;
+		for (; i + 5 <= count; i += 4)
+		{
+			const __m128 a = _mm_loadu_ps(reinterpret_cast<const float*>(src + (i + 0) * srcStride));
+			const __m128 b = _mm_loadu_ps(reinterpret_cast<const float*>(src + (i + 1) * srcStride));
+			const __m128 c = _mm_loadu_ps(reinterpret_cast<const float*>(src + (i + 2) * srcStride));
+			const __m128 d = _mm_loadu_ps(reinterpret_cast<const float*>(src + (i + 3) * srcStride));
+
+			const __m128 ab = _mm_shuffle_ps(a, b, _MM_SHUFFLE(0, 0, 2, 2)); // a2 a2 b0 b0
+			const __m128 cd = _mm_shuffle_ps(c, d, _MM_SHUFFLE(0, 0, 2, 2)); // c2 c2 d0 d0
+
+			float* out = reinterpret_cast<float*>(dst + i * 12);
+			_mm_storeu_ps(out + 0, _mm_shuffle_ps(a, ab, _MM_SHUFFLE(2, 0, 1, 0))); // a0 a1 a2 b0
+			_mm_storeu_ps(out + 4, _mm_shuffle_ps(b, c, _MM_SHUFFLE(1, 0, 2, 1)));  // b1 b2 c0 c1
+			_mm_storeu_ps(out + 8, _mm_shuffle_ps(cd, d, _MM_SHUFFLE(2, 1, 2, 0))); // c2 d0 d1 d2
+		}
+
+		return i;
+	}
+
+	//Gathers float2 elements into a packed array, 2 elements per 16 byte store
+	size_t GatherFloat2(const uint8_t* src, size_t srcStride, uint8_t* dst, size_t count)
+	{
+		size_t i = 0;
+		for (; i + 2 <= count; i += 2)
+		{
+			const __m128i a = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(src + (i + 0) * srcStride));
+			const __m128i b = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(src + (i + 1) * srcStride));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i * 8), _mm_unpacklo_epi64(a, b));
+		}
+
+		return i;
+	}
+#endif
+
+	void CopyAttribute(const uint8_t* src, size_t srcStride, uint8_t* dst, size_t dstStride, size_t count, uint32_t size)
+	{
+		//Packed destinations (deinterleave/extract) take the vector path, the tail and scatters use fixed size copies
+		size_t done = 0;
+#if JAAM_SIMD_SSE
+		if (dstStride == size && size == sizeof(float) * 3)
+			done = GatherFloat3(src, srcStride, dst, count);
+		else if (dstStride == size && size == sizeof(float) * 2)
+			done = GatherFloat2(src, srcStride, dst, count);
+#endif
+
+		src += done * srcStride;
+		dst += done * dstStride;
+		count -= done;
+
+		switch (size)
+		{
+		case sizeof(float) * 2:
+			CopyStrided<sizeof(float) * 2>(src, srcStride, dst, dstStride, count);
+			break;
+		case sizeof(float) * 3:
+			CopyStrided<sizeof(float) * 3>(src, srcStride, dst, dstStride, count);
+			break;
+		default:
+			for (size_t i = 0; i < count; ++i)
+			{
+				memcpy(dst + i * dstStride, src + i * srcStride, size);
+			}
+			break;
+		}
+	}
+	void MultiplyMatrix(const Mat4x4& a, const Mat4x4& b, Mat4x4& result)
+	{
+#if JAAM_SIMD_SSE
+		const __m128 b0 = _mm_loadu_ps(&b[0]);
+		const __m128 b1 = _mm_loadu_ps(&b[4]);
+		const __m128 b2 = _mm_loadu_ps(&b[8]);
+		const __m128 b3 = _mm_loadu_ps(&b[12]);
+
+		//each row of the result is a linear combination of the rows of b
+		for (int row = 0; row < 4; ++row)
+		{
+			__m128 r = _mm_mul_ps(_mm_set1_ps(a[row * 4 + 0]), b0);
+			r = _mm_add_ps(r, _mm_mul_ps(_mm_set1_ps(a[row * 4 + 1]), b1));
+			r = _mm_add_ps(r, _mm_mul_ps(_mm_set1_ps(a[row * 4 + 2]), b2));
+			r = _mm_add_ps(r, _mm_mul_ps(_mm_set1_ps(a[row * 4 + 3]), b3));
+			_mm_storeu_ps(&result[row * 4], r);
+		}
+#else
+		for (int row = 0; row < 4; ++row)
+		{
+			for (int col = 0; col < 4; ++col)
+			{
+				result[row * 4 + col] =
+					a[row * 4 + 0] * b[0 + col] +
+					a[row * 4 + 1] * b[4 + col] +
+					a[row * 4 + 2] * b[8 + col] +
+					a[row * 4 + 3] * b[12 + col];
+			}
+		}
+#endif
 	}
 }
 
@@ -140,13 +437,47 @@ ModelInfo Asset::ReadModelInfo(const AssetFile& file)
 	info.meshMaterials = model_metadata["meshMaterials"];
 	info.meshParents = model_metadata["meshParents"];
 
+	//version 1 models store one mesh per node
+	if (model_metadata.contains("nodeMeshes"))
+	{
+		info.nodeMeshes = model_metadata["nodeMeshes"].get<std::vector<uint32_t>>();
+	}
+	else
+	{
+		info.nodeMeshes.resize(info.meshNames.size());
+		std::iota(info.nodeMeshes.begin(), info.nodeMeshes.end(), 0);
+	}
+
+	if (model_metadata.contains("nodeParents"))
+	{
+		info.nodeParents = model_metadata["nodeParents"].get<std::vector<int32_t>>();
+	}
+	else
+	{
+		//older models only have the parent map, which can reference nodes that were not written
+		info.nodeParents.resize(info.meshNames.size(), -1);
+		for (const auto& [node, parent] : info.meshParents)
+		{
+			if (node < info.nodeParents.size() && parent < node)
+				info.nodeParents[node] = static_cast<int32_t>(parent);
+		}
+	}
+
 	std::vector<char> tempBuffer(file.binaryBlob.TotalBufferSize());
 	file.binaryBlob.CopyTo(tempBuffer.data());
 
 	info.transformMatrix.resize(info.meshNames.size());
 	memcpy(info.transformMatrix.data(), tempBuffer.data(), info.transformMatrix.size() * sizeof(Mat4x4));
 
-	ReadMeshData(info, tempBuffer, info.transformMatrix.size() * sizeof(Mat4x4));
+	size_t offset = ReadMeshData(info, tempBuffer, info.transformMatrix.size() * sizeof(Mat4x4));
+
+	//Optional sections
+	if (model_metadata.value("meshlets", false))
+		offset = ReadMeshletData(info, tempBuffer, offset);
+	if (model_metadata.value("bounds", false))
+		offset = ReadBoundsData(info, tempBuffer, offset);
+	if (model_metadata.value("worldTransforms", false))
+		offset = ReadArray(info.worldMatrix, tempBuffer, offset);
 
 	return info;
 }
@@ -161,24 +492,47 @@ AssetFile Asset::PackModel(const ModelInfo& info)
 	file.type[1] = 'O';
 	file.type[2] = 'D';
 	file.type[3] = 'L';
-	file.version = 1;
+	file.version = ModelFileVersion;
 
 	model_metadata["meshNames"] = info.meshNames;
 	model_metadata["meshMaterials"] = info.meshMaterials;
 	model_metadata["meshParents"] = info.meshParents;
+	model_metadata["nodeMeshes"] = info.nodeMeshes;
+	model_metadata["nodeParents"] = info.nodeParents;
 
+	const bool hasMeshlets = std::any_of(info.meshes.begin(), info.meshes.end(), [](const Mesh& mesh) { return !mesh.meshlets.empty(); });
+	model_metadata["meshlets"] = hasMeshlets;
+
+	const bool hasBounds = !info.bvhNodes.empty();
+	model_metadata["bounds"] = hasBounds;
+
+	const bool hasWorldTransforms = !info.worldMatrix.empty();
+	model_metadata["worldTransforms"] = hasWorldTransforms;
 	
 	const size_t totalBlobSize = info.transformMatrix.size() * sizeof(Mat4x4) +
-		GetMeshDataSize(info.meshes);
+		GetMeshDataSize(info.meshes) +
+		(hasMeshlets ? GetMeshletDataSize(info.meshes) : 0) +
+		(hasBounds ? GetBoundsDataSize(info) : 0) +
+		(hasWorldTransforms ? sizeof(uint32_t) + info.worldMatrix.size() * sizeof(Mat4x4) : 0);
 
 	std::vector<char> tempBuffer(totalBlobSize);
 
 	memcpy(tempBuffer.data(), info.transformMatrix.data(), info.transformMatrix.size() * sizeof(Mat4x4));
 
 	//now pack the mesh data
-	PackMeshData(info.meshes, tempBuffer, info.transformMatrix.size() * sizeof(Mat4x4));
+	size_t offset = PackMeshData(info.meshes, tempBuffer, info.transformMatrix.size() * sizeof(Mat4x4));
+
+	//Optional sections
+	if (hasMeshlets)
+		offset = PackMeshletData(info.meshes, tempBuffer, offset);
+	if (hasBounds)
+		offset = PackBoundsData(info, tempBuffer, offset);
+	if (hasWorldTransforms)
+		offset = PackArray(info.worldMatrix, tempBuffer, offset);
 
-	file.binaryBlob.CopyFrom(tempBuffer.data(), tempBuffer.size(), CompressionMode::LZ4);
+	//large models are compressed and decompressed in parallel chunks
+	const CompressionMode compression = tempBuffer.size() > LZ4ChunkSize ? CompressionMode::LZ4Chunked : CompressionMode::LZ4;
+	file.binaryBlob.CopyFrom(tempBuffer.data(), tempBuffer.size(), compression);
 
 	std::string stringified = model_metadata.dump();
 	file.json = stringified;
@@ -186,28 +540,111 @@ AssetFile Asset::PackModel(const ModelInfo& info)
 	return file;
 }
 
-uint32_t VertexBuffer::GetStride() const
+size_t ModelInfo::GetNodeCount() const
 {
-	return std::accumulate(inputTypes.begin(), inputTypes.end(), 0u, [](uint32_t sum, VertexDataType type) -> uint32_t
+	return nodeMeshes.size();
+}
+
+const Mesh& ModelInfo::GetNodeMesh(size_t node) const
+{
+	assert(node < nodeMeshes.size()); // Index out of bounds
+	return meshes[nodeMeshes[node]];
+}
+
+void ModelInfo::ComputeWorldTransforms(std::vector<Mat4x4>& worldTransforms) const
+{
+	worldTransforms.resize(transformMatrix.size());
+
+	for (size_t node = 0; node < transformMatrix.size(); ++node)
 	{
-		switch (type)
-		{
-		case Asset::VertexDataType::PositionFloat2:
-			return sum + (sizeof(float) * 2);
-		case Asset::VertexDataType::PositionFloat3:
-			return sum + (sizeof(float) * 3);
-		case Asset::VertexDataType::NormalFloat3:
-			return sum + (sizeof(float) * 3);
-		case Asset::VertexDataType::ColorFloat2:
-			return sum + (sizeof(float) * 2);
-		case Asset::VertexDataType::ColorFloat3:
-			return sum + (sizeof(float) * 3);
-		case Asset::VertexDataType::TexCoordFloat2:
-			return sum + (sizeof(float) * 2);
+		const int32_t parent = node < nodeParents.size() ? nodeParents[node] : -1;
+		if (parent < 0)
+		{
+			worldTransforms[node] = transformMatrix[node];
+			continue;
 		}
 
-		assert(false); // type doesn't have a size
-		return sum;
+		assert(static_cast<size_t>(parent) < node); // Parents must come before their children
+		MultiplyMatrix(worldTransforms[parent], transformMatrix[node], worldTransforms[node]);
+	}
+}
+
+size_t ModelInfo::GetInstanceCount(uint32_t mesh) const
+{
+	return std::count(nodeMeshes.begin(), nodeMeshes.end(), mesh);
+}
+
+void ModelInfo::GetInstances(uint32_t mesh, std::vector<uint32_t>& nodes) const
+{
+	for (uint32_t node = 0; node < nodeMeshes.size(); ++node)
+	{
+		if (nodeMeshes[node] == mesh)
+			nodes.emplace_back(node);
+	}
+}
+
+void ModelInfo::QueryFrustum(const Frustum& frustum, std::vector<uint32_t>& results) const
+{
+	auto test = [&](const BoundingBox& box) { return frustum.Intersects(box); };
+	TraverseBVH(*this, test, [&](uint32_t node, const BoundingBox& box)
+	{
+		if (test(box))
+			results.emplace_back(node);
+	});
+}
+
+void ModelInfo::QueryBox(const BoundingBox& queryBox, std::vector<uint32_t>& results) const
+{
+	auto test = [&](const BoundingBox& box) { return queryBox.Intersects(box); };
+	TraverseBVH(*this, test, [&](uint32_t node, const BoundingBox& box)
+	{
+		if (test(box))
+			results.emplace_back(node);
+	});
+}
+
+void ModelInfo::QueryRay(const Ray& ray, float maxDistance, std::vector<RayHit>& results) const
+{
+	const size_t firstResult = results.size();
+
+	auto test = [&](const BoundingBox& box) { return ray.Intersects(box, maxDistance) >= 0.0f; };
+	TraverseBVH(*this, test, [&](uint32_t node, const BoundingBox& box)
+	{
+		float distance = ray.Intersects(box, maxDistance);
+		if (distance >= 0.0f)
+			results.emplace_back(RayHit{ node, distance });
+	});
+
+	std::sort(results.begin() + firstResult, results.end(), [](const RayHit& a, const RayHit& b) { return a.distance < b.distance; });
+}
+
+uint32_t Asset::GetVertexDataTypeSize(VertexDataType type)
+{
+	switch (type)
+	{
+	case Asset::VertexDataType::PositionFloat2:
+		return sizeof(float) * 2;
+	case Asset::VertexDataType::PositionFloat3:
+		return sizeof(float) * 3;
+	case Asset::VertexDataType::NormalFloat3:
+		return sizeof(float) * 3;
+	case Asset::VertexDataType::ColorFloat2:
+		return sizeof(float) * 2;
+	case Asset::VertexDataType::ColorFloat3:
+		return sizeof(float) * 3;
+	case Asset::VertexDataType::TexCoordFloat2:
+		return sizeof(float) * 2;
+	}
+
+	assert(false); // type doesn't have a size
+	return 0;
+}
+
+uint32_t VertexBuffer::GetStride() const
+{
+	return std::accumulate(inputTypes.begin(), inputTypes.end(), 0u, [](uint32_t sum, VertexDataType type) -> uint32_t
+	{
+		return sum + GetVertexDataTypeSize(type);
 	});
 }
 
@@ -215,3 +652,81 @@ size_t VertexBuffer::GetVertexCount() const
 {
 	return data.size() / GetStride();
 }
+
+bool VertexBuffer::HasAttribute(VertexDataType type) const
+{
+	return std::find(inputTypes.begin(), inputTypes.end(), type) != inputTypes.end();
+}
+
+size_t VertexBuffer::GetAttributeOffset(VertexDataType type) const
+{
+	size_t offset = 0;
+	for (VertexDataType inputType : inputTypes)
+	{
+		if (inputType == type)
+			break;
+
+		offset += GetVertexDataTypeSize(inputType);
+	}
+
+	assert(HasAttribute(type)); // vertex buffer doesn't contain the attribute
+
+	//non interleaved buffers store each attribute as its own stream
+	return interleaved ? offset : offset * GetVertexCount();
+}
+
+uint32_t VertexBuffer::GetAttributeStride(VertexDataType type) const
+{
+	return interleaved ? GetStride() : GetVertexDataTypeSize(type);
+}
+
+void VertexBuffer::ExtractAttribute(VertexDataType type, void* dst) const
+{
+	if (data.empty())
+		return;
+
+	const uint32_t size = GetVertexDataTypeSize(type);
+	CopyAttribute(data.data() + GetAttributeOffset(type), GetAttributeStride(type), static_cast<uint8_t*>(dst), size, GetVertexCount(), size);
+}
+
+void VertexBuffer::Interleave()
+{
+	if (interleaved)
+		return;
+
+	const size_t vertexCount = data.empty() ? 0 : GetVertexCount();
+	const uint32_t stride = GetStride();
+
+	std::vector<uint8_t> interleavedData(data.size());
+	size_t vertexOffset = 0;
+	for (VertexDataType type : inputTypes)
+	{
+		const uint32_t size = GetVertexDataTypeSize(type);
+		CopyAttribute(data.data() + GetAttributeOffset(type), size, interleavedData.data() + vertexOffset, stride, vertexCount, size);
+		vertexOffset += size;
+	}
+
+	data = std::move(interleavedData);
+	interleaved = true;
+}
+
+void VertexBuffer::Deinterleave()
+{
+	if (!interleaved)
+		return;
+
+	const size_t vertexCount = data.empty() ? 0 : GetVertexCount();
+	const uint32_t stride = GetStride();
+
+	std::vector<uint8_t> streamData(data.size());
+	size_t vertexOffset = 0;
+	for (VertexDataType type : inputTypes)
+	{
+		const uint32_t size = GetVertexDataTypeSize(type);
+		CopyAttribute(data.data() + vertexOffset, stride, streamData.data() + vertexOffset * vertexCount, size, vertexCount, size);
+		vertexOffset += size;
+	}
+
+	data = std::move(streamData);
+	interleaved = false;
+}
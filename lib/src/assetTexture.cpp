@@ -1,15 +1,149 @@
 #include "assetTexture.h"
+#include "core/threadPool.h"
 #include "nlohmann/json.hpp"
 #include "lz4.H"
 #include "magic_enum.hpp"
 
 using namespace Asset;
 
+namespace
+{
+	//Levels with both sides at or below this are streamed together as the mip tail
+	constexpr uint32_t MipTailSize = 64;
+
+	//Texels per side of a block, rows of block compressed formats are rows of blocks
+	uint32_t BlockDimension(TextureFormat format)
+	{
+		switch (format)
+		{
+		case TextureFormat::BC1:
+		case TextureFormat::BC3:
+		case TextureFormat::BC4:
+		case TextureFormat::BC5:
+		case TextureFormat::BC7:
+			return 4;
+		default:
+			return 1;
+		}
+	}
+
+	uint32_t BlockBytes(TextureFormat format)
+	{
+		switch (format)
+		{
+		case TextureFormat::R8:
+			return 1;
+		case TextureFormat::RG8:
+			return 2;
+		case TextureFormat::RGB8:
+			return 3;
+		case TextureFormat::BC1:
+		case TextureFormat::BC4:
+			return 8;
+		case TextureFormat::BC3:
+		case TextureFormat::BC5:
+		case TextureFormat::BC7:
+			return 16;
+		default:
+			return 4;
+		}
+	}
+
+	uint64_t RowPitch(TextureFormat format, uint32_t width)
+	{
+		const uint32_t block = BlockDimension(format);
+		return static_cast<uint64_t>((width + block - 1) / block) * BlockBytes(format);
+	}
+
+	uint32_t RowCount(TextureFormat format, uint32_t height)
+	{
+		const uint32_t block = BlockDimension(format);
+		return (height + block - 1) / block;
+	}
+
+	//Copies a texel rect between two row major images, block compressed rects start on a block
+	void CopyRect(TextureFormat format, const uint8_t* src, uint32_t srcWidth, uint32_t srcX, uint32_t srcY,
+		uint8_t* dst, uint32_t dstWidth, uint32_t dstX, uint32_t dstY, uint32_t width, uint32_t height)
+	{
+		const uint32_t block = BlockDimension(format);
+		const uint64_t srcPitch = RowPitch(format, srcWidth);
+		const uint64_t dstPitch = RowPitch(format, dstWidth);
+		const uint64_t rowBytes = RowPitch(format, width);
+		const uint32_t rows = RowCount(format, height);
+
+		src += (srcY / block) * srcPitch + RowPitch(format, srcX);
+		dst += (dstY / block) * dstPitch + RowPitch(format, dstX);
+		for (uint32_t row = 0; row < rows; ++row)
+		{
+			memcpy(dst + row * dstPitch, src + row * srcPitch, rowBytes);
+		}
+	}
+
+	//Tiles hold the rows of their rect, other chunks hold whole levels (with every array layer)
+	uint64_t ChunkSize(const TextureInfo& info, const TextureChunk& chunk)
+	{
+		const MipLevel& level = info.mips[chunk.firstMip];
+		if (chunk.mipCount > 1 || (chunk.width == level.width && chunk.height == level.height))
+		{
+			const MipLevel& last = info.mips[chunk.firstMip + chunk.mipCount - 1];
+			return last.offset + last.size - info.mips[chunk.firstMip].offset;
+		}
+		return RowPitch(info.textureFormat, chunk.width) * RowCount(info.textureFormat, chunk.height);
+	}
+
+	bool LoadChunk(const AssetFile& file, const TextureChunk& chunk, uint8_t* dst, uint64_t size)
+	{
+		std::vector<char> compressed(chunk.compressedSize);
+		if (!file.ReadBlobRange(chunk.offset, chunk.compressedSize, compressed.data()))
+			return false;
+
+		return LZ4_decompress_safe(compressed.data(), reinterpret_cast<char*>(dst), static_cast<int>(chunk.compressedSize), static_cast<int>(size)) == static_cast<int>(size);
+	}
+
+	//Decodes the chunks of levels [firstMip, endMip) in parallel into dst, which holds the levels from firstMip onwards
+	bool DecodeChunks(const AssetFile& file, const TextureInfo& info, uint32_t firstMip, uint32_t endMip, uint8_t* dst)
+	{
+		const uint64_t base = info.mips[firstMip].offset;
+
+		std::atomic<bool> success = true;
+		ThreadPool::Shared().ParallelFor(static_cast<uint32_t>(info.chunks.size()), [&](uint32_t i)
+			{
+				const TextureChunk& chunk = info.chunks[i];
+				if (chunk.firstMip < firstMip || chunk.firstMip >= endMip)
+					return;
+
+				const MipLevel& level = info.mips[chunk.firstMip];
+				uint8_t* levelData = dst + level.offset - base;
+
+				//chunks covering full rows decode in place
+				if (chunk.width == level.width)
+				{
+					levelData += RowCount(info.textureFormat, chunk.y) * RowPitch(info.textureFormat, level.width);
+					//only failures are stored, a later success must not overwrite another chunk's failure
+					if (!LoadChunk(file, chunk, levelData, ChunkSize(info, chunk)))
+						success = false;
+					return;
+				}
+
+				std::vector<uint8_t> tile(ChunkSize(info, chunk));
+				if (!LoadChunk(file, chunk, tile.data(), tile.size()))
+				{
+					success = false;
+					return;
+				}
+				CopyRect(info.textureFormat, tile.data(), chunk.width, 0, 0, levelData, level.width, chunk.x, chunk.y, chunk.width, chunk.height);
+			});
+
+		return success;
+	}
+}
+
 
 TextureInfo::TextureInfo() :
 	textureSize(0),
 	textureFormat(TextureFormat::Unknown),
-	pixelsize{0,0,0}
+	pixelsize{0,0,0},
+	residentMip(0)
 {
 
 }
@@ -22,6 +156,14 @@ TextureInfo::TextureInfo(const AssetFile& assetFile)
 TextureInfo Asset::ReadTextureInfo(const AssetFile& file)
 {
 	TextureInfo info;
+	if (!ReadTextureInfo(file, info))
+		info.data.clear();
+	return info;
+}
+
+bool Asset::ReadTextureInfo(const AssetFile& file, TextureInfo& info)
+{
+	info = TextureInfo();
 
 	nlohmann::json texture_metadata = nlohmann::json::parse(file.json);
 	
@@ -30,36 +172,277 @@ TextureInfo Asset::ReadTextureInfo(const AssetFile& file)
 
 	info.pixelsize[0] = texture_metadata["width"];
 	info.pixelsize[1] = texture_metadata["height"];
+	info.pixelsize[2] = texture_metadata.value("layers", 0u);
 	info.textureSize = texture_metadata["buffer_size"];
 	info.originalFile = texture_metadata["original_file"];
 
-	info.data.resize(file.binaryBlob.TotalBufferSize());
-	file.binaryBlob.CopyTo(info.data.data());
+	auto mips = texture_metadata.find("mips");
+	if (mips != texture_metadata.end())
+	{
+		for (const auto& mip : *mips)
+		{
+			info.mips.emplace_back(MipLevel{ mip["width"], mip["height"], mip["offset"], mip["size"] });
+		}
+	}
+	else
+	{
+		info.mips.emplace_back(MipLevel{ info.pixelsize[0], info.pixelsize[1], 0, static_cast<uint64_t>(info.textureSize) });
+	}
 
-	return info;
+	auto chunks = texture_metadata.find("chunks");
+	if (chunks == texture_metadata.end())
+	{
+		//not streamable, the whole blob is needed even when loading for streaming
+		AssetFile fullFile;
+		if (!file.blobLoaded && !fullFile.LoadBinaryFile(file.path))
+			return false;
+		const AssetFile& source = file.blobLoaded ? file : fullFile;
+
+		info.data.resize(source.binaryBlob.TotalBufferSize());
+		source.binaryBlob.CopyTo(info.data.data());
+		return true;
+	}
+
+	for (const auto& chunk : *chunks)
+	{
+		//chunks without a rect cover their whole first level
+		const MipLevel& level = info.mips[chunk["first_mip"].get<uint32_t>()];
+		info.chunks.emplace_back(TextureChunk{ chunk["first_mip"], chunk["mip_count"], chunk["offset"], chunk["compressed_size"],
+			chunk.value("x", 0u), chunk.value("y", 0u), chunk.value("tile_width", level.width), chunk.value("tile_height", level.height) });
+	}
+
+	info.streamSource.path = file.path;
+	info.streamSource.blobDataOffset = file.blobDataOffset;
+
+	//start with the mip tail, or everything if the blob is already in memory
+	const uint32_t firstMip = file.blobLoaded ? 0 : info.chunks.back().firstMip;
+	info.residentMip = firstMip;
+	info.data.resize(static_cast<uint64_t>(info.textureSize) - info.mips[firstMip].offset);
+
+	return DecodeChunks(file, info, firstMip, static_cast<uint32_t>(info.mips.size()), info.data.data());
 }
 
-AssetFile Asset::PackTexture(TextureInfo* info, void* pixelData)
+AssetFile Asset::PackTexture(TextureInfo* info, void* pixelData, bool streamable, uint32_t tileSize)
 {
 	nlohmann::json texture_metadata;
 	texture_metadata["format"] = magic_enum::enum_name(info->textureFormat);
 	texture_metadata["width"] = info->pixelsize[0];
 	texture_metadata["height"] = info->pixelsize[1];
+	if (info->pixelsize[2] > 1)
+		texture_metadata["layers"] = info->pixelsize[2];
 	texture_metadata["buffer_size"] = info->textureSize;
 	texture_metadata["original_file"] = info->originalFile;
 
+	if (info->mips.empty())
+	{
+		info->mips.emplace_back(MipLevel{ info->pixelsize[0], info->pixelsize[1], 0, static_cast<uint64_t>(info->textureSize) });
+	}
+
+	nlohmann::json mips = nlohmann::json::array();
+	for (const MipLevel& mip : info->mips)
+	{
+		mips.push_back({ {"width", mip.width}, {"height", mip.height}, {"offset", mip.offset}, {"size", mip.size} });
+	}
+	texture_metadata["mips"] = mips;
+
+	//large levels are split into tiles (one tile per level when not tiling), the mip tail is a single chunk
+	std::vector<char> chunkData;
+	if (streamable || tileSize > 0)
+	{
+		info->chunks.clear();
+
+		//array levels are never split
+		const uint32_t block = BlockDimension(info->textureFormat);
+		tileSize = info->pixelsize[2] > 1 ? 0 : (tileSize + block - 1) / block * block;
+
+		uint32_t level = 0;
+		while (level < info->mips.size())
+		{
+			const MipLevel& mip = info->mips[level];
+			if (mip.width <= MipTailSize && mip.height <= MipTailSize)
+			{
+				const uint32_t count = static_cast<uint32_t>(info->mips.size()) - level;
+				info->chunks.emplace_back(TextureChunk{ level, count, 0, 0, 0, 0, mip.width, mip.height });
+				break;
+			}
+
+			const uint32_t tileWidth = tileSize > 0 ? tileSize : mip.width;
+			const uint32_t tileHeight = tileSize > 0 ? tileSize : mip.height;
+			for (uint32_t y = 0; y < mip.height; y += tileHeight)
+			{
+				for (uint32_t x = 0; x < mip.width; x += tileWidth)
+				{
+					info->chunks.emplace_back(TextureChunk{ level, 1, 0, 0, x, y, std::min(tileWidth, mip.width - x), std::min(tileHeight, mip.height - y) });
+				}
+			}
+			level++;
+		}
+
+		//compress in parallel, then lay the chunks out in order
+		std::vector<std::vector<char>> compressedChunks(info->chunks.size());
+		ThreadPool::Shared().ParallelFor(static_cast<uint32_t>(info->chunks.size()), [&](uint32_t i)
+			{
+				const TextureChunk& chunk = info->chunks[i];
+				const MipLevel& mip = info->mips[chunk.firstMip];
+				const int size = static_cast<int>(ChunkSize(*info, chunk));
+
+				const char* source = static_cast<const char*>(pixelData) + mip.offset;
+				std::vector<uint8_t> tile;
+				if (chunk.mipCount == 1 && chunk.width != mip.width)
+				{
+					tile.resize(size);
+					CopyRect(info->textureFormat, reinterpret_cast<const uint8_t*>(source), mip.width, chunk.x, chunk.y, tile.data(), chunk.width, 0, 0, chunk.width, chunk.height);
+					source = reinterpret_cast<const char*>(tile.data());
+				}
+				else
+				{
+					source += RowCount(info->textureFormat, chunk.y) * RowPitch(info->textureFormat, mip.width);
+				}
+
+				std::vector<char>& compressed = compressedChunks[i];
+				compressed.resize(LZ4_compressBound(size));
+				compressed.resize(LZ4_compress_default(source, compressed.data(), size, LZ4_compressBound(size)));
+			});
+
+		nlohmann::json chunks = nlohmann::json::array();
+		for (size_t i = 0; i < info->chunks.size(); ++i)
+		{
+			TextureChunk& chunk = info->chunks[i];
+			chunk.offset = chunkData.size();
+			chunk.compressedSize = compressedChunks[i].size();
+			chunkData.insert(chunkData.end(), compressedChunks[i].begin(), compressedChunks[i].end());
+
+			chunks.push_back({ {"first_mip", chunk.firstMip}, {"mip_count", chunk.mipCount}, {"offset", chunk.offset}, {"compressed_size", chunk.compressedSize},
+				{"x", chunk.x}, {"y", chunk.y}, {"tile_width", chunk.width}, {"tile_height", chunk.height} });
+		}
+		texture_metadata["chunks"] = chunks;
+	}
+
 	//core file header
 	AssetFile file;
 	file.type[0] = 'T';
 	file.type[1] = 'E';
 	file.type[2] = 'X';
 	file.type[3] = 'I';
-	file.version = 1;
+	file.version = TextureFileVersion;
 
-	file.binaryBlob.CopyFrom(pixelData, info->textureSize, CompressionMode::LZ4);
+	//chunks are already compressed and need to stay addressable
+	if (!info->chunks.empty())
+		file.binaryBlob.CopyFrom(chunkData.data(), chunkData.size(), CompressionMode::None);
+	else
+		file.binaryBlob.CopyFrom(pixelData, info->textureSize, CompressionMode::LZ4);
+	file.blobLoaded = true; //chunks are read from memory until the file is saved and loaded again
 
 	std::string stringified = texture_metadata.dump();
 	file.json = stringified;
 
 	return file;
 }
+
+const uint8_t* TextureInfo::GetMipData(uint32_t level) const
+{
+	assert(level < mips.size()); // Mip level out of bounds
+	assert(level >= residentMip); // Mip level not resident
+	return data.data() + mips[level].offset - mips[residentMip].offset;
+}
+
+bool TextureInfo::IsStreamable() const
+{
+	return !chunks.empty();
+}
+
+bool TextureInfo::SetResidentMip(uint32_t level)
+{
+	if (chunks.empty() || data.empty())
+		return false;
+
+	//residency changes a whole level (or the whole tail) at a time
+	level = std::min(level, static_cast<uint32_t>(mips.size()) - 1);
+	for (const TextureChunk& chunk : chunks)
+	{
+		if (level < chunk.firstMip + chunk.mipCount)
+		{
+			level = chunk.firstMip;
+			break;
+		}
+	}
+
+	if (level == residentMip)
+		return false;
+
+	const uint64_t oldBase = mips[residentMip].offset;
+	const uint64_t newBase = mips[level].offset;
+
+	if (level > residentMip)
+	{
+		data.erase(data.begin(), data.begin() + (newBase - oldBase));
+		data.shrink_to_fit();
+	}
+	else
+	{
+		std::vector<uint8_t> newData(static_cast<uint64_t>(textureSize) - newBase);
+		if (!DecodeChunks(streamSource, *this, level, residentMip, newData.data()))
+			return false;
+
+		memcpy(newData.data() + oldBase - newBase, data.data(), data.size());
+		data = std::move(newData);
+	}
+
+	residentMip = level;
+	return true;
+}
+
+bool TextureInfo::ReadRegion(uint32_t level, uint32_t x, uint32_t y, uint32_t width, uint32_t height, uint8_t* dst) const
+{
+	assert(level < mips.size()); // Mip level out of bounds
+	const MipLevel& mip = mips[level];
+	assert(x + width <= mip.width && y + height <= mip.height); // Region out of bounds
+	assert(x % BlockDimension(textureFormat) == 0 && y % BlockDimension(textureFormat) == 0); // Block compressed regions start on a block
+
+	if (level >= residentMip && !data.empty())
+	{
+		CopyRect(textureFormat, GetMipData(level), mip.width, x, y, dst, width, 0, 0, width, height);
+		return true;
+	}
+
+	if (chunks.empty())
+		return false;
+
+	//only the chunks overlapping the region are decoded
+	std::vector<const TextureChunk*> overlapping;
+	for (const TextureChunk& chunk : chunks)
+	{
+		if (level < chunk.firstMip || level >= chunk.firstMip + chunk.mipCount)
+			continue;
+
+		if (chunk.mipCount > 1 || (chunk.x < x + width && x < chunk.x + chunk.width && chunk.y < y + height && y < chunk.y + chunk.height))
+			overlapping.push_back(&chunk);
+	}
+
+	std::atomic<bool> success = true;
+	ThreadPool::Shared().ParallelFor(static_cast<uint32_t>(overlapping.size()), [&](uint32_t i)
+		{
+			const TextureChunk& chunk = *overlapping[i];
+			std::vector<uint8_t> decoded(ChunkSize(*this, chunk));
+			if (!LoadChunk(streamSource, chunk, decoded.data(), decoded.size()))
+			{
+				success = false;
+				return;
+			}
+
+			//tail chunks hold whole levels
+			const uint8_t* source = decoded.data() + mip.offset - mips[chunk.firstMip].offset;
+			const uint32_t chunkX = chunk.mipCount > 1 ? 0 : chunk.x;
+			const uint32_t chunkY = chunk.mipCount > 1 ? 0 : chunk.y;
+			const uint32_t chunkWidth = chunk.mipCount > 1 ? mip.width : chunk.width;
+			const uint32_t chunkHeight = chunk.mipCount > 1 ? mip.height : chunk.height;
+
+			const uint32_t beginX = std::max(x, chunkX);
+			const uint32_t beginY = std::max(y, chunkY);
+			const uint32_t endX = std::min(x + width, chunkX + chunkWidth);
+			const uint32_t endY = std::min(y + height, chunkY + chunkHeight);
+			CopyRect(textureFormat, source, chunkWidth, beginX - chunkX, beginY - chunkY, dst, width, beginX - x, beginY - y, endX - beginX, endY - beginY);
+		});
+
+	return success;
+}
@@ -1,9 +1,12 @@
 #include "core/assetBuffer.h"
 #include "lz4.H"
+#include <cassert>
+#include "core/threadPool.h"
+#include "core/assetHash.h"
 
 using namespace Asset;
 
-Buffer::Buffer() : m_compressedBufferSize(0), m_totalBufferSize(0)
+Buffer::Buffer() : m_compressionMode(CompressionMode::None), m_compressedBufferSize(0), m_totalBufferSize(0)
 {
 
 }
@@ -30,6 +33,39 @@ void Buffer::CopyFrom(const void* src, size_t size, CompressionMode compressionM
 		m_compressedBufferSize = compressedSize;
 		break;
 	}
+	case CompressionMode::LZ4Chunked:
+	{
+		//chunk count and the compressed size of every chunk, followed by the chunks
+		const uint32_t chunkCount = static_cast<uint32_t>((size + LZ4ChunkSize - 1) / LZ4ChunkSize);
+		std::vector<std::vector<char>> chunks(chunkCount);
+		ThreadPool::Shared().ParallelFor(chunkCount, [&](uint32_t i)
+			{
+				const size_t offset = size_t(i) * LZ4ChunkSize;
+				const int chunkSize = static_cast<int>(std::min(LZ4ChunkSize, size - offset));
+				chunks[i].resize(LZ4_compressBound(chunkSize));
+				const int compressedSize = LZ4_compress_default((const char*)src + offset, chunks[i].data(), chunkSize, (int)chunks[i].size());
+				chunks[i].resize(compressedSize);
+			});
+
+		size_t tableSize = sizeof(uint32_t) * (size_t(chunkCount) + 1);
+		size_t compressedSize = tableSize;
+		for (const auto& chunk : chunks)
+			compressedSize += chunk.size();
+
+		m_buffer.resize(compressedSize);
+		memcpy(m_buffer.data(), &chunkCount, sizeof(chunkCount));
+
+		size_t offset = tableSize;
+		for (uint32_t i = 0; i < chunkCount; ++i)
+		{
+			const uint32_t chunkSize = static_cast<uint32_t>(chunks[i].size());
+			memcpy(m_buffer.data() + sizeof(uint32_t) * (size_t(i) + 1), &chunkSize, sizeof(chunkSize));
+			memcpy(m_buffer.data() + offset, chunks[i].data(), chunkSize);
+			offset += chunkSize;
+		}
+		m_compressedBufferSize = compressedSize;
+		break;
+	}
 	}
 }
 
@@ -47,14 +83,90 @@ void Buffer::CopyTo(void* dst) const
 		LZ4_decompress_safe((const char*)m_buffer.data(), (char*)dst, (int)m_compressedBufferSize, (int)m_totalBufferSize);
 		break;
 	}
+	case CompressionMode::LZ4Chunked:
+	{
+		uint32_t chunkCount;
+		memcpy(&chunkCount, m_buffer.data(), sizeof(chunkCount));
+
+		std::vector<size_t> chunkOffsets(chunkCount);
+		std::vector<uint32_t> chunkSizes(chunkCount);
+		size_t offset = sizeof(uint32_t) * (size_t(chunkCount) + 1);
+		for (uint32_t i = 0; i < chunkCount; ++i)
+		{
+			memcpy(&chunkSizes[i], m_buffer.data() + sizeof(uint32_t) * (size_t(i) + 1), sizeof(uint32_t));
+			chunkOffsets[i] = offset;
+			offset += chunkSizes[i];
+		}
+
+		ThreadPool::Shared().ParallelFor(chunkCount, [&](uint32_t i)
+			{
+				const size_t dstOffset = size_t(i) * LZ4ChunkSize;
+				const int chunkSize = static_cast<int>(std::min(LZ4ChunkSize, m_totalBufferSize - dstOffset));
+				LZ4_decompress_safe((const char*)m_buffer.data() + chunkOffsets[i], (char*)dst + dstOffset, (int)chunkSizes[i], chunkSize);
+			});
+		break;
+	}
 	}
 }
 
+void Buffer::CopyRangeTo(void* dst, size_t offset, size_t size) const
+{
+	assert(m_compressionMode == CompressionMode::None); // Ranges of compressed buffers can't be addressed
+	assert(offset + size <= m_buffer.size()); // Range out of bounds
+	memcpy(dst, m_buffer.data() + offset, size);
+}
+
+std::istream& Buffer::ReadHeader(std::istream& is)
+{
+	is.read(reinterpret_cast<char*>(&m_compressionMode), sizeof(m_compressionMode));
+	is.read(reinterpret_cast<char*>(&m_totalBufferSize), sizeof(m_totalBufferSize));
+	is.read(reinterpret_cast<char*>(&m_compressedBufferSize), sizeof(m_compressedBufferSize));
+	return is;
+}
+
+std::istream& Buffer::ReadData(std::istream& is)
+{
+	size_t bufferSize = m_compressionMode != CompressionMode::None ?
+		m_compressedBufferSize : m_totalBufferSize;
+
+	m_buffer.resize(bufferSize);
+	is.read(reinterpret_cast<char*>(m_buffer.data()), bufferSize);
+	return is;
+}
+
 std::size_t Buffer::TotalBufferSize() const
 {
 	return m_totalBufferSize;
 }
 
+size_t Buffer::SerializedSize() const
+{
+	return sizeof(m_compressionMode) + sizeof(m_totalBufferSize) + sizeof(m_compressedBufferSize) + m_buffer.size();
+}
+
+uint8_t* Buffer::Serialize(uint8_t* dst) const
+{
+	memcpy(dst, &m_compressionMode, sizeof(m_compressionMode));
+	dst += sizeof(m_compressionMode);
+	memcpy(dst, &m_totalBufferSize, sizeof(m_totalBufferSize));
+	dst += sizeof(m_totalBufferSize);
+	memcpy(dst, &m_compressedBufferSize, sizeof(m_compressedBufferSize));
+	dst += sizeof(m_compressedBufferSize);
+
+	if (!m_buffer.empty())
+		memcpy(dst, m_buffer.data(), m_buffer.size());
+	return dst + m_buffer.size();
+}
+
+uint64_t Buffer::Hash(uint64_t seed) const
+{
+	//fields one at a time, the padding between them is not part of the file
+	uint64_t hash = HashXXH64(&m_compressionMode, sizeof(m_compressionMode), seed);
+	hash = HashXXH64(&m_totalBufferSize, sizeof(m_totalBufferSize), hash);
+	hash = HashXXH64(&m_compressedBufferSize, sizeof(m_compressedBufferSize), hash);
+	return HashXXH64(m_buffer.data(), m_buffer.size(), hash);
+}
+
 namespace Asset
 {
 	std::ostream& operator<<(std::ostream& os, const Buffer& buffer)
@@ -70,16 +182,7 @@ namespace Asset
 
 	std::istream& operator>>(std::istream& is, Buffer& buffer)
 	{
-		is.read(reinterpret_cast<char*>(&buffer.m_compressionMode), sizeof(buffer.m_compressionMode));
-		is.read(reinterpret_cast<char*>(&buffer.m_totalBufferSize), sizeof(buffer.m_totalBufferSize));
-		is.read(reinterpret_cast<char*>(&buffer.m_compressedBufferSize), sizeof(buffer.m_compressedBufferSize));
-
-		size_t bufferSize = buffer.m_compressionMode != CompressionMode::None ?
-			buffer.m_compressedBufferSize : buffer.m_totalBufferSize;
-
-		buffer.m_buffer.resize(bufferSize);
-		is.read(reinterpret_cast<char*>(buffer.m_buffer.data()), bufferSize);
-
-		return is;
+		buffer.ReadHeader(is);
+		return buffer.ReadData(is);
 	}
 }
\ No newline at end of file
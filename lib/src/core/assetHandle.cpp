@@ -66,3 +66,8 @@ void AssetHandle::SetInvalid()
 	m_value = InvalidHandle.Value();
 }
 
+HandleChecksum Asset::FoldChecksum(uint64_t checksum)
+{
+	const HandleChecksum folded = static_cast<HandleChecksum>(checksum ^ (checksum >> 16) ^ (checksum >> 32) ^ (checksum >> 48));
+	return folded == std::numeric_limits<HandleChecksum>::max() ? 0 : folded;
+}
@@ -1,5 +1,8 @@
 #include "core/assetManager.h"
 #include <cassert>
+#include <fstream>
+#include <filesystem>
+#include "nlohmann/json.hpp"
 
 using namespace Asset;
 
@@ -44,6 +47,42 @@ void BaseAssetManager::Release(HandleIndex index)
 	m_free.push(index);
 }
 
+void BaseAssetManager::AddAlias(const std::string& alias, const std::string& uri)
+{
+	m_aliases[std::filesystem::path(alias).lexically_normal().generic_string()] = uri;
+}
+
+bool BaseAssetManager::LoadAliases(const std::string& manifestPath)
+{
+	std::ifstream file(manifestPath);
+	if (!file.is_open())
+		return false;
+
+	nlohmann::json manifest = nlohmann::json::parse(file, nullptr, false);
+	if (manifest.is_discarded())
+		return false;
+
+	auto aliases = manifest.find("aliases");
+	if (aliases == manifest.end())
+		return true;
+
+	for (auto& [alias, uri] : aliases->items())
+	{
+		AddAlias(alias, uri.get<std::string>());
+	}
+	return true;
+}
+
+std::string BaseAssetManager::ResolveAlias(const std::string& uri) const
+{
+	if (m_aliases.empty())
+		return uri;
+
+	//the converter writes aliases with normalized paths
+	auto alias = m_aliases.find(std::filesystem::path(uri).lexically_normal().generic_string());
+	return alias != m_aliases.end() ? alias->second : uri;
+}
+
 bool BaseAssetManager::UriExists(const std::string& uri) const
 {
 	return m_uriMap.find(uri) != m_uriMap.end();
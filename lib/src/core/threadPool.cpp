@@ -0,0 +1,134 @@
+#include "core/threadPool.h"
+#include <algorithm>
+
+using namespace Asset;
+
+namespace
+{
+	thread_local bool isPoolWorker = false;
+
+	ThreadPool::Executor sharedExecutor;
+}
+
+ThreadPool::ThreadPool(uint32_t workerCount, Executor executor) : m_executor(std::move(executor)), m_loop(nullptr), m_generation(0), m_stop(false)
+{
+	for (uint32_t i = 0; i < workerCount && !m_executor; ++i)
+	{
+		m_workers.emplace_back(&ThreadPool::Work, this);
+	}
+}
+
+ThreadPool::~ThreadPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_lock);
+		m_stop = true;
+	}
+	m_wake.notify_all();
+
+	for (std::thread& worker : m_workers)
+	{
+		worker.join();
+	}
+}
+
+void ThreadPool::ParallelFor(uint32_t count, const std::function<void(uint32_t)>& func)
+{
+	if (m_executor && count > 1)
+	{
+		m_executor(count, func);
+		return;
+	}
+
+	if (m_workers.empty() || isPoolWorker || count <= 1)
+	{
+		for (uint32_t i = 0; i < count; ++i)
+			func(i);
+		return;
+	}
+
+	//another thread has the workers, doing the loop here beats waiting for them
+	std::unique_lock<std::mutex> loopLock(m_loopLock, std::try_to_lock);
+	if (!loopLock.owns_lock())
+	{
+		for (uint32_t i = 0; i < count; ++i)
+			func(i);
+		return;
+	}
+
+	Loop loop;
+	loop.func = &func;
+	loop.count = count;
+	loop.next = 0;
+	loop.activeWorkers = 0;
+
+	{
+		std::lock_guard<std::mutex> lock(m_lock);
+		m_loop = &loop;
+		m_generation++;
+	}
+	m_wake.notify_all();
+
+	RunLoop(loop);
+
+	//workers that have not picked the loop up yet will see it is gone
+	std::unique_lock<std::mutex> lock(m_lock);
+	m_finished.wait(lock, [&loop]() { return loop.activeWorkers == 0; });
+	m_loop = nullptr;
+}
+
+uint32_t ThreadPool::GetWorkerCount() const
+{
+	return static_cast<uint32_t>(m_workers.size());
+}
+
+ThreadPool& ThreadPool::Shared()
+{
+	static ThreadPool pool(std::max(1u, std::thread::hardware_concurrency()) - 1, sharedExecutor);
+	return pool;
+}
+
+void ThreadPool::SetSharedExecutor(Executor executor)
+{
+	sharedExecutor = std::move(executor);
+}
+
+void ThreadPool::Work()
+{
+	isPoolWorker = true;
+
+	uint64_t generation = 0;
+	while (true)
+	{
+		Loop* loop;
+		{
+			std::unique_lock<std::mutex> lock(m_lock);
+			m_wake.wait(lock, [&]() { return m_stop || m_generation != generation; });
+			if (m_stop)
+				return;
+
+			generation = m_generation;
+			loop = m_loop;
+			if (!loop)
+				continue;
+
+			loop->activeWorkers++;
+		}
+
+		RunLoop(*loop);
+
+		{
+			std::lock_guard<std::mutex> lock(m_lock);
+			loop->activeWorkers--;
+		}
+		m_finished.notify_all();
+	}
+}
+
+void ThreadPool::RunLoop(Loop& loop)
+{
+	for (uint32_t i = loop.next++; i < loop.count; i = loop.next++)
+	{
+		(*loop.func)(i);
+	}
+}